@@ -15,6 +15,7 @@ include $(LOCAL_PATH)/$(CINDER_PATH)/blocks/new-chronotext-toolkit/android/Andro
 
 LOCAL_CFLAGS += -DCHR_COMPLEX
 #LOCAL_CFLAGS += -DDEBUG
+#LOCAL_CFLAGS += -DMEASURE_ALLOCATIONS
 LOCAL_CFLAGS += -ffast-math -O3
 
 LOCAL_LDLIBS := -llog -landroid
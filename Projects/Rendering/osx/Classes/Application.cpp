@@ -74,6 +74,11 @@ void Application::keyDown(KeyEvent event)
             
         case KeyEvent::KEY_x:
             cout << "TEXTURE MEMORY USAGE: " << prettyBytes(target->fontManager.getTextureMemoryUsage()) << endl;
+            cout << "TEXTURE OCCUPANCY: " << int(target->fontManager.getTextureOccupancy() * 100) << "%" << endl;
+            cout << "TEXTURE HITS / MISSES / EVICTIONS: "
+            << target->fontManager.textureStore.getHitCount() << " / "
+            << target->fontManager.textureStore.getMissCount() << " / "
+            << target->fontManager.textureStore.getEvictionCount() << endl;
             break;
             
         case KeyEvent::KEY_ESCAPE:
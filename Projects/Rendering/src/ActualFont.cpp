@@ -7,6 +7,7 @@
  */
 
 #include "ActualFont.h"
+#include "GlyphRasterizer.h"
 
 #include "chronotext/utils/Utils.h"
 
@@ -17,38 +18,154 @@ using namespace ci;
 using namespace chr;
 
 /*
- See http://www.microsoft.com/typography/otspec/name.htm for a list of some
- possible platform-encoding pairs.  We're interested in 0-3 aka 3-1 - UCS-2.
- Otherwise, fail. If a font has some unicode map, but lacks UCS-2 - it is a
- broken or irrelevant font. What exactly Freetype will select on face load
- (it promises most wide unicode, and if that will be slower that UCS-2 -
- left as an excercise to check.)
+ * THE FUNCTIONS OF ActualFont::hbFont: FORWARDED TO ITS PARENT (THE hb-ft FONT), WITH face->mutex LOCKED AND ftSize ACTIVATED
+ *
+ * I.E. THE FT_Face IS ONLY LOCKED DURING THE GLYPH-QUERIES: THE REST OF hb_shape() (OPENTYPE LAYOUT, ETC.)
+ * CAN RUN CONCURRENTLY FOR THE SAME FONT (SEE VirtualFont::createLineLayouts)
+ *
+ * EXCEPT FOR THE MOST FREQUENT QUERIES (GLYPH-LOOKUP AND HORIZONTAL ADVANCE): ANSWERED WITHOUT LOCKING,
+ * VIA THE OpenTypeTables OF THE FontFace, WHEN USABLE
  */
-static FT_Error force_ucs2_charmap(FT_Face face)
+struct LockedFontFuncs
 {
-    for (int i = 0; i < face->num_charmaps; i++)
+    static unique_lock<mutex> activate(void *fontData)
+    {
+        auto font = static_cast<ActualFont*>(fontData);
+        
+        unique_lock<mutex> lock(font->face->mutex);
+        FT_Activate_Size(font->ftSize);
+        
+        return lock;
+    }
+    
+    static hb_bool_t getGlyph(hb_font_t *font, void *fontData, hb_codepoint_t unicode, hb_codepoint_t variationSelector, hb_codepoint_t *glyph, void *userData)
     {
-        auto platform_id = face->charmaps[i]->platform_id;
-        auto encoding_id = face->charmaps[i]->encoding_id;
+        auto actualFont = static_cast<ActualFont*>(fontData);
         
-        if (((platform_id == 0) && (encoding_id == 3)) || ((platform_id == 3) && (encoding_id == 1)))
+        if (actualFont->openTypeCache && actualFont->useNativeFontFuncs)
         {
-            return FT_Set_Charmap(face, face->charmaps[i]);
+            return actualFont->face->getOpenTypeTables()->getGlyph(actualFont->openTypeCache.get(), unicode, glyph);
         }
+        
+        auto lock = activate(fontData);
+        return hb_font_get_glyph(hb_font_get_parent(font), unicode, variationSelector, glyph);
     }
     
-    return -1;
-}
+    static hb_position_t getGlyphHAdvance(hb_font_t *font, void *fontData, hb_codepoint_t glyph, void *userData)
+    {
+        auto actualFont = static_cast<ActualFont*>(fontData);
+        
+        if (actualFont->openTypeCache && actualFont->useNativeFontFuncs)
+        {
+            return actualFont->face->getOpenTypeTables()->getHAdvance(actualFont->openTypeCache.get(), glyph);
+        }
+        
+        auto lock = activate(fontData);
+        return hb_font_get_glyph_h_advance(hb_font_get_parent(font), glyph);
+    }
+    
+    static hb_position_t getGlyphVAdvance(hb_font_t *font, void *fontData, hb_codepoint_t glyph, void *userData)
+    {
+        auto lock = activate(fontData);
+        return hb_font_get_glyph_v_advance(hb_font_get_parent(font), glyph);
+    }
+    
+    static hb_bool_t getGlyphHOrigin(hb_font_t *font, void *fontData, hb_codepoint_t glyph, hb_position_t *x, hb_position_t *y, void *userData)
+    {
+        auto lock = activate(fontData);
+        return hb_font_get_glyph_h_origin(hb_font_get_parent(font), glyph, x, y);
+    }
+    
+    static hb_bool_t getGlyphVOrigin(hb_font_t *font, void *fontData, hb_codepoint_t glyph, hb_position_t *x, hb_position_t *y, void *userData)
+    {
+        auto lock = activate(fontData);
+        return hb_font_get_glyph_v_origin(hb_font_get_parent(font), glyph, x, y);
+    }
+    
+    static hb_position_t getGlyphHKerning(hb_font_t *font, void *fontData, hb_codepoint_t firstGlyph, hb_codepoint_t secondGlyph, void *userData)
+    {
+        auto lock = activate(fontData);
+        return hb_font_get_glyph_h_kerning(hb_font_get_parent(font), firstGlyph, secondGlyph);
+    }
+    
+    static hb_position_t getGlyphVKerning(hb_font_t *font, void *fontData, hb_codepoint_t topGlyph, hb_codepoint_t bottomGlyph, void *userData)
+    {
+        auto lock = activate(fontData);
+        return hb_font_get_glyph_v_kerning(hb_font_get_parent(font), topGlyph, bottomGlyph);
+    }
+    
+    static hb_bool_t getGlyphExtents(hb_font_t *font, void *fontData, hb_codepoint_t glyph, hb_glyph_extents_t *extents, void *userData)
+    {
+        auto lock = activate(fontData);
+        return hb_font_get_glyph_extents(hb_font_get_parent(font), glyph, extents);
+    }
+    
+    static hb_bool_t getGlyphContourPoint(hb_font_t *font, void *fontData, hb_codepoint_t glyph, unsigned int pointIndex, hb_position_t *x, hb_position_t *y, void *userData)
+    {
+        auto lock = activate(fontData);
+        return hb_font_get_glyph_contour_point(hb_font_get_parent(font), glyph, pointIndex, x, y);
+    }
+    
+    static hb_bool_t getGlyphName(hb_font_t *font, void *fontData, hb_codepoint_t glyph, char *name, unsigned int size, void *userData)
+    {
+        auto lock = activate(fontData);
+        return hb_font_get_glyph_name(hb_font_get_parent(font), glyph, name, size);
+    }
+    
+    static hb_bool_t getGlyphFromName(hb_font_t *font, void *fontData, const char *name, int length, hb_codepoint_t *glyph, void *userData)
+    {
+        auto lock = activate(fontData);
+        return hb_font_get_glyph_from_name(hb_font_get_parent(font), name, length, glyph);
+    }
+    
+    /*
+     * CREATED ONCE, AND NEVER DESTROYED
+     */
+    static hb_font_funcs_t* get()
+    {
+        static hb_font_funcs_t *funcs = create();
+        return funcs;
+    }
+    
+    static hb_font_funcs_t* create()
+    {
+        auto funcs = hb_font_funcs_create();
+        
+        hb_font_funcs_set_glyph_func(funcs, getGlyph, NULL, NULL);
+        hb_font_funcs_set_glyph_h_advance_func(funcs, getGlyphHAdvance, NULL, NULL);
+        hb_font_funcs_set_glyph_v_advance_func(funcs, getGlyphVAdvance, NULL, NULL);
+        hb_font_funcs_set_glyph_h_origin_func(funcs, getGlyphHOrigin, NULL, NULL);
+        hb_font_funcs_set_glyph_v_origin_func(funcs, getGlyphVOrigin, NULL, NULL);
+        hb_font_funcs_set_glyph_h_kerning_func(funcs, getGlyphHKerning, NULL, NULL);
+        hb_font_funcs_set_glyph_v_kerning_func(funcs, getGlyphVKerning, NULL, NULL);
+        hb_font_funcs_set_glyph_extents_func(funcs, getGlyphExtents, NULL, NULL);
+        hb_font_funcs_set_glyph_contour_point_func(funcs, getGlyphContourPoint, NULL, NULL);
+        hb_font_funcs_set_glyph_name_func(funcs, getGlyphName, NULL, NULL);
+        hb_font_funcs_set_glyph_from_name_func(funcs, getGlyphFromName, NULL, NULL);
+        
+        hb_font_funcs_make_immutable(funcs);
+        return funcs;
+    }
+};
 
-ActualFont::ActualFont(shared_ptr<FreetypeHelper> ftHelper, const Descriptor &descriptor, float baseSize, bool useMipmap)
+ActualFont::ActualFont(FontFace *face, const Descriptor &descriptor, float baseSize, bool useMipmap, bool useDistanceField, const FontIndex::Entry *indexEntry)
 :
-ftHelper(ftHelper),
+face(face),
+indexEntry(indexEntry),
 descriptor(descriptor),
 baseSize(baseSize * descriptor.scale),
 useMipmap(useMipmap),
+useDistanceField(useDistanceField),
 loaded(false),
 ftFace(NULL),
-hbFont(NULL)
+ftSize(NULL),
+hbFont(NULL),
+useNativeFontFuncs(true),
+simpleShaperLanguageCount(0),
+atlas(useMipmap),
+rasterizer(NULL),
+textureStore(NULL),
+diskCacheMaxFileSize(0)
 {
     /*
      * PADDING IS NECESSARY IN ORDER TO AVOID BORDER ARTIFACTS
@@ -65,7 +182,38 @@ hbFont(NULL)
         padding = 1; // THE MINIMUM POSSIBLE
     }
     
-    reload();
+    if (indexEntry)
+    {
+        /*
+         * THE SAME VALUES AS IN reload(), INCLUDING THE ROUNDING TAKING PLACE IN FREETYPE:
+         * - THE SCALED SIZE (FT_Set_Char_Size() WITH THE RESOLUTION USED IN reload()) IS A MULTIPLE OF 64, I.E. AN INTEGER PPEM
+         * - THE SIZE-METRICS ARE GRID-FITTED (CEILING FOR THE ASCENDER, FLOOR FOR THE DESCENDER AND ROUNDING FOR THE HEIGHT)
+         */
+        FT_F26Dot6 charSize = this->baseSize * 64;
+        FT_Long scaledSize = (charSize * 72 * 64 + 36) / 72;
+        FT_Fixed yScale = FT_DivFix(scaledSize, indexEntry->unitsPerEM);
+        float unitScale = 1.0f / 64 / 64;
+        
+        metrics.height = ((FT_MulFix(indexEntry->height, yScale) + 32) & -64) * unitScale;
+        metrics.ascent = ((FT_MulFix(indexEntry->ascender, yScale) + 63) & -64) * unitScale;
+        metrics.descent = -(FT_MulFix(indexEntry->descender, yScale) & -64) * unitScale;
+        
+        metrics.lineThickness = indexEntry->underlineThickness / 64.0f;
+        metrics.underlineOffset = -indexEntry->underlinePosition / 64.0f;
+        
+        if (indexEntry->hasStrikeoutPosition)
+        {
+            metrics.strikethroughOffset = FT_MulFix(indexEntry->strikeoutPosition, yScale) * unitScale;
+        }
+        else
+        {
+            metrics.strikethroughOffset = 0.5f * (metrics.ascent - metrics.descent);
+        }
+    }
+    else
+    {
+        reload();
+    }
 }
 
 ActualFont::~ActualFont()
@@ -77,28 +225,26 @@ void ActualFont::reload()
 {
     if (!loaded)
     {
-        FT_Error error;
+        /*
+         * DOUBLE-CHECKED: THE FONT MAY HAVE BEEN LOADED MEANWHILE BY ANOTHER THREAD
+         */
+        lock_guard<mutex> reloadLock(reloadMutex);
         
-        if (descriptor.forceMemoryLoad || !descriptor.source->isFile())
+        if (loaded)
         {
-            memoryBuffer = descriptor.source->loadDataSource()->getBuffer();
-            error = FT_New_Memory_Face(ftHelper->getLib(), (FT_Byte*)memoryBuffer.getData(), memoryBuffer.getDataSize(), descriptor.faceIndex, &ftFace);
-        }
-        else
-        {
-            error = FT_New_Face(ftHelper->getLib(), descriptor.source->getFilePath().c_str(), descriptor.faceIndex, &ftFace);
+            return;
         }
         
-        if (error)
-        {
-            throw runtime_error("FREETYPE: ERROR " + toString(error));
-        }
+        face->acquire(); // CAN THROW
+        ftFace = face->getFtFace();
         
-        if (force_ucs2_charmap(ftFace))
-        {
-            FT_Done_Face(ftFace); ftFace = NULL;
-            throw runtime_error("HARFBUZZ: FONT IS BROKEN OR IRRELEVANT");
-        }
+        /*
+         * THE FT_Face IS SHARED WITH THE OTHER SIZES OF THE SAME FONT-FILE (AND POSSIBLY USED BY THE WORKERS OF rasterizer)
+         */
+        lock_guard<mutex> lock(face->mutex);
+        
+        FT_New_Size(ftFace, &ftSize);
+        FT_Activate_Size(ftSize);
         
         // ---
         
@@ -127,8 +273,21 @@ void ActualFont::reload()
         
         /*
          * THIS MUST TAKE PLACE AFTER ftFace IS PROPERLY SCALED AND TRANSFORMED
+         * THE hb_face_t (I.E. THE SHAPE-PLANS AND THE OPENTYPE LAYOUT-TABLES) IS SHARED WITH THE OTHER SIZES
          */
-        hbFont = hb_ft_font_create(ftFace, NULL);
+        auto ftFont = hb_ft_font_create_for_face(face->getHbFace(), ftFace);
+        hbFont = hb_font_create_sub_font(ftFont);
+        hb_font_destroy(ftFont); // REFERENCED BY hbFont
+        
+        hb_font_set_funcs(hbFont, LockedFontFuncs::get(), this, NULL);
+        hb_font_make_immutable(hbFont);
+        
+        auto openTypeTables = face->getOpenTypeTables();
+        
+        if (openTypeTables->isUsable())
+        {
+            openTypeCache = openTypeTables->createCache(ftSize->metrics.x_scale);
+        }
         
         // ---
         
@@ -154,8 +313,14 @@ void ActualFont::reload()
         
         // ---
         
+        glyphPages.resize((ftFace->num_glyphs + GLYPH_PAGE_SIZE - 1) >> GLYPH_PAGE_SHIFT);
+        
+        // ---
+        
         loaded = true;
         LOGD << "LOADING ActualFont: " << getFullName() << " " << baseSize << endl;
+        
+        openDiskCache();
     }
 }
 
@@ -166,16 +331,27 @@ void ActualFont::unload()
         loaded = false;
         LOGD << "UNLOADING ActualFont: " << getFullName() << " " << baseSize << endl;
 
-        glyphCache.clear();
+        if (rasterizer)
+        {
+            rasterizer->cancel(this);
+        }
+        
+        pendingGlyphs.clear();
+        diskCache.close();
+        glyphPages.clear();
+        atlas.clear();
         standaloneTextures.clear();
         
-        if (descriptor.forceMemoryLoad)
+        hb_font_destroy(hbFont); hbFont = NULL;
+        openTypeCache.reset();
+        
         {
-            memoryBuffer.reset();
+            lock_guard<mutex> lock(face->mutex);
+            FT_Done_Size(ftSize); ftSize = NULL;
         }
-
-        hb_font_destroy(hbFont); hbFont = NULL;
-        FT_Done_Face(ftFace); ftFace = NULL;
+        
+        ftFace = NULL;
+        face->release(); // THE FT_Face AND THE hb_face_t ARE DESTROYED WITH THE LAST SIZE
     }
 }
 
@@ -185,15 +361,27 @@ void ActualFont::unload()
  */
 void ActualFont::discardTextures()
 {
+    atlas.discardTextures();
+    
     for (auto &texture : standaloneTextures)
     {
         texture->unload();
     }
 }
 
+void ActualFont::getTextures(vector<ReloadableTexture*> &textures) const
+{
+    atlas.getTextures(textures);
+    
+    for (auto &texture : standaloneTextures)
+    {
+        textures.push_back(texture.get());
+    }
+}
+
 size_t ActualFont::getTextureMemoryUsage() const
 {
-    size_t total = 0;
+    size_t total = atlas.getMemoryUsage();
     
     for (auto &texture : standaloneTextures)
     {
@@ -203,72 +391,270 @@ size_t ActualFont::getTextureMemoryUsage() const
     return total;
 }
 
-ActualFont::Glyph* ActualFont::getGlyph(uint32_t codepoint)
+/*
+ * THE "SLOW-PATH" OF getGlyph()
+ */
+ActualFont::Glyph* ActualFont::loadGlyph(uint32_t codepoint)
 {
-    Glyph *glyph = NULL;
-    
     reload();
     
     if (loaded)
     {
-        auto entry = glyphCache.find(codepoint);
+        size_t pageIndex = codepoint >> GLYPH_PAGE_SHIFT;
+        size_t index = codepoint & (GLYPH_PAGE_SIZE - 1);
         
-        if (entry == glyphCache.end())
+        if ((pageIndex < glyphPages.size()) && glyphPages[pageIndex] && glyphPages[pageIndex]->defined[index])
         {
-            glyph = createGlyph(codepoint);
+            auto glyph = &glyphPages[pageIndex]->glyphs[index];
             
-            if (glyph)
-            {
-                glyphCache[codepoint] = unique_ptr<Glyph>(glyph);
-            }
-            else
+            if (glyph->texture)
             {
+                bool hit = glyph->texture->isLoaded();
+                
                 /*
-                 * INSERTING A VALUE FOR TEXTURELESS GLYPHS (E.G. A "SPACE")
-                 * IS NECESSARY, OTHERWISE createGlyph() WOULD BE INVOKED
-                 * INDEFINITELY FOR THE SAME CODEPOINT
+                 * IN CASE A PREVIOUSLY-LOADED TEXTURE HAVE BEEN DISCARDED,
+                 * E.G. AFTER SOME OPENGL CONTEXT-LOSS OR BY THE TextureStore
                  */
-                glyphCache[codepoint] = unique_ptr<Glyph>(new Glyph());
+                if (!hit)
+                {
+                    if (atlas.contains(glyph->texture))
+                    {
+                        atlas.reload(glyph->texture);
+                    }
+                    else
+                    {
+                        unique_ptr<GlyphData> glyphData(rasterize(codepoint));
+                        
+                        if (glyphData->isValid())
+                        {
+                            glyph->texture->load(*glyphData);
+                        }
+                    }
+                }
+                
+                textureStore->touch(glyph->texture, hit);
             }
+            
+            return glyph;
         }
-        else
+        
+        if (rasterizer)
         {
-            glyph = entry->second.get();
-            
             /*
-             * IN CASE A PREVIOUSLY-LOADED TEXTURE HAVE BEEN
-             * DISCARDED, E.G. AFTER SOME OPENGL CONTEXT-LOSS
+             * THE GLYPH WILL BE SKIPPED UNTIL GlyphRasterizer::upload() CALLS addGlyph()
              */
-            if (glyph->texture && !glyph->texture->isLoaded())
+            if (pendingGlyphs.insert(codepoint).second)
             {
-                GlyphData glyphData(ftFace, codepoint, useMipmap, padding);
-                
-                if (glyphData.isValid())
-                {
-                    glyph->texture->load(glyphData);
-                }
+                rasterizer->request(this, codepoint);
             }
+            
+            return NULL;
+        }
+        
+        /*
+         * TEXTURELESS GLYPHS (E.G. A "SPACE") ARE DEFINED AS WELL,
+         * OTHERWISE createGlyph() WOULD BE INVOKED INDEFINITELY FOR THE SAME CODEPOINT
+         */
+        unique_ptr<GlyphData> glyphData(rasterize(codepoint));
+        auto glyph = defineGlyph(codepoint, createGlyph(*glyphData));
+        
+        if (glyph->texture)
+        {
+            textureStore->touch(glyph->texture, false);
         }
+        
+        return glyph;
     }
     
-    return glyph;
+    return NULL;
 }
 
-ActualFont::Glyph* ActualFont::createGlyph(uint32_t codepoint)
+ActualFont::Glyph* ActualFont::defineGlyph(uint32_t codepoint, const Glyph &glyph)
 {
-    GlyphData glyphData(ftFace, codepoint, useMipmap, padding);
+    size_t pageIndex = codepoint >> GLYPH_PAGE_SHIFT;
+    size_t index = codepoint & (GLYPH_PAGE_SIZE - 1);
+    
+    if (pageIndex >= glyphPages.size())
+    {
+        glyphPages.resize(pageIndex + 1); // NOT SUPPOSED TO HAPPEN, SINCE glyphPages IS SIZED AFTER THE NUMBER OF GLYPHS IN THE FONT
+    }
+    
+    if (!glyphPages[pageIndex])
+    {
+        glyphPages[pageIndex] = unique_ptr<GlyphPage>(new GlyphPage);
+    }
+    
+    auto &page = *glyphPages[pageIndex];
+    page.glyphs[index] = glyph;
+    page.defined.set(index);
     
+    return &page.glyphs[index];
+}
+
+/*
+ * RETURNS A TEXTURELESS Glyph IF glyphData IS NOT VALID
+ */
+ActualFont::Glyph ActualFont::createGlyph(const GlyphData &glyphData)
+{
     if (glyphData.isValid())
     {
+        auto location = atlas.add(glyphData);
+        
+        if (location.texture)
+        {
+            return Glyph(location, glyphData.offset, glyphData.size);
+        }
+        
         auto texture = new ReloadableTexture(glyphData);
         standaloneTextures.push_back(unique_ptr<ReloadableTexture>(texture));
         
-        return new Glyph(texture, glyphData.offset, glyphData.size);
+        return Glyph(texture, glyphData);
     }
     
+    return Glyph();
+}
+
+GlyphData* ActualFont::rasterize(uint32_t codepoint)
+{
+    auto glyphData = diskCache.load(codepoint, useMipmap, padding, useDistanceField);
+    
+    if (!glyphData)
+    {
+        {
+            lock_guard<mutex> lock(face->mutex);
+            FT_Activate_Size(ftSize);
+            
+            glyphData = new GlyphData(ftFace, codepoint, useMipmap, padding, useDistanceField);
+            glyphData->copyDataAndReleaseSlot();
+        }
+        
+        diskCache.store(codepoint, *glyphData);
+    }
+    
+    return glyphData;
+}
+
+/*
+ * NO-OP IF NO diskCacheDirectory IS DEFINED, OR IF THE FONT IS NOT LOADED
+ */
+void ActualFont::openDiskCache()
+{
+    if (loaded && !diskCacheDirectory.empty())
+    {
+        /*
+         * THE FILE-NAME IS BASED ON THE Key
+         */
+        auto name = descriptor.source->getURI() + " " + toString(descriptor.faceIndex) + " " + toString(baseSize) + " " + toString(useMipmap) + " " + toString(useDistanceField);
+        auto fileHash = GlyphDiskCache::hash(name.data(), name.size());
+        
+        char fileName[32];
+        snprintf(fileName, sizeof(fileName), "%016llx.glyphs", (unsigned long long)fileHash);
+        
+        /*
+         * THE SIGNATURE IS INVALIDATING THE FILE WHENEVER THE FONT OR THE RASTERIZATION PARAMETERS ARE CHANGING
+         * THE FONT'S CHECKSUM IS TAKEN FROM THE head TABLE (checkSumAdjustment), I.E. THE FONT-FILE IS NOT READ
+         */
+        uint32_t values[8] = {0};
+        auto head = (TT_Header*)FT_Get_Sfnt_Table(ftFace, ft_sfnt_head);
+        
+        if (head)
+        {
+            values[0] = head->CheckSum_Adjust;
+        }
+        
+        values[1] = ftFace->num_glyphs;
+        values[2] = padding;
+        values[3] = GlyphData::DISTANCE_FIELD_DOWNSAMPLE;
+        values[4] = GlyphData::DISTANCE_FIELD_SPREAD;
+        
+        FT_Int major, minor, patch;
+        FT_Library_Version(face->getLib(), &major, &minor, &patch);
+        values[5] = (major << 16) | (minor << 8) | patch;
+        
+        auto signature = GlyphDiskCache::hash(values, sizeof(values), fileHash);
+        diskCache.open(diskCacheDirectory / fileName, signature, diskCacheMaxFileSize);
+    }
+}
+
+bool ActualFont::addGlyph(uint32_t codepoint, const GlyphData &glyphData)
+{
+    pendingGlyphs.erase(codepoint);
+    
+    auto glyph = defineGlyph(codepoint, createGlyph(glyphData));
+    
+    if (glyph->texture)
+    {
+        textureStore->touch(glyph->texture, false);
+        return true;
+    }
+    
+    return false;
+}
+
+/*
+ * hb_language_t IS AN INTERNED POINTER: THE LOOKUP IS A FEW POINTER-COMPARISONS
+ */
+const SimpleShaper* ActualFont::findSimpleShaper(hb_language_t language, int count, bool &found) const
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (simpleShaperLanguages[i].first == language)
+        {
+            found = true;
+            return simpleShaperLanguages[i].second;
+        }
+    }
+    
+    found = false;
     return NULL;
 }
 
+const SimpleShaper* ActualFont::getSimpleShaper(hb_language_t language)
+{
+    bool found;
+    auto shaper = findSimpleShaper(language, simpleShaperLanguageCount.load(memory_order_acquire), found);
+    
+    if (found)
+    {
+        return shaper;
+    }
+    
+    lock_guard<mutex> lock(simpleShaperMutex);
+    
+    /*
+     * THE SHAPER MAY HAVE BEEN PUBLISHED BY ANOTHER THREAD IN THE MEANTIME
+     */
+    int count = simpleShaperLanguageCount.load(memory_order_relaxed);
+    shaper = findSimpleShaper(language, count, found);
+    
+    if (found)
+    {
+        return shaper;
+    }
+    
+    auto key = SimpleShaper::getKey(hb_font_get_face(hbFont), language);
+    auto it = simpleShapers.find(key);
+    
+    if (it == simpleShapers.end())
+    {
+        it = simpleShapers.emplace(key, unique_ptr<SimpleShaper>(new SimpleShaper(hbFont, language))).first;
+        LOGD << "SimpleShaper CREATED FOR " << getFullName() << " " << baseSize << ": " << (it->second->isUsable() ? "USABLE" : "NOT USABLE") << endl;
+    }
+    
+    shaper = it->second->isUsable() ? it->second.get() : NULL;
+    
+    /*
+     * BEYOND MAX_SIMPLE_SHAPER_LANGUAGES: THE SHAPER IS STILL FOUND IN simpleShapers, BUT UNDER LOCK
+     */
+    if (count < MAX_SIMPLE_SHAPER_LANGUAGES)
+    {
+        simpleShaperLanguages[count] = make_pair(language, shaper);
+        simpleShaperLanguageCount.store(count + 1, memory_order_release);
+    }
+    
+    return shaper;
+}
+
 string ActualFont::getFullName() const
 {
     if (ftFace)
@@ -9,13 +9,25 @@
 #pragma once
 
 #include "GlyphData.h"
-#include "ReloadableTexture.h"
+#include "GlyphAtlas.h"
+#include "GlyphDiskCache.h"
+#include "TextureStore.h"
+#include "FontFace.h"
+#include "FontIndex.h"
+#include "SimpleShaper.h"
 
 #include "chronotext/InputSource.h"
 
+#include "cinder/Thread.h"
+
 #include "hb.h"
 
+#include <set>
 #include <map>
+#include <bitset>
+#include <atomic>
+
+class GlyphRasterizer;
 
 class ActualFont
 {
@@ -25,17 +37,18 @@ public:
         chr::InputSourceRef source;
         int faceIndex;
         float scale;
-        bool forceMemoryLoad;
         
         Descriptor()
         {}
         
-        Descriptor(chr::InputSourceRef source, int faceIndex = 0, float scale = 1, bool forceMemoryLoad = false)
+        /*
+         * NOTE: THE FONT-DATA IS ALWAYS ACCESSED IN MEMORY (SEE FontFace)
+         */
+        Descriptor(chr::InputSourceRef source, int faceIndex = 0, float scale = 1)
         :
         source(source),
         faceIndex(faceIndex),
-        scale(scale),
-        forceMemoryLoad(forceMemoryLoad)
+        scale(scale)
         {}
         
         bool empty()
@@ -50,18 +63,20 @@ public:
         int faceIndex;
         float baseSize;
         bool useMipmap;
+        bool useDistanceField;
         
-        Key(const Descriptor &descriptor, float baseSize, bool useMipmap)
+        Key(const Descriptor &descriptor, float baseSize, bool useMipmap, bool useDistanceField)
         :
         uri(descriptor.source->getURI()),
         faceIndex(descriptor.faceIndex),
         baseSize(baseSize * descriptor.scale),
-        useMipmap(useMipmap)
+        useMipmap(useMipmap),
+        useDistanceField(useDistanceField)
         {}
         
         bool operator<(const Key &rhs) const
         {
-            return tie(uri, faceIndex, baseSize, useMipmap) < tie(rhs.uri, rhs.faceIndex, rhs.baseSize, rhs.useMipmap);
+            return tie(uri, faceIndex, baseSize, useMipmap, useDistanceField) < tie(rhs.uri, rhs.faceIndex, rhs.baseSize, rhs.useMipmap, rhs.useDistanceField);
         }
     };
 
@@ -81,17 +96,28 @@ public:
         texture(NULL)
         {}
         
-        Glyph(ReloadableTexture *texture, ci::Vec2f offset, ci::Vec2f size)
+        Glyph(ReloadableTexture *texture, const GlyphData &glyphData)
         :
         texture(texture),
-        offset(offset),
-        size(size)
+        offset(glyphData.offset),
+        size(glyphData.size)
         {
             u1 = 0;
             v1 = 0;
-            u2 = size.x / texture->getWidth();
-            v2 = size.y / texture->getHeight();
+            u2 = (glyphData.width + glyphData.padding * 2) / float(texture->getWidth());
+            v2 = (glyphData.height + glyphData.padding * 2) / float(texture->getHeight());
         }
+        
+        Glyph(const GlyphAtlas::Location &location, ci::Vec2f offset, ci::Vec2f size)
+        :
+        texture(location.texture),
+        offset(offset),
+        size(size),
+        u1(location.u1),
+        v1(location.v1),
+        u2(location.u2),
+        v2(location.v2)
+        {}
     };
     
     struct Metrics
@@ -119,36 +145,142 @@ public:
     ~ActualFont(); // MUST BE PUBLIC BECAUSE OF unique_ptr
 
 protected:
-    std::shared_ptr<FreetypeHelper> ftHelper;
+    FontFace *face; // SHARED WITH THE OTHER SIZES OF THE SAME FONT-FILE, OWNED BY FontManager
+    const FontIndex::Entry *indexEntry; // NULL WHEN NO FontIndex IS USED
 
     Descriptor descriptor;
     float baseSize;
     bool useMipmap;
+    bool useDistanceField;
     int padding;
 
     ci::Vec2f scale;
     Metrics metrics;
-    bool loaded;
+    
+    /*
+     * reload() CAN BE INVOKED CONCURRENTLY BY THE WORKERS OF VirtualFont::createLineLayouts()
+     * loaded IS ONLY SET ONCE ALL THE MEMBERS REQUIRED FOR SHAPING ARE READY
+     */
+    std::atomic<bool> loaded;
+    std::mutex reloadMutex;
 
-    ci::Buffer memoryBuffer;
-    FT_Face ftFace;
-    hb_font_t *hbFont;
+    FT_Face ftFace; // THE FT_Face OF face, NULL WHEN NOT LOADED
+    FT_Size ftSize; // MUST BE ACTIVATED (WITH face->mutex LOCKED) BEFORE USING ftFace
+    hb_font_t *hbFont; // THREAD-SAFE: LOCKING face->mutex AND ACTIVATING ftSize BY ITSELF (SEE LockedFontFuncs)
+    
+    /*
+     * THE GLYPH-LOOKUPS AND HORIZONTAL ADVANCES OF hbFont ARE QUERIED WITHOUT LOCKING, VIA THE OpenTypeTables OF face
+     * NULL WHEN NOT LOADED, OR IF THE OpenTypeTables ARE NOT USABLE (I.E. FALLING BACK TO FREETYPE)
+     */
+    OpenTypeTables::CacheRef openTypeCache;
+    bool useNativeFontFuncs; // TRUE BY DEFAULT (SEE Measurement::nativeFontFuncs)
+    
+    /*
+     * CREATED ON DEMAND (SEE getSimpleShaper) AND KEPT ACROSS unload()
+     *
+     * THE SHAPER OF EACH LANGUAGE IS RESOLVED ONCE, AND PUBLISHED IN simpleShaperLanguages:
+     * THE ENTRIES BELOW simpleShaperLanguageCount ARE NEVER MODIFIED, I.E. THEY ARE READ WITHOUT LOCKING
+     * simpleShaperMutex IS ONLY LOCKED UPON CREATION
+     */
+    static const int MAX_SIMPLE_SHAPER_LANGUAGES = 16;
+    
+    std::map<uint32_t, std::unique_ptr<SimpleShaper>> simpleShapers; // PER SimpleShaper::getKey()
+    std::pair<hb_language_t, const SimpleShaper*> simpleShaperLanguages[MAX_SIMPLE_SHAPER_LANGUAGES]; // NULL FOR THE LANGUAGES WITHOUT FAST-PATH
+    std::atomic<int> simpleShaperLanguageCount;
+    std::mutex simpleShaperMutex;
     
-    std::map<uint32_t, std::unique_ptr<Glyph>> glyphCache;
-    std::vector<std::unique_ptr<ReloadableTexture>> standaloneTextures;
+    /*
+     * GLYPHS ARE INDEXED BY GLYPH-ID (I.E. THE "CODEPOINT" RETURNED BY HARFBUZZ)
+     * WITHIN PAGES OF GLYPH_PAGE_SIZE CONTIGUOUS RECORDS, ALLOCATED ON DEMAND
+     */
+    static const int GLYPH_PAGE_SHIFT = 8;
+    static const int GLYPH_PAGE_SIZE = 1 << GLYPH_PAGE_SHIFT;
+    
+    struct GlyphPage
+    {
+        Glyph glyphs[GLYPH_PAGE_SIZE];
+        std::bitset<GLYPH_PAGE_SIZE> defined;
+    };
+    
+    std::vector<std::unique_ptr<GlyphPage>> glyphPages; // SIZED AFTER THE NUMBER OF GLYPHS IN THE FONT UPON reload()
+    GlyphAtlas atlas;
+    std::vector<std::unique_ptr<ReloadableTexture>> standaloneTextures; // FOR GLYPHS WHICH CAN'T FIT IN THE ATLAS
+    
+    GlyphRasterizer *rasterizer; // NULL WHEN GLYPHS ARE RASTERIZED SYNCHRONOUSLY
+    TextureStore *textureStore;
+    std::set<uint32_t> pendingGlyphs;
+    
+    ci::fs::path diskCacheDirectory; // EMPTY WHEN NO GlyphDiskCache IS USED
+    size_t diskCacheMaxFileSize;
+    GlyphDiskCache diskCache;
 
-    ActualFont(std::shared_ptr<FreetypeHelper> ftHelper, const Descriptor &descriptor, float baseSize, bool useMipmap);
+    /*
+     * WITHOUT indexEntry: THE FONT IS LOADED IMMEDIATELY (CAN THROW)
+     * OTHERWISE: LOADING IS DEFERRED UNTIL THE FONT IS ACTUALLY NEEDED, AND THE METRICS ARE ESTIMATED MEANWHILE
+     */
+    ActualFont(FontFace *face, const Descriptor &descriptor, float baseSize, bool useMipmap, bool useDistanceField, const FontIndex::Entry *indexEntry = NULL);
     
     void reload();
     void unload();
     void discardTextures();
+    void getTextures(std::vector<ReloadableTexture*> &textures) const; // APPENDS ALL THE TEXTURES (LOADED OR NOT)
     size_t getTextureMemoryUsage() const;
     
-    Glyph* getGlyph(uint32_t codepoint);
-    Glyph* createGlyph(uint32_t codepoint);
+    /*
+     * THE "FAST-PATH" IS NOT INVOKING reload() NOR DEALING WITH DISCARDED TEXTURES:
+     * IT IS ONLY TAKEN FOR DEFINED GLYPHS WHICH ARE TEXTURELESS OR WITH A LOADED TEXTURE
+     */
+    inline Glyph* getGlyph(uint32_t codepoint)
+    {
+        size_t pageIndex = codepoint >> GLYPH_PAGE_SHIFT;
+        
+        if (pageIndex < glyphPages.size())
+        {
+            auto page = glyphPages[pageIndex].get();
+            size_t index = codepoint & (GLYPH_PAGE_SIZE - 1);
+            
+            if (page && page->defined[index])
+            {
+                auto glyph = &page->glyphs[index];
+                
+                if (!glyph->texture)
+                {
+                    return glyph;
+                }
+                
+                if (glyph->texture->isLoaded())
+                {
+                    textureStore->touch(glyph->texture, true);
+                    return glyph;
+                }
+            }
+        }
+        
+        return loadGlyph(codepoint);
+    }
+    
+    Glyph* loadGlyph(uint32_t codepoint);
+    Glyph* defineGlyph(uint32_t codepoint, const Glyph &glyph);
+    Glyph createGlyph(const GlyphData &glyphData);
+    
+    GlyphData* rasterize(uint32_t codepoint); // THREAD-SAFE: ALSO INVOKED ON THE WORKER-THREADS OF GlyphRasterizer
+    bool addGlyph(uint32_t codepoint, const GlyphData &glyphData); // RETURNS TRUE IF A TEXTURE WAS INVOLVED
+    
+    void openDiskCache();
+    
+    /*
+     * RETURNS NULL IF THE "SIMPLE TEXT" FAST-PATH CAN'T BE USED WITH THIS FONT FOR language (SEE SimpleShaper)
+     * THE FONT MUST BE LOADED
+     * LOCK-FREE ONCE THE SHAPER OF language IS RESOLVED (I.E. ON THE PER-LINE PATH)
+     */
+    const SimpleShaper* getSimpleShaper(hb_language_t language);
+    const SimpleShaper* findSimpleShaper(hb_language_t language, int count, bool &found) const; // AMONG THE FIRST count PUBLISHED LANGUAGES
 
     std::string getFullName() const;
 
     friend class FontManager;
     friend class VirtualFont;
+    friend class GlyphRasterizer;
+    friend class Measurement;
+    friend struct LockedFontFuncs;
 };
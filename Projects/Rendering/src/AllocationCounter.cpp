@@ -0,0 +1,77 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+#if defined(MEASURE_ALLOCATIONS)
+
+static atomic<uint64_t> allocationCount(0);
+
+static void* allocate(size_t size)
+{
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    
+    auto data = malloc(size ? size : 1);
+    
+    if (!data)
+    {
+        throw bad_alloc();
+    }
+    
+    return data;
+}
+
+void* operator new(size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new[](size_t size)
+{
+    return allocate(size);
+}
+
+void operator delete(void *data) noexcept
+{
+    free(data);
+}
+
+void operator delete[](void *data) noexcept
+{
+    free(data);
+}
+
+bool AllocationCounter::isEnabled()
+{
+    return true;
+}
+
+uint64_t AllocationCounter::getCount()
+{
+    return allocationCount.load(memory_order_relaxed);
+}
+
+#else
+
+bool AllocationCounter::isEnabled()
+{
+    return false;
+}
+
+uint64_t AllocationCounter::getCount()
+{
+    return 0;
+}
+
+#endif
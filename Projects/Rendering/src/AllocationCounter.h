@@ -0,0 +1,28 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+/*
+ * COUNTING THE HEAP-ALLOCATIONS PERFORMED VIA operator new, FROM ANY THREAD
+ *
+ * THE GLOBAL operator new AND operator delete ARE REPLACED IN AllocationCounter.cpp
+ * ALLOCATIONS PERFORMED DIRECTLY VIA malloc() (E.G. BY FREETYPE OR HARFBUZZ) ARE NOT COUNTED
+ *
+ * ONLY WHEN MEASURE_ALLOCATIONS IS DEFINED (E.G. IN Android.mk OR IN THE PREPROCESSOR-MACROS OF THE XCODE PROJECTS):
+ * OTHERWISE, THE GLOBAL OPERATORS ARE NOT REPLACED AND getCount() IS RETURNING 0
+ */
+
+#pragma once
+
+#include <cstdint>
+
+class AllocationCounter
+{
+public:
+    static bool isEnabled();
+    static uint64_t getCount();
+};
@@ -0,0 +1,199 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+#include "DistanceField.h"
+
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+using namespace std;
+
+const float INF = 1e20f;
+
+unsigned char* DistanceField::create(const unsigned char *bitmap, int width, int height, int spread, int downsample, int &fieldWidth, int &fieldHeight)
+{
+    int border = spread * downsample;
+    int gridWidth = width + border * 2;
+    int gridHeight = height + border * 2;
+    int gridSize = gridWidth * gridHeight;
+    
+    vector<float> coverage(gridSize, 0);
+    
+    for (int iy = 0; iy < height; iy++)
+    {
+        for (int ix = 0; ix < width; ix++)
+        {
+            coverage[(iy + border) * gridWidth + (ix + border)] = bitmap[iy * width + ix] / 255.0f;
+        }
+    }
+    
+    /*
+     * FOR EACH PIXEL: THE NEAREST PIXEL ON THE OTHER SIDE OF THE EDGE
+     * (I.E. THE NEAREST "INSIDE" PIXEL FOR AN "OUTSIDE" PIXEL, AND VICE-VERSA)
+     */
+    vector<float> toInside(gridSize);
+    vector<float> toOutside(gridSize);
+    vector<int> nearestInside(gridSize);
+    vector<int> nearestOutside(gridSize);
+    
+    for (int i = 0; i < gridSize; i++)
+    {
+        bool inside = (coverage[i] >= 0.5f);
+        toInside[i] = inside ? 0 : INF;
+        toOutside[i] = inside ? INF : 0;
+    }
+    
+    transform(toInside.data(), nearestInside.data(), gridWidth, gridHeight);
+    transform(toOutside.data(), nearestOutside.data(), gridWidth, gridHeight);
+    
+    /*
+     * THE DISTANCES ARE MEASURED BETWEEN PIXEL-CENTERS
+     * THE ANTI-ALIASED COVERAGE IS USED FOR LOCATING THE EDGE WITH SUB-PIXEL ACCURACY
+     */
+    vector<float> distance(gridSize); // POSITIVE INSIDE, IN PIXELS
+    
+    for (int i = 0; i < gridSize; i++)
+    {
+        float a = coverage[i];
+        
+        if ((a > 0) && (a < 1))
+        {
+            distance[i] = a - 0.5f; // THE EDGE IS CROSSING THE PIXEL
+        }
+        else if (a >= 0.5f)
+        {
+            distance[i] = sqrtf(toOutside[i]) - (0.5f - coverage[nearestOutside[i]]);
+        }
+        else
+        {
+            distance[i] = -(sqrtf(toInside[i]) - (coverage[nearestInside[i]] - 0.5f));
+        }
+    }
+    
+    // ---
+    
+    fieldWidth = (gridWidth + downsample - 1) / downsample;
+    fieldHeight = (gridHeight + downsample - 1) / downsample;
+    auto field = (unsigned char*)malloc(fieldWidth * fieldHeight);
+    
+    for (int fy = 0; fy < fieldHeight; fy++)
+    {
+        for (int fx = 0; fx < fieldWidth; fx++)
+        {
+            float sum = 0;
+            
+            for (int by = 0; by < downsample; by++)
+            {
+                for (int bx = 0; bx < downsample; bx++)
+                {
+                    int gx = fx * downsample + bx;
+                    int gy = fy * downsample + by;
+                    
+                    if ((gx < gridWidth) && (gy < gridHeight))
+                    {
+                        sum += distance[gy * gridWidth + gx];
+                    }
+                    else
+                    {
+                        sum -= border;
+                    }
+                }
+            }
+            
+            float value = 0.5f + 0.5f * (sum / (downsample * downsample * downsample)) / spread; // FROM PIXELS TO TEXELS
+            field[fy * fieldWidth + fx] = (unsigned char)(255 * std::min(1.0f, std::max(0.0f, value)) + 0.5f);
+        }
+    }
+    
+    return field;
+}
+
+/*
+ * SQUARED DISTANCES, IN-PLACE
+ * nearest IS RECEIVING THE INDEX OF THE NEAREST "FEATURE" (I.E. ZERO-VALUED) PIXEL
+ */
+void DistanceField::transform(float *grid, int *nearest, int width, int height)
+{
+    int n = std::max(width, height);
+    
+    vector<float> f(n);
+    vector<float> d(n);
+    vector<int> v(n);
+    vector<float> z(n + 1);
+    vector<int> source(n);
+    vector<int> nearestRow(width * height);
+    
+    for (int ix = 0; ix < width; ix++)
+    {
+        for (int iy = 0; iy < height; iy++)
+        {
+            f[iy] = grid[iy * width + ix];
+        }
+        
+        transform1D(f.data(), d.data(), source.data(), v.data(), z.data(), height);
+        
+        for (int iy = 0; iy < height; iy++)
+        {
+            grid[iy * width + ix] = d[iy];
+            nearestRow[iy * width + ix] = source[iy];
+        }
+    }
+    
+    for (int iy = 0; iy < height; iy++)
+    {
+        transform1D(grid + iy * width, d.data(), source.data(), v.data(), z.data(), width);
+        
+        for (int ix = 0; ix < width; ix++)
+        {
+            grid[iy * width + ix] = d[ix];
+            nearest[iy * width + ix] = nearestRow[iy * width + source[ix]] * width + source[ix];
+        }
+    }
+}
+
+/*
+ * LOWER-ENVELOPE OF THE PARABOLAS ROOTED AT (q, f[q])
+ */
+void DistanceField::transform1D(const float *f, float *d, int *source, int *v, float *z, int n)
+{
+    int k = 0;
+    v[0] = 0;
+    z[0] = -INF;
+    z[1] = +INF;
+    
+    for (int q = 1; q < n; q++)
+    {
+        float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+        
+        while (s <= z[k])
+        {
+            k--;
+            s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+        }
+        
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = +INF;
+    }
+    
+    k = 0;
+    
+    for (int q = 0; q < n; q++)
+    {
+        while (z[k + 1] < q)
+        {
+            k++;
+        }
+        
+        d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+        source[q] = v[k];
+    }
+}
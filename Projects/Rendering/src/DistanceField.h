@@ -0,0 +1,34 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+/*
+ * 8-BIT "SIGNED DISTANCE-FIELD", COMPUTED ON THE CPU FROM A FREETYPE BITMAP
+ *
+ * - BASED ON THE EXACT EUCLIDEAN DISTANCE-TRANSFORM FROM FELZENSZWALB & HUTTENLOCHER:
+ *   http://cs.brown.edu/~pff/papers/dt-final.pdf
+ * - THE ANTI-ALIASED PIXELS ARE USED FOR SUB-PIXEL ACCURACY (SIMILAR TO GUSTAVSON'S "EDTAA")
+ * - THE FIELD IS DOWN-SAMPLED BY downsample (EACH TEXEL IS AVERAGING A BLOCK OF downsample x downsample PIXELS)
+ * - 128 IS THE EDGE, HIGHER VALUES ARE INSIDE
+ *   THE VALUES ARE SATURATING (0 OR 255) AT spread TEXELS FROM THE EDGE
+ */
+
+#pragma once
+
+class DistanceField
+{
+public:
+    /*
+     * THE FIELD IS EXTENDED BY (spread * downsample) PIXELS ON EACH SIDE OF THE BITMAP
+     * THE RETURNED BUFFER MUST BE RELEASED VIA free()
+     */
+    static unsigned char* create(const unsigned char *bitmap, int width, int height, int spread, int downsample, int &fieldWidth, int &fieldHeight);
+
+protected:
+    static void transform(float *grid, int *nearest, int width, int height);
+    static void transform1D(const float *f, float *d, int *source, int *v, float *z, int n);
+};
@@ -0,0 +1,125 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+/*
+ * OPENTYPE-FEATURES APPLIED TO A WHOLE LINE, E.G. FeatureList("kern=0,-liga,tnum")
+ *
+ * - PASSED AS IS TO hb_shape(), WHICH IS CACHING ONE SHAPE-PLAN PER FEATURE-LIST (SEE hb_shape_plan_create_cached IN hb-shape-plan.cc)
+ * - CANONICAL: SORTED BY TAG, WITH ONE VALUE PER TAG (THE LAST ONE DEFINED), I.E. EQUIVALENT LISTS ARE EQUAL
+ *   AND CAN TAKE PART IN THE KEYS OF LayoutCache, WordCache AND WidthCache
+ * - ONLY GLOBAL FEATURES: THE RANGES OF hb_feature_from_string() (E.G. "kern[3:5]") ARE REJECTED
+ */
+
+#pragma once
+
+#include "hb.h"
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+
+class FeatureList
+{
+public:
+    FeatureList()
+    {}
+
+    /*
+     * COMMA-SEPARATED, IN THE SYNTAX OF hb_feature_from_string()
+     * THROWS invalid_argument UPON MALFORMED OR NON-GLOBAL FEATURES
+     */
+    FeatureList(const std::string &input)
+    {
+        size_t start = 0;
+
+        while (start < input.size())
+        {
+            size_t end = std::min(input.find(',', start), input.size());
+
+            if (end > start)
+            {
+                hb_feature_t feature;
+
+                if (!hb_feature_from_string(input.data() + start, end - start, &feature) || (feature.start != 0) || (feature.end != (unsigned int)-1))
+                {
+                    throw std::invalid_argument("INVALID FEATURE: " + input.substr(start, end - start));
+                }
+
+                add(feature.tag, feature.value);
+            }
+
+            start = end + 1;
+        }
+    }
+
+    void add(hb_tag_t tag, uint32_t value = 1)
+    {
+        auto it = std::lower_bound(features.begin(), features.end(), tag, [](const hb_feature_t &feature, hb_tag_t tag) { return feature.tag < tag; });
+
+        if ((it != features.end()) && (it->tag == tag))
+        {
+            it->value = value;
+        }
+        else
+        {
+            features.insert(it, hb_feature_t { tag, value, 0, (unsigned int)-1 });
+        }
+    }
+
+    bool empty() const
+    {
+        return features.empty();
+    }
+
+    unsigned int size() const
+    {
+        return features.size();
+    }
+
+    const hb_feature_t* data() const
+    {
+        return features.empty() ? NULL : features.data();
+    }
+
+    std::string toString() const
+    {
+        std::string output;
+
+        for (auto feature : features)
+        {
+            char buffer[128];
+            hb_feature_to_string(&feature, buffer, sizeof(buffer));
+
+            if (!output.empty())
+            {
+                output += ',';
+            }
+
+            output += buffer;
+        }
+
+        return output;
+    }
+
+    bool operator<(const FeatureList &rhs) const
+    {
+        return std::lexicographical_compare(features.begin(), features.end(), rhs.features.begin(), rhs.features.end(), [](const hb_feature_t &lhs, const hb_feature_t &rhs)
+        {
+            return (lhs.tag < rhs.tag) || ((lhs.tag == rhs.tag) && (lhs.value < rhs.value));
+        });
+    }
+
+    bool operator==(const FeatureList &rhs) const
+    {
+        return !(*this < rhs) && !(rhs < *this);
+    }
+
+protected:
+    std::vector<hb_feature_t> features;
+};
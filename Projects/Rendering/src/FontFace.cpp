@@ -0,0 +1,313 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+#include "FontFace.h"
+
+#include "chronotext/utils/Utils.h"
+
+#include "cinder/Buffer.h"
+
+#if !defined(CINDER_MSW)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include <vector>
+
+using namespace std;
+using namespace ci;
+using namespace chr;
+
+/*
+ See http://www.microsoft.com/typography/otspec/name.htm for a list of some
+ possible platform-encoding pairs.  We're interested in 0-3 aka 3-1 - UCS-2.
+ Otherwise, fail. If a font has some unicode map, but lacks UCS-2 - it is a
+ broken or irrelevant font. What exactly Freetype will select on face load
+ (it promises most wide unicode, and if that will be slower that UCS-2 -
+ left as an excercise to check.)
+ */
+static FT_Error force_ucs2_charmap(FT_Face face)
+{
+    for (int i = 0; i < face->num_charmaps; i++)
+    {
+        auto platform_id = face->charmaps[i]->platform_id;
+        auto encoding_id = face->charmaps[i]->encoding_id;
+
+        if (((platform_id == 0) && (encoding_id == 3)) || ((platform_id == 3) && (encoding_id == 1)))
+        {
+            return FT_Set_Charmap(face, face->charmaps[i]);
+        }
+    }
+
+    return -1;
+}
+
+#if !defined(CINDER_MSW)
+struct Mapping
+{
+    void *data;
+    size_t size;
+};
+
+static void destroyMapping(void *userData)
+{
+    auto mapping = (Mapping*)userData;
+    munmap(mapping->data, mapping->size);
+    delete mapping;
+}
+#endif
+
+static void destroyBuffer(void *userData)
+{
+    delete (Buffer*)userData;
+}
+
+FontFace::FontFace(shared_ptr<FreetypeHelper> ftHelper, InputSourceRef source, int faceIndex)
+:
+ftHelper(ftHelper),
+source(source),
+faceIndex(faceIndex),
+referenceCount(0),
+status(STATUS_UNKNOWN),
+blob(NULL),
+mapped(false),
+ftFace(NULL),
+hbFace(NULL)
+{}
+
+FontFace::~FontFace()
+{
+    unload();
+}
+
+void FontFace::acquire()
+{
+    lock_guard<std::mutex> lock(ftHelper->mutex); // THE FT_Library IS SHARED WITH THE OTHER FACES
+    
+    if (referenceCount == 0)
+    {
+        load(); // CAN THROW
+    }
+
+    referenceCount++;
+}
+
+void FontFace::release()
+{
+    lock_guard<std::mutex> lock(ftHelper->mutex);
+    
+    if ((referenceCount > 0) && (--referenceCount == 0))
+    {
+        unload();
+    }
+}
+
+bool FontFace::isLoaded() const
+{
+    return bool(ftFace);
+}
+
+int FontFace::getReferenceCount() const
+{
+    return referenceCount;
+}
+
+FontFace::Status FontFace::getStatus() const
+{
+    return status;
+}
+
+InputSourceRef FontFace::getSource() const
+{
+    return source;
+}
+
+fs::path FontFace::getFilePath() const
+{
+    return source->isFile() ? source->getFilePath() : fs::path();
+}
+
+FT_Library FontFace::getLib() const
+{
+    return ftHelper->getLib();
+}
+
+FT_Face FontFace::getFtFace() const
+{
+    return ftFace;
+}
+
+hb_face_t* FontFace::getHbFace() const
+{
+    return hbFace;
+}
+
+const OpenTypeTables* FontFace::getOpenTypeTables() const
+{
+    return openTypeTables.get();
+}
+
+bool FontFace::isMapped() const
+{
+    return mapped;
+}
+
+size_t FontFace::getMappedSize() const
+{
+    return (blob && mapped) ? hb_blob_get_length(blob) : 0;
+}
+
+size_t FontFace::getResidentSize() const
+{
+    if (blob)
+    {
+        unsigned int length;
+        auto data = hb_blob_get_data(blob, &length);
+        
+#if !defined(CINDER_MSW)
+        if (mapped)
+        {
+            size_t pageSize = sysconf(_SC_PAGESIZE);
+            size_t pageCount = (length + pageSize - 1) / pageSize;
+            
+#if defined(CINDER_COCOA)
+            vector<char> pages(pageCount);
+#else
+            vector<unsigned char> pages(pageCount);
+#endif
+            
+            if (mincore((void*)data, length, pages.data()) == 0)
+            {
+                size_t residentCount = 0;
+                
+                for (auto page : pages)
+                {
+                    residentCount += (page & 1);
+                }
+                
+                return std::min<size_t>(length, residentCount * pageSize);
+            }
+        }
+#endif
+        
+        return length;
+    }
+    
+    return 0;
+}
+
+void FontFace::load()
+{
+    if (!ftFace)
+    {
+        status = STATUS_INVALID; // UNTIL PROVEN OTHERWISE
+        
+        blob = createMappedBlob();
+        mapped = bool(blob);
+        
+        if (!mapped)
+        {
+            blob = createHeapBlob();
+        }
+        
+        unsigned int length;
+        auto data = hb_blob_get_data(blob, &length);
+        
+        FT_Error error = FT_New_Memory_Face(ftHelper->getLib(), (FT_Byte*)data, length, faceIndex, &ftFace);
+        
+        if (error)
+        {
+            ftFace = NULL;
+            hb_blob_destroy(blob); blob = NULL;
+            
+            throw runtime_error("FREETYPE: ERROR " + toString(error));
+        }
+        
+        if (force_ucs2_charmap(ftFace))
+        {
+            FT_Done_Face(ftFace); ftFace = NULL;
+            hb_blob_destroy(blob); blob = NULL;
+            status = STATUS_NO_UCS2_CHARMAP;
+            
+            throw runtime_error("HARFBUZZ: FONT IS BROKEN OR IRRELEVANT");
+        }
+        
+        /*
+         * THE hb_face_t IS REFERENCING THE SAME blob AS THE FT_Face, I.E. THE OPENTYPE TABLES ARE NOT COPIED
+         */
+        hbFace = hb_face_create(blob, faceIndex);
+        hb_face_set_upem(hbFace, ftFace->units_per_EM);
+        
+        openTypeTables.reset(new OpenTypeTables(hbFace, ftFace));
+        
+        status = STATUS_OK;
+        
+        LOGD << "LOADING FontFace: " << source->getURI() << " " << faceIndex << " | " << (mapped ? "MAPPED " : "HEAP ") << length << " BYTES" << (openTypeTables->isUsable() ? "" : " | NO NATIVE GLYPH-QUERIES") << endl;
+    }
+}
+
+void FontFace::unload()
+{
+    if (ftFace)
+    {
+        LOGD << "UNLOADING FontFace: " << source->getURI() << " " << faceIndex << endl;
+
+        openTypeTables.reset();
+        hb_face_destroy(hbFace); hbFace = NULL;
+        FT_Done_Face(ftFace); ftFace = NULL;
+        hb_blob_destroy(blob); blob = NULL; // THE FONT-DATA IS RELEASED ONCE HARFBUZZ IS NOT REFERENCING IT ANYMORE
+        
+        mapped = false;
+    }
+}
+
+/*
+ * RETURNS NULL IF THE SOURCE IS NOT A FILE, OR IF MAPPING IS NOT AVAILABLE
+ */
+hb_blob_t* FontFace::createMappedBlob()
+{
+#if !defined(CINDER_MSW)
+    if (source->isFile())
+    {
+        int fd = open(source->getFilePath().c_str(), O_RDONLY);
+        
+        if (fd != -1)
+        {
+            hb_blob_t *result = NULL;
+            struct stat info;
+            
+            if ((fstat(fd, &info) == 0) && (info.st_size > 0))
+            {
+                auto data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                
+                if (data != MAP_FAILED)
+                {
+                    auto mapping = new Mapping;
+                    mapping->data = data;
+                    mapping->size = info.st_size;
+                    
+                    result = hb_blob_create((const char*)data, info.st_size, HB_MEMORY_MODE_READONLY, mapping, destroyMapping);
+                }
+            }
+            
+            close(fd); // THE MAPPING REMAINS VALID
+            return result;
+        }
+    }
+#endif
+    
+    return NULL;
+}
+
+hb_blob_t* FontFace::createHeapBlob()
+{
+    auto buffer = new Buffer(source->loadDataSource()->getBuffer()); // CAN THROW
+    return hb_blob_create((const char*)buffer->getData(), buffer->getDataSize(), HB_MEMORY_MODE_READONLY, buffer, destroyBuffer);
+}
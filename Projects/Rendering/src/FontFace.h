@@ -0,0 +1,113 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+/*
+ * THE SIZE-INDEPENDENT PART OF A FONT: ONE FT_Face AND ONE hb_face_t PER (URI, FACE-INDEX)
+ *
+ * - SHARED BY ALL THE ActualFont INSTANCES USING THE SAME FONT-FILE (EACH WITH ITS OWN FT_Size AND hb_font_t)
+ * - REFERENCE-COUNTED: LOADED UPON THE FIRST acquire() AND UNLOADED UPON THE LAST release()
+ * - THE FONT-DATA IS MAPPED (READ-ONLY) WHEN THE SOURCE IS A FILE, AND SHARED WITHOUT COPY BY FREETYPE AND HARFBUZZ (VIA AN hb_blob_t)
+ *   OTHERWISE (E.G. ANDROID ASSETS), OR IF MAPPING IS NOT AVAILABLE (WINDOWS): THE FONT-DATA IS COPIED TO THE HEAP
+ * - THE FT_Face IS NOT THREAD-SAFE: mutex MUST BE LOCKED BY ANY THREAD USING IT
+ *   EXCEPT VIA THE hb_font_t OF AN ActualFont, WHICH IS LOCKING mutex BY ITSELF
+ * - THE OpenTypeTables (NATIVE cmap AND hmtx QUERIES) ARE THREAD-SAFE
+ * - acquire() AND release() ARE THREAD-SAFE (FreetypeHelper::mutex IS LOCKED WHILE LOADING OR UNLOADING)
+ */
+
+#pragma once
+
+#include "FreetypeHelper.h"
+#include "OpenTypeTables.h"
+
+#include "chronotext/InputSource.h"
+
+#include "cinder/Thread.h"
+
+#include "hb.h"
+
+class FontFace
+{
+public:
+    typedef enum
+    {
+        STATUS_UNKNOWN, // NOT LOADED YET
+        STATUS_OK,
+        STATUS_INVALID, // FREETYPE CAN'T OPEN THE FONT
+        STATUS_NO_UCS2_CHARMAP,
+    }
+    Status;
+    
+    struct Key
+    {
+        std::string uri;
+        int faceIndex;
+
+        Key(const std::string &uri, int faceIndex)
+        :
+        uri(uri),
+        faceIndex(faceIndex)
+        {}
+
+        bool operator<(const Key &rhs) const
+        {
+            return tie(uri, faceIndex) < tie(rhs.uri, rhs.faceIndex);
+        }
+    };
+
+    std::mutex mutex;
+
+    FontFace(std::shared_ptr<FreetypeHelper> ftHelper, chr::InputSourceRef source, int faceIndex);
+    ~FontFace();
+
+    /*
+     * CAN THROW IF THE FONT IS NOT LOADED YET
+     */
+    void acquire();
+    void release();
+
+    bool isLoaded() const;
+    int getReferenceCount() const;
+    Status getStatus() const; // THE OUTCOME OF THE LAST LOADING-ATTEMPT
+    
+    chr::InputSourceRef getSource() const;
+    ci::fs::path getFilePath() const; // EMPTY IF THE SOURCE IS NOT A FILE
+
+    FT_Library getLib() const;
+    FT_Face getFtFace() const;
+    hb_face_t* getHbFace() const;
+    const OpenTypeTables* getOpenTypeTables() const; // NULL WHEN NOT LOADED
+    
+    /*
+     * MAPPED BYTES: THE SIZE OF THE FILE-MAPPING (ZERO IF THE FONT-DATA IS ON THE HEAP)
+     * RESIDENT BYTES: THE PART OF THE FONT-DATA ACTUALLY IN PHYSICAL MEMORY (ALL OF IT WHEN ON THE HEAP)
+     */
+    bool isMapped() const;
+    size_t getMappedSize() const;
+    size_t getResidentSize() const;
+
+protected:
+    std::shared_ptr<FreetypeHelper> ftHelper;
+
+    chr::InputSourceRef source;
+    int faceIndex;
+
+    int referenceCount;
+    Status status;
+
+    hb_blob_t *blob; // OWNING THE FONT-DATA (MAPPED OR ON THE HEAP)
+    bool mapped;
+    FT_Face ftFace;
+    hb_face_t *hbFace;
+    std::unique_ptr<OpenTypeTables> openTypeTables;
+
+    void load();
+    void unload();
+    
+    hb_blob_t* createMappedBlob();
+    hb_blob_t* createHeapBlob();
+};
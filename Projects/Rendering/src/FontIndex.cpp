@@ -0,0 +1,420 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+#include "FontIndex.h"
+#include "GlyphDiskCache.h"
+
+#include "chronotext/utils/Utils.h"
+
+#include <fstream>
+#include <algorithm>
+
+using namespace std;
+using namespace ci;
+using namespace chr;
+
+static const char MAGIC[4] = {'F', 'I', 'D', 'X'};
+
+/*
+ * MINIMAL (HOST-ENDIAN) SERIALIZATION HELPERS
+ */
+
+template<typename T> static void write(string &buffer, const T &value)
+{
+    buffer.append((const char*)&value, sizeof(T));
+}
+
+template<typename T> static bool read(const string &buffer, size_t &offset, T &value)
+{
+    if (offset + sizeof(T) <= buffer.size())
+    {
+        memcpy(&value, buffer.data() + offset, sizeof(T));
+        offset += sizeof(T);
+
+        return true;
+    }
+
+    return false;
+}
+
+// ---
+
+FontIndex::Entry::Entry()
+:
+fileSize(0),
+fileTime(0),
+status(FontFace::STATUS_UNKNOWN),
+unitsPerEM(0),
+ascender(0),
+descender(0),
+height(0),
+underlinePosition(0),
+underlineThickness(0),
+strikeoutPosition(0),
+hasStrikeoutPosition(false)
+{}
+
+bool FontIndex::Entry::isUsable() const
+{
+    return (status == FontFace::STATUS_OK);
+}
+
+bool FontIndex::Entry::covers(uint32_t codepoint) const
+{
+    /*
+     * THE FIRST RANGE ENDING AT OR AFTER codepoint
+     */
+    auto it = lower_bound(coverage.begin(), coverage.end(), codepoint, [](const pair<uint32_t, uint32_t> &range, uint32_t value)
+    {
+        return range.second < value;
+    });
+
+    return (it != coverage.end()) && (it->first <= codepoint);
+}
+
+bool FontIndex::Entry::coversAny(const UnicodeString &text, int32_t start, int32_t end) const
+{
+    for (int32_t i = start; i < end; i = text.moveIndex32(i, 1))
+    {
+        if (covers(text.char32At(i)))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// ---
+
+FontIndex::FontIndex(const fs::path &filePath)
+:
+filePath(filePath),
+dirty(false)
+{
+    if (!load())
+    {
+        entries.clear();
+    }
+}
+
+const FontIndex::Entry& FontIndex::getEntry(const FontFace::Key &key, FontFace &face)
+{
+    uint64_t fileSize;
+    int64_t fileTime;
+    getFileSignature(key, face, fileSize, fileTime);
+
+    auto it = entries.find(key);
+
+    if ((it != entries.end()) && (it->second.fileSize == fileSize) && (it->second.fileTime == fileTime))
+    {
+        return it->second;
+    }
+
+    auto &entry = entries[key];
+    entry = Entry();
+    entry.fileSize = fileSize;
+    entry.fileTime = fileTime;
+
+    createEntry(face, entry);
+    dirty = true;
+
+    return entry;
+}
+
+bool FontIndex::save()
+{
+    if (dirty && !entries.empty())
+    {
+        string buffer;
+
+        buffer.append(MAGIC, 4);
+        write(buffer, uint32_t(VERSION));
+        write(buffer, getFreetypeVersion());
+        write(buffer, uint32_t(entries.size()));
+
+        for (auto &it : entries)
+        {
+            auto &key = it.first;
+            auto &entry = it.second;
+
+            write(buffer, uint32_t(key.uri.size()));
+            buffer.append(key.uri);
+            write(buffer, int32_t(key.faceIndex));
+
+            write(buffer, entry.fileSize);
+            write(buffer, entry.fileTime);
+            write(buffer, int32_t(entry.status));
+
+            int32_t values[8] = {entry.unitsPerEM, entry.ascender, entry.descender, entry.height, entry.underlinePosition, entry.underlineThickness, entry.strikeoutPosition, entry.hasStrikeoutPosition};
+            write(buffer, values);
+
+            write(buffer, uint32_t(entry.coverage.size()));
+
+            for (auto &range : entry.coverage)
+            {
+                write(buffer, range.first);
+                write(buffer, range.second);
+            }
+        }
+
+        write(buffer, GlyphDiskCache::hash(buffer.data(), buffer.size()));
+
+        // ---
+
+        ofstream out(filePath.string().c_str(), ios::binary | ios::trunc);
+        out.write(buffer.data(), buffer.size());
+
+        if (!out)
+        {
+            LOGD << "FontIndex: CAN'T WRITE " << filePath << endl;
+            return false;
+        }
+
+        dirty = false;
+    }
+
+    return true;
+}
+
+size_t FontIndex::size() const
+{
+    return entries.size();
+}
+
+/*
+ * RETURNS FALSE IF THE FILE DOES NOT EXIST, OR IF IT IS OUTDATED OR CORRUPTED
+ */
+bool FontIndex::load()
+{
+    string buffer;
+
+    {
+        ifstream in(filePath.string().c_str(), ios::binary);
+
+        if (!in)
+        {
+            return false;
+        }
+
+        buffer.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    }
+
+    uint64_t checksum;
+
+    if ((buffer.size() < 4 + sizeof(checksum)) || memcmp(buffer.data(), MAGIC, 4))
+    {
+        return false;
+    }
+
+    size_t checksumOffset = buffer.size() - sizeof(checksum);
+
+    memcpy(&checksum, buffer.data() + checksumOffset, sizeof(checksum));
+
+    if (checksum != GlyphDiskCache::hash(buffer.data(), checksumOffset))
+    {
+        return false;
+    }
+
+    buffer.resize(checksumOffset);
+
+    // ---
+
+    size_t offset = 4;
+    uint32_t version, freetypeVersion, entryCount;
+
+    if (!read(buffer, offset, version) || (version != VERSION) || !read(buffer, offset, freetypeVersion) || (freetypeVersion != getFreetypeVersion()) || !read(buffer, offset, entryCount))
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < entryCount; i++)
+    {
+        uint32_t uriSize;
+
+        if (!read(buffer, offset, uriSize) || (offset + uriSize > buffer.size()))
+        {
+            return false;
+        }
+
+        string uri(buffer.data() + offset, uriSize);
+        offset += uriSize;
+
+        int32_t faceIndex, status;
+        int32_t values[8];
+        uint32_t rangeCount;
+        Entry entry;
+
+        if (!read(buffer, offset, faceIndex) || !read(buffer, offset, entry.fileSize) || !read(buffer, offset, entry.fileTime) || !read(buffer, offset, status) || !read(buffer, offset, values) || !read(buffer, offset, rangeCount))
+        {
+            return false;
+        }
+
+        entry.status = FontFace::Status(status);
+        entry.unitsPerEM = values[0];
+        entry.ascender = values[1];
+        entry.descender = values[2];
+        entry.height = values[3];
+        entry.underlinePosition = values[4];
+        entry.underlineThickness = values[5];
+        entry.strikeoutPosition = values[6];
+        entry.hasStrikeoutPosition = values[7];
+
+        entry.coverage.resize(rangeCount);
+
+        for (auto &range : entry.coverage)
+        {
+            if (!read(buffer, offset, range.first) || !read(buffer, offset, range.second))
+            {
+                return false;
+            }
+        }
+
+        entries[FontFace::Key(uri, faceIndex)] = entry;
+    }
+
+    return true;
+}
+
+/*
+ * FOR NON-FILE SOURCES: THE SIZE OF THE DATA AND THE checkSumAdjustment OF ITS head TABLE
+ * BOTH VALUES ARE ZERO IF THE SOURCE CAN'T BE READ
+ */
+void FontIndex::getFileSignature(const FontFace::Key &key, FontFace &face, uint64_t &fileSize, int64_t &fileTime)
+{
+    fileSize = 0;
+    fileTime = 0;
+
+    auto path = face.getFilePath();
+
+    if (!path.empty())
+    {
+        boost::system::error_code error1, error2;
+
+        auto size = fs::file_size(path, error1);
+        auto time = fs::last_write_time(path, error2);
+
+        if (!error1 && !error2)
+        {
+            fileSize = size;
+            fileTime = time;
+        }
+    }
+    else
+    {
+        try
+        {
+            auto buffer = face.getSource()->loadDataSource()->getBuffer(); // CAN THROW
+
+            fileSize = buffer.getDataSize();
+            fileTime = getCheckSumAdjustment(static_cast<const uint8_t*>(buffer.getData()), buffer.getDataSize(), key.faceIndex);
+        }
+        catch (exception &e)
+        {
+            LOGD << "FontIndex: CAN'T READ " << face.getSource()->getURI() << " | " << e.what() << endl;
+        }
+    }
+}
+
+/*
+ * FOLLOWING THE TABLE-DIRECTORY OF THE FONT (OR OF THE FACE, IN A COLLECTION)
+ * RETURNS ZERO IF THE head TABLE CAN'T BE FOUND (E.G. TRUNCATED DATA)
+ */
+uint32_t FontIndex::getCheckSumAdjustment(const uint8_t *data, size_t size, int faceIndex)
+{
+    auto u32 = [=](size_t offset)->uint32_t
+    {
+        return (offset + 4 <= size) ? ((uint32_t(data[offset]) << 24) | (data[offset + 1] << 16) | (data[offset + 2] << 8) | data[offset + 3]) : 0;
+    };
+
+    size_t directory = 0;
+
+    if (u32(0) == 0x74746366) // 'ttcf'
+    {
+        directory = u32(12 + 4 * faceIndex);
+    }
+
+    uint32_t tableCount = u32(directory + 4) >> 16;
+
+    for (uint32_t i = 0; i < tableCount; i++)
+    {
+        size_t record = directory + 12 + i * 16;
+
+        if ((record + 16 <= size) && (u32(record) == 0x68656164)) // 'head'
+        {
+            return u32(u32(record + 8) + 8);
+        }
+    }
+
+    return 0;
+}
+
+void FontIndex::createEntry(FontFace &face, Entry &entry)
+{
+    try
+    {
+        face.acquire(); // CAN THROW
+    }
+    catch (exception &e)
+    {
+        entry.status = face.getStatus();
+        return;
+    }
+
+    {
+        /*
+         * THE FACE MAY ALREADY BE IN USE (E.G. BY THE WORKERS OF SOME GlyphRasterizer)
+         */
+        lock_guard<mutex> lock(face.mutex);
+        auto ftFace = face.getFtFace();
+
+        entry.status = FontFace::STATUS_OK;
+
+        entry.unitsPerEM = ftFace->units_per_EM;
+        entry.ascender = ftFace->ascender;
+        entry.descender = ftFace->descender;
+        entry.height = ftFace->height;
+        entry.underlinePosition = ftFace->underline_position;
+        entry.underlineThickness = ftFace->underline_thickness;
+
+        auto os2 = (TT_OS2*)FT_Get_Sfnt_Table(ftFace, ft_sfnt_os2);
+
+        if (os2 && (os2->version != 0xFFFF))
+        {
+            entry.strikeoutPosition = os2->yStrikeoutPosition;
+            entry.hasStrikeoutPosition = true;
+        }
+
+        /*
+         * THE UCS-2 CHARMAP HAS BEEN SELECTED BY FontFace
+         */
+        FT_UInt glyphIndex;
+        auto codepoint = FT_Get_First_Char(ftFace, &glyphIndex);
+
+        while (glyphIndex)
+        {
+            if (!entry.coverage.empty() && (entry.coverage.back().second + 1 == codepoint))
+            {
+                entry.coverage.back().second = codepoint;
+            }
+            else
+            {
+                entry.coverage.emplace_back(codepoint, codepoint);
+            }
+
+            codepoint = FT_Get_Next_Char(ftFace, codepoint, &glyphIndex);
+        }
+    }
+
+    face.release();
+}
+
+uint32_t FontIndex::getFreetypeVersion()
+{
+    return (FREETYPE_MAJOR << 16) | (FREETYPE_MINOR << 8) | FREETYPE_PATCH;
+}
@@ -0,0 +1,96 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+/*
+ * PERSISTENT METADATA PER FontFace, ALLOWING TO CREATE A VirtualFont WITHOUT LOADING ALL ITS ActualFont INSTANCES:
+ * - IS THE FONT USABLE? (FREETYPE CAN OPEN IT AND IT HAS A UCS-2 CHARMAP)
+ * - UNSCALED METRICS
+ * - CODEPOINT COVERAGE, AS A LIST OF RANGES
+ *
+ * - A SINGLE FILE, LOADED UPON CONSTRUCTION AND WRITTEN VIA save() WHEN NEW ENTRIES HAVE BEEN ADDED
+ * - THE ENTRIES OF FONT-FILES ARE INVALIDATED WHENEVER THE FILE'S SIZE OR MODIFICATION-TIME IS CHANGING
+ * - THE ENTRIES OF NON-FILE SOURCES (E.G. ANDROID ASSETS) ARE INVALIDATED WHENEVER THE SIZE OF THE DATA
+ *   OR THE checkSumAdjustment OF ITS head TABLE IS CHANGING: THE DATA IS READ (BUT NOT PARSED BY FREETYPE)
+ * - THE WHOLE FILE IS DISCARDED IF ITS VERSION, ITS CHECKSUM OR THE FREETYPE VERSION IS NOT MATCHING
+ */
+
+#pragma once
+
+#include "FontFace.h"
+
+#include "cinder/Filesystem.h"
+
+#include "unicode/unistr.h"
+
+#include <map>
+#include <vector>
+
+class FontIndex
+{
+public:
+    static const uint32_t VERSION = 1; // MUST BE INCREMENTED WHENEVER THE FORMAT IS CHANGING
+
+    struct Entry
+    {
+        uint64_t fileSize;
+        int64_t fileTime; // FOR NON-FILE SOURCES: THE checkSumAdjustment OF THE head TABLE
+
+        FontFace::Status status;
+
+        /*
+         * IN FONT-UNITS
+         */
+        int unitsPerEM;
+        int ascender;
+        int descender;
+        int height;
+        int underlinePosition;
+        int underlineThickness;
+        int strikeoutPosition;
+        bool hasStrikeoutPosition; // FALSE IF THE FONT HAS NO (PROPER) OS/2 TABLE
+
+        std::vector<std::pair<uint32_t, uint32_t>> coverage; // SORTED AND DISJOINT RANGES OF CODEPOINTS (INCLUSIVE)
+
+        Entry();
+
+        bool isUsable() const;
+        bool covers(uint32_t codepoint) const;
+        bool coversAny(const UnicodeString &text, int32_t start, int32_t end) const; // IS ANY CODEPOINT OF THE RANGE COVERED?
+    };
+
+    /*
+     * THE FILE IS NOT REQUIRED TO EXIST
+     */
+    FontIndex(const ci::fs::path &filePath);
+
+    /*
+     * THE FONT IS TEMPORARILY LOADED IF NO (UP-TO-DATE) ENTRY IS AVAILABLE
+     * THE RETURNED REFERENCE REMAINS VALID DURING THE LIFE-TIME OF THE FontIndex
+     */
+    const Entry& getEntry(const FontFace::Key &key, FontFace &face);
+
+    /*
+     * NO-OP IF NO ENTRY HAS BEEN ADDED SINCE THE LAST LOAD OR SAVE
+     * RETURNS FALSE IF THE FILE CAN'T BE WRITTEN
+     */
+    bool save();
+
+    size_t size() const;
+
+protected:
+    ci::fs::path filePath;
+    std::map<FontFace::Key, Entry> entries;
+    bool dirty;
+
+    bool load();
+
+    static void getFileSignature(const FontFace::Key &key, FontFace &face, uint64_t &fileSize, int64_t &fileTime);
+    static uint32_t getCheckSumAdjustment(const uint8_t *data, size_t size, int faceIndex);
+    static void createEntry(FontFace &face, Entry &entry);
+    static uint32_t getFreetypeVersion();
+};
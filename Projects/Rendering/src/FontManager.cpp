@@ -28,7 +28,8 @@ FontManager::FontManager()
 :
 ftHelper(make_shared<FreetypeHelper>()),
 itemizer(langHelper),
-hasDefaultFont(false)
+hasDefaultFont(false),
+diskCacheMaxFileSize(0)
 {
 #if defined(CINDER_MAC)
     platform = PLATFORM_OSX;
@@ -210,8 +211,18 @@ shared_ptr<VirtualFont> FontManager::getCachedFont(InputSourceRef source, float
          */
         if (doc.hasChild("VirtualFont"))
         {
-            auto font = shared_ptr<VirtualFont>(new VirtualFont(layoutCache, itemizer, baseSize)); // make_shared WOULD HAVE BEEN BETTER, BUT IT WON'T WORK WITH PROTECTED CONSTRUCTORS
+            auto font = shared_ptr<VirtualFont>(new VirtualFont(layoutCache, wordCache, itemizationCache, itemizer, workerPool, baseSize)); // make_shared WOULD HAVE BEEN BETTER, BUT IT WON'T WORK WITH PROTECTED CONSTRUCTORS
             virtualFonts[key] = font;
+            
+            /*
+             * A SINGLE DISTANCE-FIELD IS SERVING ALL THE SIZES: MIPMAPS ARE NOT NECESSARY
+             */
+            font->useDistanceField = (doc.getChild("VirtualFont").getAttributeValue<string>("distance-field", "false") == "true");
+            
+            if (font->useDistanceField)
+            {
+                useMipmap = false;
+            }
 
             for (auto setElement = doc.begin("VirtualFont/Set"); setElement != doc.end(); ++setElement)
             {
@@ -227,7 +238,7 @@ shared_ptr<VirtualFont> FontManager::getCachedFont(InputSourceRef source, float
                             {
                                 auto descriptor = parseDescriptor(*refElement);
                                 
-                                if (!descriptor.empty() && font->addActualFont(lang, getActualFont(descriptor, baseSize, useMipmap)))
+                                if (!descriptor.empty() && font->addActualFont(lang, getActualFont(descriptor, baseSize, useMipmap, font->useDistanceField)))
                                 {
                                     break;
                                 }
@@ -239,13 +250,18 @@ shared_ptr<VirtualFont> FontManager::getCachedFont(InputSourceRef source, float
                             
                             if (!descriptor.empty())
                             {
-                                font->addActualFont(lang, getActualFont(descriptor, baseSize, useMipmap));
+                                font->addActualFont(lang, getActualFont(descriptor, baseSize, useMipmap, font->useDistanceField));
                             }
                         }
                     }
                 }
             }
             
+            if (fontIndex)
+            {
+                fontIndex->save();
+            }
+            
             return font;
         }
         
@@ -347,9 +363,101 @@ size_t FontManager::getTextureMemoryUsage() const
     return total;
 }
 
-ActualFont* FontManager::getActualFont(const ActualFont::Descriptor &descriptor, float baseSize, bool useMipmap)
+float FontManager::getTextureOccupancy() const
+{
+    float occupiedPages = 0;
+    size_t pageCount = 0;
+    
+    for (auto &it : actualFonts)
+    {
+        auto count = it.second->atlas.getPageCount();
+        occupiedPages += it.second->atlas.getOccupancy() * count;
+        pageCount += count;
+    }
+    
+    return pageCount ? (occupiedPages / pageCount) : 0;
+}
+
+void FontManager::beginFrame()
+{
+    vector<ReloadableTexture*> textures;
+    
+    for (auto &it : actualFonts)
+    {
+        it.second->getTextures(textures);
+    }
+    
+    textureStore.update(textures);
+}
+
+void FontManager::enableAsyncRasterization(int workerCount)
+{
+    if (!rasterizer)
+    {
+        rasterizer = unique_ptr<GlyphRasterizer>(new GlyphRasterizer(workerCount));
+        
+        for (auto &it : actualFonts)
+        {
+            it.second->rasterizer = rasterizer.get();
+        }
+    }
+}
+
+int FontManager::uploadGlyphs(int budget)
+{
+    return rasterizer ? rasterizer->upload(budget) : 0;
+}
+
+size_t FontManager::getPendingGlyphCount() const
+{
+    return rasterizer ? rasterizer->getPendingCount() : 0;
+}
+
+void FontManager::enableDiskCache(const fs::path &directory, size_t maxFileSize)
+{
+    diskCacheDirectory = directory;
+    diskCacheMaxFileSize = maxFileSize;
+    
+    for (auto &it : actualFonts)
+    {
+        it.second->diskCacheDirectory = directory;
+        it.second->diskCacheMaxFileSize = maxFileSize;
+        it.second->openDiskCache();
+    }
+}
+
+void FontManager::enableFontIndex(const fs::path &filePath)
 {
-    ActualFont::Key key(descriptor, baseSize, useMipmap);
+    if (!fontIndex)
+    {
+        fontIndex = unique_ptr<FontIndex>(new FontIndex(filePath));
+    }
+}
+
+/*
+ * THE FontFace INSTANCES ARE NEVER REMOVED: ONLY THEIR RESOURCES ARE FREED WHEN NO ActualFont IS USING THEM
+ */
+FontFace* FontManager::getFontFace(const ActualFont::Descriptor &descriptor)
+{
+    FontFace::Key key(descriptor.source->getURI(), descriptor.faceIndex);
+    auto it = fontFaces.find(key);
+    
+    if (it != fontFaces.end())
+    {
+        return it->second.get();
+    }
+    else
+    {
+        auto face = new FontFace(ftHelper, descriptor.source, descriptor.faceIndex);
+        fontFaces[key] = unique_ptr<FontFace>(face);
+        
+        return face;
+    }
+}
+
+ActualFont* FontManager::getActualFont(const ActualFont::Descriptor &descriptor, float baseSize, bool useMipmap, bool useDistanceField)
+{
+    ActualFont::Key key(descriptor, baseSize, useMipmap, useDistanceField);
     auto it = actualFonts.find(key);
     
     if (it != actualFonts.end())
@@ -360,7 +468,26 @@ ActualFont* FontManager::getActualFont(const ActualFont::Descriptor &descriptor,
     {
         try
         {
-            auto font = new ActualFont(ftHelper, descriptor, baseSize, useMipmap);
+            auto face = getFontFace(descriptor);
+            const FontIndex::Entry *indexEntry = NULL;
+            
+            if (fontIndex)
+            {
+                indexEntry = &fontIndex->getEntry(FontFace::Key(descriptor.source->getURI(), descriptor.faceIndex), *face);
+                
+                if (!indexEntry->isUsable())
+                {
+                    throw runtime_error("FontIndex: FONT IS NOT USABLE");
+                }
+            }
+            
+            auto font = new ActualFont(face, descriptor, baseSize, useMipmap, useDistanceField, indexEntry);
+            font->rasterizer = rasterizer.get();
+            font->textureStore = &textureStore;
+            
+            font->diskCacheDirectory = diskCacheDirectory;
+            font->diskCacheMaxFileSize = diskCacheMaxFileSize;
+            font->openDiskCache();
             actualFonts[key] = unique_ptr<ActualFont>(font);
             
             return font;
@@ -9,6 +9,7 @@
 #pragma once
 
 #include "VirtualFont.h"
+#include "GlyphRasterizer.h"
 
 #include "chronotext/InputSource.h"
 
@@ -20,7 +21,11 @@ public:
     std::shared_ptr<FreetypeHelper> ftHelper; // THE UNDERLYING FT_Library WILL BE DESTROYED AFTER ALL THE ActualFont INSTANCES
     LangHelper langHelper;
     LayoutCache layoutCache;
+    WordCache wordCache;
+    ItemizationCache itemizationCache; // SHARED BY ALL THE VirtualFont INSTANCES
     TextItemizer itemizer;
+    WorkerPool workerPool; // USED BY VirtualFont::createLineLayouts(), THE WORKERS ARE STARTED UPON THE FIRST BATCH
+    TextureStore textureStore; // NO BUDGET BY DEFAULT: SEE TextureStore::setBudget()
     
     FontManager();
     
@@ -52,12 +57,16 @@ public:
     
     /*
      * LOWER-LEVEL METHOD, FOR ACCESSING A FONT DIRECTLY VIA ITS XML-DEFINITION
+     *
+     * DISTANCE-FIELD RENDERING CAN BE REQUESTED IN THE XML-DEFINITION, E.G. <VirtualFont distance-field="true">
+     * IN THIS CASE, useMipmap IS IGNORED
      */
     std::shared_ptr<VirtualFont> getCachedFont(chr::InputSourceRef source, float baseSize, bool useMipmap = false);
     
     /*
      * CLEARS THE FONT RESOURCES (HARFBUZZ AND FREETYPE RELATED) AND DISCARDS THE GLYPH TEXTURES
      * ASSOCIATED SOLELY WITH A SPECIFIC VirtualFont
+     * A FONT-FILE SHARED WITH SOME OTHER VirtualFont (E.G. AT A DIFFERENT SIZE) REMAINS OPEN
      * FROM THIS POINT: RESOURCES WILL BE RELOADED AND TEXTURES RECREATED ONLY WHEN NECESSARY
      */
     void unload(std::shared_ptr<VirtualFont> virtualFont);
@@ -82,6 +91,51 @@ public:
      * NOTE THAT THE GPU MAY DECIDE TO USE MORE MEMORY INTERNALLY
      */
     size_t getTextureMemoryUsage() const;
+    
+    /*
+     * RETURNS THE RATIO BETWEEN THE AREA OCCUPIED BY GLYPHS AND THE TOTAL AREA OF THE ATLAS PAGES
+     */
+    float getTextureOccupancy() const;
+    
+    /*
+     * MUST BE INVOKED ON THE RENDER-THREAD, BEFORE DRAWING EACH FRAME
+     * DISCARDS THE LEAST-RECENTLY-DRAWN GLYPH TEXTURES IF THE BUDGET OF textureStore IS EXCEEDED
+     */
+    void beginFrame();
+    
+    /*
+     * FROM THIS POINT: GLYPHS WILL BE RASTERIZED ON workerCount BACKGROUND-THREADS
+     * AND SKIPPED WHEN DRAWN BEFORE THEIR TEXTURE IS READY
+     *
+     * NO-OP IF ALREADY ENABLED
+     */
+    void enableAsyncRasterization(int workerCount = 2);
+    
+    /*
+     * MUST BE INVOKED ON THE RENDER-THREAD, TYPICALLY ONCE PER FRAME
+     * UPLOADS THE TEXTURES OF (UP TO) budget GLYPHS RASTERIZED IN THE BACKGROUND
+     */
+    int uploadGlyphs(int budget = 32);
+    
+    size_t getPendingGlyphCount() const;
+    
+    /*
+     * FROM THIS POINT: RASTERIZED GLYPHS WILL BE PERSISTED IN directory (ONE FILE PER ActualFont, UP TO maxFileSize BYTES)
+     * AND RELOADED FROM THERE IN FURTHER SESSIONS, WITHOUT INVOLVING FREETYPE
+     *
+     * NOT AVAILABLE ON WINDOWS
+     */
+    void enableDiskCache(const ci::fs::path &directory, size_t maxFileSize = 8 * 1024 * 1024);
+    
+    /*
+     * FROM THIS POINT: THE ActualFont INSTANCES OF NEWLY-CREATED VirtualFont INSTANCES WILL BE LOADED ONLY WHEN NECESSARY
+     * (I.E. WHEN SOME TEXT-RUN IS COVERED BY THE FONT), BASED ON THE METADATA PERSISTED IN filePath (SEE FontIndex)
+     * THE LAYOUTS AND THEIR METRICS ARE THE SAME AS WITHOUT A FontIndex: THE FONTS NOT LOADED ARE STILL TAKING PART IN THE LINE'S METRICS
+     *
+     * SHOULD BE INVOKED BEFORE CREATING ANY VirtualFont
+     * NO-OP IF ALREADY ENABLED
+     */
+    void enableFontIndex(const ci::fs::path &filePath);
 
 protected:
     int platform;
@@ -94,11 +148,21 @@ protected:
     std::map<std::tuple<std::string, VirtualFont::Style, float>, std::shared_ptr<VirtualFont>> shortcuts;
     std::map<std::string, std::string> aliases;
     
+    std::unique_ptr<GlyphRasterizer> rasterizer; // MUST BE DESTROYED AFTER ALL THE ActualFont INSTANCES
+    
+    ci::fs::path diskCacheDirectory;
+    size_t diskCacheMaxFileSize;
+    
     std::map<VirtualFont::Key, std::shared_ptr<VirtualFont>> virtualFonts;
+    std::unique_ptr<FontIndex> fontIndex; // MUST BE DESTROYED AFTER ALL THE ActualFont INSTANCES
+    std::map<FontFace::Key, std::unique_ptr<FontFace>> fontFaces; // MUST BE DESTROYED AFTER ALL THE ActualFont INSTANCES
     std::map<ActualFont::Key, std::unique_ptr<ActualFont>> actualFonts;
 
-    ActualFont* getActualFont(const ActualFont::Descriptor &descriptor, float baseSize, bool useMipmap = false);
+    FontFace* getFontFace(const ActualFont::Descriptor &descriptor);
+    ActualFont* getActualFont(const ActualFont::Descriptor &descriptor, float baseSize, bool useMipmap = false, bool useDistanceField = false);
 
     static std::vector<std::string> splitLanguages(const std::string &languages);
     static ActualFont::Descriptor parseDescriptor(const ci::XmlTree &element);
+    
+    friend class Measurement;
 };
@@ -11,12 +11,17 @@
 #include <ft2build.h>
 #include FT_GLYPH_H
 #include FT_TRUETYPE_TABLES_H
+#include FT_SIZES_H
+
+#include "cinder/Thread.h"
 
 class FreetypeHelper
 {
     FT_Library library;
     
 public:
+    std::mutex mutex; // SERIALIZING THE CREATION AND DESTRUCTION OF THE FT_Face INSTANCES (SEE FontFace::acquire)
+    
     FreetypeHelper();
     ~FreetypeHelper();
     
@@ -0,0 +1,251 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+#include "GlyphAtlas.h"
+
+#include "chronotext/utils/MathUtils.h"
+
+using namespace std;
+using namespace chr;
+
+const int MIN_PAGE_SIZE = 128;
+
+GlyphAtlas::GlyphAtlas(bool useMipmap, int maxPageSize, size_t maxPages)
+:
+useMipmap(useMipmap),
+maxPageSize(maxPageSize),
+maxPages(maxPages)
+{
+    /*
+     * THE PADDING SURROUNDING EACH GLYPH (DEFINED IN ActualFont) IS NOT ENOUGH WHEN MIPMAPPING IS USED:
+     * EACH LEVEL OF THE MIPMAP-CHAIN IS AVERAGING 2x2 TEXELS OF THE PREVIOUS LEVEL,
+     * SO THAT NEIGHBOURING GLYPHS WOULD "BLEED" INTO EACH-OTHER
+     *
+     * SNAPPING EACH RECTANGLE TO MULTIPLES OF 4 IS KEEPING THE GLYPHS SEPARATED
+     * AT LEAST UNTIL THE 3RD LEVEL (I.E. WHEN THE TEXT IS SCALED-DOWN BY 4)
+     */
+    alignment = useMipmap ? 4 : 1;
+}
+
+GlyphAtlas::Location GlyphAtlas::add(const GlyphData &glyphData)
+{
+    Location location;
+
+    int width = glyphData.width + glyphData.padding * 2;
+    int height = glyphData.height + glyphData.padding * 2;
+
+    if ((width <= maxPageSize) && (height <= maxPageSize))
+    {
+        Page *target = NULL;
+        int x, y;
+
+        for (auto &page : pages)
+        {
+            if (allocate(*page, width, height, x, y))
+            {
+                target = page.get();
+                break;
+            }
+        }
+
+        if (!target && (pages.size() < maxPages))
+        {
+            /*
+             * EACH NEW PAGE IS TWICE AS LARGE AS THE PREVIOUS ONE, UNTIL maxPageSize IS REACHED
+             */
+            int pageSize = std::min(maxPageSize, nextPowerOfTwo(std::max<int>(MIN_PAGE_SIZE << pages.size(), std::max(width, height))));
+            pages.emplace_back(new Page(pageSize, useMipmap));
+
+            if (allocate(*pages.back(), width, height, x, y))
+            {
+                target = pages.back().get();
+            }
+        }
+
+        if (target)
+        {
+            copy(*target, glyphData, x, y);
+
+            location.texture = target->texture.get();
+            location.u1 = x / float(target->size);
+            location.v1 = y / float(target->size);
+            location.u2 = (x + width) / float(target->size);
+            location.v2 = (y + height) / float(target->size);
+        }
+    }
+
+    return location;
+}
+
+bool GlyphAtlas::contains(const ReloadableTexture *texture) const
+{
+    for (auto &page : pages)
+    {
+        if (page->texture.get() == texture)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void GlyphAtlas::reload(ReloadableTexture *texture)
+{
+    for (auto &page : pages)
+    {
+        if (page->texture.get() == texture)
+        {
+            if (!texture->isLoaded())
+            {
+                texture->upload(page->data.data());
+            }
+            
+            break;
+        }
+    }
+}
+
+/*
+ * THIS IS NOT DESTROYING THE ReloadableTexture INSTANCES
+ * I.E. THE POINTER INSIDE Location REMAINS VALID
+ */
+void GlyphAtlas::discardTextures()
+{
+    for (auto &page : pages)
+    {
+        page->texture->unload();
+    }
+}
+
+void GlyphAtlas::clear()
+{
+    pages.clear();
+}
+
+void GlyphAtlas::getTextures(vector<ReloadableTexture*> &textures) const
+{
+    for (auto &page : pages)
+    {
+        textures.push_back(page->texture.get());
+    }
+}
+
+size_t GlyphAtlas::getMemoryUsage() const
+{
+    size_t total = 0;
+
+    for (auto &page : pages)
+    {
+        total += page->texture->getMemoryUsage();
+    }
+
+    return total;
+}
+
+size_t GlyphAtlas::getPageCount() const
+{
+    return pages.size();
+}
+
+float GlyphAtlas::getOccupancy() const
+{
+    if (pages.empty())
+    {
+        return 0;
+    }
+
+    size_t usedArea = 0;
+    size_t totalArea = 0;
+
+    for (auto &page : pages)
+    {
+        usedArea += page->usedArea;
+        totalArea += page->size * page->size;
+    }
+
+    return usedArea / float(totalArea);
+}
+
+/*
+ * "BEST-FIT" AMONG THE EXISTING SHELVES, OTHERWISE A NEW SHELF IS OPENED AT THE BOTTOM OF THE PAGE
+ */
+bool GlyphAtlas::allocate(Page &page, int width, int height, int &x, int &y)
+{
+    int alignedWidth = (width + alignment - 1) / alignment * alignment;
+    int alignedHeight = (height + alignment - 1) / alignment * alignment;
+
+    Shelf *best = NULL;
+
+    for (auto &shelf : page.shelves)
+    {
+        if ((alignedHeight <= shelf.height) && (shelf.x + alignedWidth <= page.size))
+        {
+            if (!best || (shelf.height < best->height))
+            {
+                best = &shelf;
+            }
+        }
+    }
+
+    if (!best)
+    {
+        if ((page.bottom + alignedHeight <= page.size) && (alignedWidth <= page.size))
+        {
+            page.shelves.emplace_back(page.bottom, alignedHeight);
+            page.bottom += alignedHeight;
+
+            best = &page.shelves.back();
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    x = best->x;
+    y = best->y;
+
+    best->x += alignedWidth;
+    page.usedArea += width * height;
+
+    return true;
+}
+
+void GlyphAtlas::copy(Page &page, const GlyphData &glyphData, int x, int y)
+{
+    int width = glyphData.width;
+    int height = glyphData.height;
+    int padding = glyphData.padding;
+    auto buffer = glyphData.getBuffer();
+
+    for (int iy = 0; iy < height; iy++)
+    {
+        memcpy(&page.data[(y + padding + iy) * page.size + (x + padding)], buffer + iy * width, width);
+    }
+
+    // ---
+
+    if (page.texture->isLoaded())
+    {
+        int boxWidth = width + padding * 2;
+        int boxHeight = height + padding * 2;
+        vector<unsigned char> box(boxWidth * boxHeight);
+
+        for (int iy = 0; iy < boxHeight; iy++)
+        {
+            memcpy(&box[iy * boxWidth], &page.data[(y + iy) * page.size + x], boxWidth);
+        }
+
+        page.texture->update(box.data(), x, y, boxWidth, boxHeight);
+    }
+    else
+    {
+        page.texture->upload(page.data.data());
+    }
+}
@@ -0,0 +1,107 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+/*
+ * UP TO N "ALPHA" PAGES, FILLED VIA "SHELF PACKING"
+ *
+ * THE FIRST PAGES ARE SMALLER, SO THAT FONTS USED FOR A HANDFUL OF GLYPHS
+ * (E.G. A FALLBACK FONT) ARE NOT WASTING A WHOLE maxPageSize PAGE
+ *
+ * EACH PAGE IS KEEPING A COPY OF ITS PIXELS IN MEMORY:
+ * - NECESSARY FOR RELOADING AFTER OPENGL CONTEXT-LOSS
+ * - ALLOWING TO ADD GLYPHS ON-THE-FLY, EVEN WHEN MIPMAPPING IS USED
+ *   (THE MIPMAP-CHAIN IS REGENERATED UPON EACH ADDITION)
+ */
+
+#pragma once
+
+#include "ReloadableTexture.h"
+
+#include <vector>
+#include <memory>
+
+class GlyphAtlas
+{
+public:
+    struct Location
+    {
+        ReloadableTexture *texture;
+
+        float u1;
+        float v1;
+        float u2;
+        float v2;
+
+        Location()
+        :
+        texture(NULL)
+        {}
+    };
+
+    GlyphAtlas(bool useMipmap, int maxPageSize = 512, size_t maxPages = 8);
+
+    /*
+     * RETURNS A Location WITH A NULL texture IF THE GLYPH CAN'T FIT
+     * (I.E. IF IT IS TOO LARGE OR IF ALL THE PAGES ARE FULL)
+     */
+    Location add(const GlyphData &glyphData);
+
+    bool contains(const ReloadableTexture *texture) const;
+    void reload(ReloadableTexture *texture); // RE-UPLOADS A PAGE WHICH HAS BEEN DISCARDED
+    void discardTextures();
+    void clear();
+
+    void getTextures(std::vector<ReloadableTexture*> &textures) const;
+    size_t getMemoryUsage() const;
+    size_t getPageCount() const;
+    float getOccupancy() const; // RATIO BETWEEN THE AREA USED BY GLYPHS AND THE TOTAL AREA OF THE PAGES
+
+protected:
+    struct Shelf
+    {
+        int y;
+        int height;
+        int x; // NEXT FREE POSITION
+
+        Shelf(int y, int height)
+        :
+        y(y),
+        height(height),
+        x(0)
+        {}
+    };
+
+    struct Page
+    {
+        int size;
+        std::unique_ptr<ReloadableTexture> texture;
+        std::vector<unsigned char> data;
+        std::vector<Shelf> shelves;
+        int bottom;
+        size_t usedArea;
+
+        Page(int size, bool useMipmap)
+        :
+        size(size),
+        texture(new ReloadableTexture(size, size, useMipmap)),
+        data(size * size, 0),
+        bottom(0),
+        usedArea(0)
+        {}
+    };
+
+    bool useMipmap;
+    int maxPageSize;
+    size_t maxPages;
+    int alignment;
+
+    std::vector<std::unique_ptr<Page>> pages;
+
+    bool allocate(Page &page, int width, int height, int &x, int &y);
+    void copy(Page &page, const GlyphData &glyphData, int x, int y);
+};
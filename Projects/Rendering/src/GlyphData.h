@@ -15,30 +15,51 @@
 #pragma once
 
 #include "FreetypeHelper.h"
+#include "DistanceField.h"
 
 #include "cinder/Vector.h"
 
 class GlyphData
 {
 public:
+    /*
+     * DISTANCE-FIELDS ARE STORED AT HALF THE RESOLUTION OF THE FONT'S baseSize
+     * AND ARE SATURATING AT DISTANCE_FIELD_SPREAD TEXELS FROM THE EDGES
+     */
+    static const int DISTANCE_FIELD_DOWNSAMPLE = 2;
+    static const int DISTANCE_FIELD_SPREAD = 2;
+    
     bool useMipmap;
     int padding;
+    bool useDistanceField;
     
     int width;
     int height;
     ci::Vec2f offset;
     ci::Vec2f size;
     
-    GlyphData(FT_Face ftFace, uint32_t codepoint, bool useMipmap, int padding)
+    /*
+     * IN CASE OF A DISTANCE-FIELD:
+     * - width AND height ARE IN TEXELS
+     * - offset AND size ARE (AS USUAL) IN baseSize UNITS
+     * - THE DATA IS NOT DEPENDING ON THE FT_Face (I.E. NO NEED TO INVOKE copyDataAndReleaseSlot())
+     */
+    GlyphData(FT_Face ftFace, uint32_t codepoint, bool useMipmap, int padding, bool useDistanceField = false)
     :
     useMipmap(useMipmap),
     padding(padding),
+    useDistanceField(useDistanceField),
     ftGlyph(NULL),
     data(NULL)
     {
         if (codepoint > 0)
         {
-            if (!FT_Load_Glyph(ftFace, codepoint, FT_LOAD_DEFAULT | FT_LOAD_FORCE_AUTOHINT))
+            /*
+             * HINTING IS SPECIFIC TO A GIVEN SIZE: IT WOULD DISTORT A DISTANCE-FIELD SERVING ALL THE SIZES
+             */
+            auto loadFlags = FT_LOAD_DEFAULT | (useDistanceField ? FT_LOAD_NO_HINTING : FT_LOAD_FORCE_AUTOHINT);
+            
+            if (!FT_Load_Glyph(ftFace, codepoint, loadFlags))
             {
                 ftSlot = ftFace->glyph;
                 
@@ -49,7 +70,19 @@ public:
                     width = ftSlot->bitmap.width;
                     height = ftSlot->bitmap.rows;
                     
-                    if (width * height > 0)
+                    if ((width * height > 0) && useDistanceField)
+                    {
+                        int scale = DISTANCE_FIELD_DOWNSAMPLE;
+                        int border = DISTANCE_FIELD_SPREAD * scale;
+                        
+                        data = DistanceField::create(ftSlot->bitmap.buffer, width, height, DISTANCE_FIELD_SPREAD, scale, width, height);
+                        offset = ci::Vec2f(ftSlot->bitmap_left - border, -ftSlot->bitmap_top - border) - ci::Vec2f(padding, padding) * scale;
+                        size = (ci::Vec2f(width, height) + ci::Vec2f(padding, padding) * 2) * scale;
+                        
+                        FT_Done_Glyph(ftGlyph);
+                        ftGlyph = NULL;
+                    }
+                    else if (width * height > 0)
                     {
                         offset = ci::Vec2f(ftSlot->bitmap_left, -ftSlot->bitmap_top) - ci::Vec2f(padding, padding);
                         size = ci::Vec2f(width, height) + ci::Vec2f(padding, padding) * 2;
@@ -64,6 +97,29 @@ public:
         }
     }
     
+    /*
+     * FOR GLYPHS WHICH HAVE BEEN RASTERIZED PREVIOUSLY (E.G. BY GlyphDiskCache)
+     * buffer IS COPIED, AND SHOULD CONTAIN (width * height) BYTES, OR BE NULL FOR A TEXTURELESS GLYPH
+     */
+    GlyphData(bool useMipmap, int padding, bool useDistanceField, int width, int height, const ci::Vec2f &offset, const ci::Vec2f &size, const unsigned char *buffer)
+    :
+    useMipmap(useMipmap),
+    padding(padding),
+    useDistanceField(useDistanceField),
+    width(width),
+    height(height),
+    offset(offset),
+    size(size),
+    ftGlyph(NULL),
+    data(NULL)
+    {
+        if (buffer && (width * height > 0))
+        {
+            data = (unsigned char*)malloc(width * height);
+            memcpy(data, buffer, width * height);
+        }
+    }
+    
     ~GlyphData()
     {
         if (ftGlyph)
@@ -0,0 +1,367 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+#include "GlyphDiskCache.h"
+
+#include "chronotext/utils/Utils.h"
+
+#if !defined(CINDER_MSW)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include <vector>
+#include <cstddef>
+
+using namespace std;
+using namespace ci;
+
+const char MAGIC[4] = {'G', 'L', 'Y', 'C'};
+const int MAX_GLYPH_DIMENSION = 4096; // ANYTHING LARGER IS CONSIDERED AS CORRUPTED
+
+GlyphDiskCache::GlyphDiskCache()
+:
+fd(-1),
+mappedData(NULL),
+mappedSize(0),
+fileSize(0),
+maxFileSize(0)
+{}
+
+GlyphDiskCache::~GlyphDiskCache()
+{
+    close();
+}
+
+bool GlyphDiskCache::open(const fs::path &filePath, uint64_t signature, size_t maxFileSize)
+{
+    close();
+    
+#if defined(CINDER_MSW)
+    return false;
+#else
+    lock_guard<std::mutex> lock(mutex);
+    this->maxFileSize = maxFileSize;
+    
+    try
+    {
+        fs::create_directories(filePath.parent_path());
+    }
+    catch (exception &e)
+    {
+        LOGD << "GlyphDiskCache: " << e.what() << endl;
+        return false;
+    }
+    
+    fd = ::open(filePath.string().c_str(), O_RDWR | O_CREAT, 0644);
+    
+    if (fd < 0)
+    {
+        LOGD << "GlyphDiskCache: CAN'T OPEN " << filePath.string() << endl;
+        return false;
+    }
+    
+    struct stat info;
+    
+    if (!fstat(fd, &info) && (size_t(info.st_size) >= sizeof(Header)))
+    {
+        auto mapping = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        
+        if (mapping != MAP_FAILED)
+        {
+            mappedData = (const unsigned char*)mapping;
+            mappedSize = info.st_size;
+            
+            Header header;
+            memcpy(&header, mappedData, sizeof(Header));
+            
+            if (!memcmp(header.magic, MAGIC, 4) && (header.version == VERSION) && (header.signature == signature))
+            {
+                fileSize = parse();
+                
+                /*
+                 * DISCARDING THE CORRUPTED OR TRUNCATED PART, IF ANY
+                 * (THE RECORDS STORED FROM THIS POINT WILL BE APPENDED AFTER THE LAST VALID ONE)
+                 */
+                if (fileSize < mappedSize)
+                {
+                    LOGD << "GlyphDiskCache: TRUNCATING " << filePath.string() << " AT " << fileSize << " BYTES" << endl;
+                    
+                    munmap((void*)mappedData, mappedSize);
+                    mappedData = NULL;
+                    mappedSize = 0;
+                    
+                    if (ftruncate(fd, fileSize))
+                    {
+                        ::close(fd); fd = -1;
+                        return false;
+                    }
+                    
+                    mapping = mmap(NULL, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+                    
+                    if (mapping != MAP_FAILED)
+                    {
+                        mappedData = (const unsigned char*)mapping;
+                        mappedSize = fileSize;
+                    }
+                }
+                
+                return true;
+            }
+        }
+    }
+    
+    if (!reset(signature))
+    {
+        ::close(fd); fd = -1;
+        return false;
+    }
+    
+    return true;
+#endif
+}
+
+void GlyphDiskCache::close()
+{
+    lock_guard<std::mutex> lock(mutex);
+    
+#if !defined(CINDER_MSW)
+    if (mappedData)
+    {
+        munmap((void*)mappedData, mappedSize);
+        mappedData = NULL;
+        mappedSize = 0;
+    }
+    
+    if (fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+#endif
+    
+    offsets.clear();
+    fileSize = 0;
+}
+
+bool GlyphDiskCache::isOpen() const
+{
+    lock_guard<std::mutex> lock(mutex);
+    return (fd >= 0);
+}
+
+GlyphData* GlyphDiskCache::load(uint32_t codepoint, bool useMipmap, int padding, bool useDistanceField)
+{
+    lock_guard<std::mutex> lock(mutex);
+    
+#if !defined(CINDER_MSW)
+    auto it = offsets.find(codepoint);
+    
+    if (it != offsets.end())
+    {
+        auto offset = it->second;
+        
+        Record record;
+        const unsigned char *bitmap;
+        vector<unsigned char> buffer;
+        
+        if (offset < mappedSize)
+        {
+            memcpy(&record, mappedData + offset, sizeof(Record));
+            bitmap = mappedData + offset + sizeof(Record);
+        }
+        else
+        {
+            /*
+             * THE RECORD WAS STORED AFTER THE FILE WAS MAPPED
+             */
+            if (pread(fd, &record, sizeof(Record), offset) != sizeof(Record))
+            {
+                return NULL;
+            }
+            
+            buffer.resize(record.width * record.height);
+            
+            if (pread(fd, buffer.data(), buffer.size(), offset + sizeof(Record)) != ssize_t(buffer.size()))
+            {
+                return NULL;
+            }
+            
+            bitmap = buffer.data();
+        }
+        
+        return new GlyphData(useMipmap, padding, useDistanceField, record.width, record.height, Vec2f(record.offsetX, record.offsetY), Vec2f(record.sizeX, record.sizeY), bitmap);
+    }
+#endif
+    
+    return NULL;
+}
+
+void GlyphDiskCache::store(uint32_t codepoint, const GlyphData &glyphData)
+{
+    lock_guard<std::mutex> lock(mutex);
+    
+#if !defined(CINDER_MSW)
+    if ((fd >= 0) && !offsets.count(codepoint))
+    {
+        Record record;
+        memset(&record, 0, sizeof(Record));
+        record.codepoint = codepoint;
+        
+        if (glyphData.isValid())
+        {
+            record.width = glyphData.width;
+            record.height = glyphData.height;
+            record.offsetX = glyphData.offset.x;
+            record.offsetY = glyphData.offset.y;
+            record.sizeX = glyphData.size.x;
+            record.sizeY = glyphData.size.y;
+        }
+        
+        size_t bitmapSize = record.width * record.height;
+        size_t recordSize = sizeof(Record) + bitmapSize;
+        
+        if (fileSize + recordSize <= maxFileSize)
+        {
+            record.checksum = computeChecksum(record, glyphData.getBuffer());
+            
+            vector<unsigned char> buffer(recordSize);
+            memcpy(buffer.data(), &record, sizeof(Record));
+            
+            if (bitmapSize)
+            {
+                memcpy(buffer.data() + sizeof(Record), glyphData.getBuffer(), bitmapSize);
+            }
+            
+            if (pwrite(fd, buffer.data(), recordSize, fileSize) == ssize_t(recordSize))
+            {
+                offsets[codepoint] = fileSize;
+                fileSize += recordSize;
+            }
+            else
+            {
+                /*
+                 * E.G. IF THE DISK IS FULL: NO FURTHER ATTEMPTS
+                 */
+                if (ftruncate(fd, fileSize))
+                {}
+                
+                maxFileSize = fileSize;
+            }
+        }
+    }
+#endif
+}
+
+size_t GlyphDiskCache::getFileSize() const
+{
+    lock_guard<std::mutex> lock(mutex);
+    return fileSize;
+}
+
+uint64_t GlyphDiskCache::hash(const void *data, size_t size, uint64_t seed)
+{
+    auto bytes = (const unsigned char*)data;
+    uint64_t value = seed;
+    
+    for (size_t i = 0; i < size; i++)
+    {
+        value ^= bytes[i];
+        value *= 1099511628211ULL;
+    }
+    
+    return value;
+}
+
+void GlyphDiskCache::clear(const fs::path &directory)
+{
+    if (fs::exists(directory))
+    {
+        for (fs::directory_iterator it(directory), end; it != end; ++it)
+        {
+            if (it->path().extension() == ".glyphs")
+            {
+                fs::remove(it->path());
+            }
+        }
+    }
+}
+
+bool GlyphDiskCache::reset(uint64_t signature)
+{
+#if defined(CINDER_MSW)
+    return false;
+#else
+    if (mappedData)
+    {
+        munmap((void*)mappedData, mappedSize);
+        mappedData = NULL;
+        mappedSize = 0;
+    }
+    
+    offsets.clear();
+    
+    Header header;
+    memcpy(header.magic, MAGIC, 4);
+    header.version = VERSION;
+    header.signature = signature;
+    
+    if (!ftruncate(fd, 0) && (pwrite(fd, &header, sizeof(Header), 0) == sizeof(Header)))
+    {
+        fileSize = sizeof(Header);
+        return true;
+    }
+    
+    return false;
+#endif
+}
+
+/*
+ * RETURNS THE SIZE OF THE VALID PART OF THE FILE
+ */
+size_t GlyphDiskCache::parse()
+{
+    size_t offset = sizeof(Header);
+    
+    while (offset + sizeof(Record) <= mappedSize)
+    {
+        Record record;
+        memcpy(&record, mappedData + offset, sizeof(Record));
+        
+        if ((record.width < 0) || (record.height < 0) || (record.width > MAX_GLYPH_DIMENSION) || (record.height > MAX_GLYPH_DIMENSION))
+        {
+            break;
+        }
+        
+        size_t recordSize = sizeof(Record) + record.width * record.height;
+        
+        if ((offset + recordSize > mappedSize) || (record.checksum != computeChecksum(record, mappedData + offset + sizeof(Record))))
+        {
+            break;
+        }
+        
+        offsets[record.codepoint] = offset;
+        offset += recordSize;
+    }
+    
+    return offset;
+}
+
+uint32_t GlyphDiskCache::computeChecksum(const Record &record, const unsigned char *bitmap)
+{
+    auto value = hash(&record, offsetof(Record, checksum));
+    
+    if (record.width * record.height > 0)
+    {
+        value = hash(bitmap, record.width * record.height, value);
+    }
+    
+    return uint32_t(value ^ (value >> 32));
+}
@@ -0,0 +1,98 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+/*
+ * PERSISTENT CACHE OF RASTERIZED GLYPHS, ALLOWING TO SKIP FREETYPE ACROSS SESSIONS
+ *
+ * - ONE FILE PER ActualFont, MEMORY-MAPPED UPON OPENING
+ * - THE FILE'S HEADER IS HOLDING A SIGNATURE (COMPUTED FROM THE ActualFont::Key, THE FONT'S CHECKSUM,
+ *   THE RASTERIZATION PARAMETERS AND THE FREETYPE VERSION): UPON MISMATCH, THE FILE IS RESET
+ * - RECORDS ARE APPENDED DURING THE SESSION, UNTIL maxFileSize IS REACHED
+ * - EACH RECORD IS CHECKSUMMED: A CORRUPTED OR TRUNCATED RECORD IS ENDING THE FILE
+ * - THREAD-SAFE (load() AND store() CAN BE INVOKED BY GlyphRasterizer)
+ *
+ * NOT AVAILABLE ON WINDOWS (open() WILL RETURN FALSE)
+ */
+
+#pragma once
+
+#include "GlyphData.h"
+
+#include "cinder/Filesystem.h"
+#include "cinder/Thread.h"
+
+#include <map>
+
+class GlyphDiskCache
+{
+public:
+    static const uint32_t VERSION = 1; // MUST BE INCREMENTED WHENEVER THE FORMAT OR THE RASTERIZATION IS CHANGING
+    
+    GlyphDiskCache();
+    ~GlyphDiskCache();
+    
+    /*
+     * name IS SUPPOSED TO BE UNIQUE FOR EACH ActualFont::Key (SEE ActualFont::openDiskCache())
+     * RETURNS FALSE IF THE FILE CAN'T BE OPENED OR CREATED
+     */
+    bool open(const ci::fs::path &filePath, uint64_t signature, size_t maxFileSize);
+    void close();
+    bool isOpen() const;
+    
+    /*
+     * RETURNS NULL IF THERE IS NO RECORD FOR codepoint
+     * THE RETURNED INSTANCE IS NOT MANAGED AND SHOULD BE DELETED BY THE CALLER
+     */
+    GlyphData* load(uint32_t codepoint, bool useMipmap, int padding, bool useDistanceField);
+    
+    /*
+     * TEXTURELESS GLYPHS (E.G. A "SPACE") ARE STORED AS WELL
+     * glyphData MUST NOT BE DEPENDING ON AN FT_Face (SEE GlyphData::copyDataAndReleaseSlot())
+     */
+    void store(uint32_t codepoint, const GlyphData &glyphData);
+    
+    size_t getFileSize() const;
+    
+    static uint64_t hash(const void *data, size_t size, uint64_t seed = 14695981039346656037ULL); // FNV-1A
+    static void clear(const ci::fs::path &directory); // REMOVES ALL THE CACHE-FILES FROM directory
+    
+protected:
+    struct Header
+    {
+        char magic[4];
+        uint32_t version;
+        uint64_t signature;
+    };
+    
+    struct Record
+    {
+        uint32_t codepoint;
+        int32_t width;
+        int32_t height;
+        float offsetX;
+        float offsetY;
+        float sizeX;
+        float sizeY;
+        uint32_t checksum; // OF THE PREVIOUS FIELDS AND OF THE BITMAP
+    };
+    
+    mutable std::mutex mutex;
+    int fd;
+    
+    const unsigned char *mappedData;
+    size_t mappedSize;
+    size_t fileSize;
+    size_t maxFileSize;
+    
+    std::map<uint32_t, size_t> offsets; // THE OFFSET OF EACH RECORD IN THE FILE
+    
+    bool reset(uint64_t signature);
+    size_t parse();
+    
+    static uint32_t computeChecksum(const Record &record, const unsigned char *bitmap);
+};
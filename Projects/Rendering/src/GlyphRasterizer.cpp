@@ -0,0 +1,128 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+#include "GlyphRasterizer.h"
+#include "ActualFont.h"
+
+#include <algorithm>
+
+using namespace std;
+
+GlyphRasterizer::GlyphRasterizer(int workerCount)
+:
+exiting(false),
+busyFonts(workerCount, NULL)
+{
+    for (int i = 0; i < workerCount; i++)
+    {
+        workers.emplace_back(&GlyphRasterizer::run, this, i);
+    }
+}
+
+GlyphRasterizer::~GlyphRasterizer()
+{
+    {
+        lock_guard<std::mutex> lock(mutex);
+        exiting = true;
+    }
+    
+    jobAvailable.notify_all();
+    
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void GlyphRasterizer::request(ActualFont *font, uint32_t codepoint)
+{
+    {
+        lock_guard<std::mutex> lock(mutex);
+        jobs.emplace_back(font, codepoint);
+    }
+    
+    jobAvailable.notify_one();
+}
+
+void GlyphRasterizer::cancel(ActualFont *font)
+{
+    auto belongsToFont = [=](const Job &job) { return job.font == font; };
+    
+    unique_lock<std::mutex> lock(mutex);
+    jobs.erase(remove_if(jobs.begin(), jobs.end(), belongsToFont), jobs.end());
+    
+    jobDone.wait(lock, [=]{ return find(busyFonts.begin(), busyFonts.end(), font) == busyFonts.end(); });
+    results.erase(remove_if(results.begin(), results.end(), belongsToFont), results.end());
+}
+
+int GlyphRasterizer::upload(int budget)
+{
+    int count = 0;
+    
+    while (count < budget)
+    {
+        Job job;
+        
+        {
+            lock_guard<std::mutex> lock(mutex);
+            
+            if (results.empty())
+            {
+                break;
+            }
+            
+            job = move(results.front());
+            results.pop_front();
+        }
+        
+        if (job.font->addGlyph(job.codepoint, *job.glyphData))
+        {
+            count++;
+        }
+    }
+    
+    return count;
+}
+
+size_t GlyphRasterizer::getPendingCount() const
+{
+    lock_guard<std::mutex> lock(mutex);
+    return jobs.size() + results.size() + (busyFonts.size() - count(busyFonts.begin(), busyFonts.end(), (ActualFont*)NULL));
+}
+
+void GlyphRasterizer::run(int workerIndex)
+{
+    while (true)
+    {
+        Job job;
+        
+        {
+            unique_lock<std::mutex> lock(mutex);
+            jobAvailable.wait(lock, [this]{ return exiting || !jobs.empty(); });
+            
+            if (exiting)
+            {
+                return;
+            }
+            
+            job = move(jobs.front());
+            jobs.pop_front();
+            busyFonts[workerIndex] = job.font;
+        }
+        
+        job.glyphData = unique_ptr<GlyphData>(job.font->rasterize(job.codepoint));
+        
+        {
+            lock_guard<std::mutex> lock(mutex);
+            busyFonts[workerIndex] = NULL;
+            results.push_back(move(job));
+        }
+        
+        jobDone.notify_all();
+    }
+}
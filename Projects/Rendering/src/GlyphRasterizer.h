@@ -0,0 +1,81 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+/*
+ * RASTERIZING GLYPHS ON WORKER-THREADS, SO THAT THE FIRST APPEARANCE OF SOME TEXT
+ * (E.G. A LINE OF CJK CHARACTERS) IS NOT STALLING THE RENDER-THREAD
+ *
+ * - THE WORKERS ARE USING THE FT_Face OF EACH ActualFont, PROTECTED BY FontFace::mutex
+ * - THE GlyphData INSTANCES ARE "DETACHED" FROM THEIR FT_Face VIA copyDataAndReleaseSlot()
+ *   BEFORE LEAVING THE WORKER-THREAD
+ * - TEXTURE-UPLOADS ARE TAKING PLACE ON THE RENDER-THREAD, VIA upload()
+ */
+
+#pragma once
+
+#include "GlyphData.h"
+
+#include "cinder/Thread.h"
+
+#include <deque>
+#include <vector>
+#include <memory>
+
+class ActualFont;
+
+class GlyphRasterizer
+{
+public:
+    GlyphRasterizer(int workerCount = 2);
+    ~GlyphRasterizer();
+    
+    void request(ActualFont *font, uint32_t codepoint);
+    
+    /*
+     * DROPS THE QUEUED AND FINISHED JOBS OF font, AFTER WAITING FOR THE ONES IN PROGRESS
+     * MUST BE INVOKED BEFORE font IS UNLOADED
+     */
+    void cancel(ActualFont *font);
+    
+    /*
+     * MUST BE INVOKED ON THE RENDER-THREAD
+     * RETURNS THE NUMBER OF UPLOADED GLYPHS (TEXTURELESS GLYPHS ARE NOT COUNTED IN budget)
+     */
+    int upload(int budget);
+    
+    size_t getPendingCount() const; // QUEUED, IN PROGRESS OR WAITING FOR UPLOAD
+
+protected:
+    struct Job
+    {
+        ActualFont *font;
+        uint32_t codepoint;
+        std::unique_ptr<GlyphData> glyphData;
+        
+        Job()
+        {}
+        
+        Job(ActualFont *font, uint32_t codepoint)
+        :
+        font(font),
+        codepoint(codepoint)
+        {}
+    };
+    
+    mutable std::mutex mutex;
+    std::condition_variable jobAvailable;
+    std::condition_variable jobDone;
+    bool exiting;
+    
+    std::deque<Job> jobs;
+    std::deque<Job> results;
+    std::vector<ActualFont*> busyFonts; // ONE ENTRY PER WORKER, NULL WHEN IDLE
+    std::vector<std::thread> workers;
+    
+    void run(int workerIndex);
+};
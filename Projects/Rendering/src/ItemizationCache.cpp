@@ -0,0 +1,139 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+#include "ItemizationCache.h"
+
+using namespace std;
+
+ItemizationCache::ItemizationCache(size_t capacity)
+:
+enabled(true),
+capacity(capacity),
+size(0),
+hitCount(0),
+missCount(0)
+{
+    assert(capacity > 0);
+}
+
+shared_ptr<const TextLine> ItemizationCache::get(const Key &key)
+{
+    lock_guard<std::mutex> lock(mutex);
+
+    /*
+     * NON-OWNING POINTER (ALIASING-CONSTRUCTOR WITH AN EMPTY OWNER): NO ALLOCATION
+     */
+    auto it = cache.left.find(shared_ptr<const Key>(shared_ptr<const Key>(), &key));
+
+    if (it != cache.left.end())
+    {
+        /*
+         * MOVING USED-ENTRY TO THE TAIL OF THE bimaps::list_of
+         */
+        cache.right.relocate(cache.right.end(), cache.project_right(it));
+        hitCount++;
+
+        return it->second;
+    }
+
+    missCount++;
+    return NULL;
+}
+
+void ItemizationCache::add(const Key &key, shared_ptr<const TextLine> line)
+{
+    size_t newSize = getEntrySize(key, *line);
+
+    lock_guard<std::mutex> lock(mutex);
+
+    if (newSize >= capacity)
+    {
+        return;
+    }
+
+    while (size + newSize > capacity)
+    {
+        /*
+         * LEAST-RECENTLY-USED ENTRIES ARE AT THE HEAD OF THE bimaps::list_of
+         */
+        auto head = cache.right.begin();
+        size -= getEntrySize(*head->second, *head->first);
+        cache.right.erase(head);
+    }
+
+    /*
+     * NEW ENTRIES ARE INSERTED AT THE TAIL OF THE bimaps::list_of
+     */
+    if (cache.insert(container_type::value_type(make_shared<const Key>(key), line)).second)
+    {
+        size += newSize;
+    }
+}
+
+void ItemizationCache::setEnabled(bool enabled)
+{
+    this->enabled = enabled;
+}
+
+bool ItemizationCache::isEnabled() const
+{
+    return enabled;
+}
+
+void ItemizationCache::clear()
+{
+    lock_guard<std::mutex> lock(mutex);
+
+    cache.clear();
+    size = 0;
+}
+
+void ItemizationCache::setCapacity(size_t newCapacity)
+{
+    assert(newCapacity > 0);
+    lock_guard<std::mutex> lock(mutex);
+
+    if (newCapacity < size)
+    {
+        cache.clear();
+        size = 0;
+    }
+
+    capacity = newCapacity;
+}
+
+size_t ItemizationCache::getMemoryUsage() const
+{
+    lock_guard<std::mutex> lock(mutex);
+    return size;
+}
+
+uint64_t ItemizationCache::getHitCount() const
+{
+    lock_guard<std::mutex> lock(mutex);
+    return hitCount;
+}
+
+uint64_t ItemizationCache::getMissCount() const
+{
+    lock_guard<std::mutex> lock(mutex);
+    return missCount;
+}
+
+void ItemizationCache::resetCounters()
+{
+    lock_guard<std::mutex> lock(mutex);
+
+    hitCount = 0;
+    missCount = 0;
+}
+
+size_t ItemizationCache::getEntrySize(const Key &key, const TextLine &line)
+{
+    return key.text.size() + line.text.length() * sizeof(UChar) + line.runs.size() * sizeof(TextRun);
+}
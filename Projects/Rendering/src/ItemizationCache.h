@@ -0,0 +1,118 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+/*
+ * CACHE OF ITEMIZED LINES (TextItemizer::processLine()), OWNED BY FontManager AND SHARED BY ALL THE VirtualFont INSTANCES
+ *
+ * - THE RUNS ARE ONLY DEPENDING ON THE TEXT, THE LANG-HINT AND THE OVERALL-DIRECTION: UNLIKE WITH LayoutCache,
+ *   THE SAME LINE DRAWN WITH DIFFERENT FONTS, STYLES OR SIZES IS ITEMIZED ONCE
+ * - THE LANGUAGES OF THE RUNS ARE ALSO DEPENDING ON THE DEFAULT-LANGUAGES OF THE LangHelper: THE KEYS ARE INCLUDING
+ *   ITS GENERATION, I.E. THE LINES ITEMIZED BEFORE A setDefaultLanguages() ARE NOT RETURNED ANYMORE (AND EVENTUALLY EVICTED)
+ * - THE CACHED LINES ARE WITHOUT OPENTYPE-FEATURES (APPLIED BY THE CALLER, SEE VirtualFont::itemizeLine())
+ * - LEAST-RECENTLY-USED LINES ARE EVICTED WHEN capacity (IN BYTES: UTF-8 KEY, UTF-16 TEXT AND RUNS) IS EXCEEDED
+ * - THREAD-SAFE: SHARED BY THE WORKERS OF VirtualFont::createLineLayouts()
+ *   THE RETURNED LINES ARE IMMUTABLE, AND REMAIN VALID AFTER EVICTION (VIA shared_ptr)
+ */
+
+#pragma once
+
+#include "TextLine.h"
+
+#include "cinder/Thread.h"
+
+#include <boost/bimap.hpp>
+#include <boost/bimap/list_of.hpp>
+#include <boost/bimap/set_of.hpp>
+
+#include <atomic>
+#include <memory>
+
+class ItemizationCache
+{
+public:
+    struct Key
+    {
+        std::string text;
+        Language langHint;
+        hb_direction_t overallDirection;
+        uint32_t languageGeneration; // SEE LangHelper::getGeneration()
+
+        Key()
+        :
+        overallDirection(HB_DIRECTION_INVALID),
+        languageGeneration(0)
+        {}
+
+        /*
+         * REUSING THE MEMORY ALREADY ALLOCATED BY THE KEY, I.E. SUITED FOR REPEATED LOOKUPS
+         */
+        void set(const std::string &text, const Language &langHint, hb_direction_t overallDirection, uint32_t languageGeneration)
+        {
+            this->text.assign(text);
+            this->langHint = langHint;
+            this->overallDirection = overallDirection;
+            this->languageGeneration = languageGeneration;
+        }
+
+        bool operator<(const Key &rhs) const
+        {
+            return tie(languageGeneration, overallDirection, langHint, text) < tie(rhs.languageGeneration, rhs.overallDirection, rhs.langHint, rhs.text);
+        }
+    };
+
+    ItemizationCache(size_t capacity = 128 * 1024);
+
+    /*
+     * RETURNS NULL UPON MISS
+     */
+    std::shared_ptr<const TextLine> get(const Key &key);
+    void add(const Key &key, std::shared_ptr<const TextLine> line);
+
+    /*
+     * WHEN DISABLED: VirtualFont::createLineLayout() AND VirtualFont::measureLine() ARE ITEMIZING EACH LINE
+     */
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    void clear();
+    void setCapacity(size_t newCapacity);
+    size_t getMemoryUsage() const;
+
+    uint64_t getHitCount() const;
+    uint64_t getMissCount() const;
+    void resetCounters();
+
+protected:
+    /*
+     * THE KEYS ARE STORED VIA POINTERS: boost::bimap IS COPYING THE KEY PASSED TO find()
+     */
+    struct KeyPointerLess
+    {
+        bool operator()(const std::shared_ptr<const Key> &lhs, const std::shared_ptr<const Key> &rhs) const
+        {
+            return *lhs < *rhs;
+        }
+    };
+
+    typedef boost::bimaps::bimap<
+    boost::bimaps::set_of<std::shared_ptr<const Key>, KeyPointerLess>,
+    boost::bimaps::list_of<std::shared_ptr<const TextLine>>
+    > container_type;
+
+    mutable std::mutex mutex;
+
+    std::atomic<bool> enabled;
+    size_t capacity;
+    size_t size;
+    container_type cache;
+
+    uint64_t hitCount;
+    uint64_t missCount;
+
+    static size_t getEntrySize(const Key &key, const TextLine &line);
+};
@@ -15,6 +15,8 @@
 
 #include "cinder/Utilities.h"
 
+#include <algorithm>
+
 using namespace std;
 
 const std::string DEFAULT_LANGUAGES = "en:zh-cn"; // GIVING PRIORITY (BY DEFAULT) TO CHINESE OVER JAPANESE
@@ -27,8 +29,9 @@ struct HBScriptForLang
 
 /*
  * DATA FROM pango-script-lang-table.h
+ * INDEXED BY LangIndex
  */
-static const HBScriptForLang HB_SCRIPT_FOR_LANG[] =
+static constexpr HBScriptForLang HB_SCRIPT_FOR_LANG[] =
 {
     { "aa",     { HB_SCRIPT_LATIN/*62*/ } },
     { "ab",     { HB_SCRIPT_CYRILLIC/*90*/ } },
@@ -269,165 +272,305 @@ static const HBScriptForLang HB_SCRIPT_FOR_LANG[] =
     { "zu",     { HB_SCRIPT_LATIN/*52*/ } }
 };
 
-static void initScriptMap(std::map<std::string, std::vector<hb_script_t>> &scriptMap)
+/*
+ * FOR THE UNKNOWN LANGUAGES
+ */
+static constexpr HBScriptForLang UNKNOWN_LANG = { "", { HB_SCRIPT_INVALID } };
+
+struct HBSampleLanguage
+{
+    hb_script_t script;
+    const char lang[4];
+};
+
+/*
+ * DATA FROM pango-language.c
+ * SORTED BY SCRIPT-TAG (CHECKED AT COMPILE-TIME), FOR BINARY-SEARCH
+ */
+static constexpr HBSampleLanguage HB_SAMPLE_LANGUAGES[] =
+{
+    { HB_SCRIPT_ARABIC, "ar" },
+    { HB_SCRIPT_ARMENIAN, "hy" },
+    { HB_SCRIPT_BENGALI, "bn" },
+    { HB_SCRIPT_BUGINESE, "bug" },
+    { HB_SCRIPT_BUHID, "bku" },
+    { HB_SCRIPT_CANADIAN_ABORIGINAL, "iu" },
+    { HB_SCRIPT_CHEROKEE, "chr" },
+    { HB_SCRIPT_COPTIC, "cop" },
+    { HB_SCRIPT_CYRILLIC, "ru" },
+    { HB_SCRIPT_DEVANAGARI, "hi" },
+    { HB_SCRIPT_ETHIOPIC, "am" },
+    { HB_SCRIPT_GEORGIAN, "ka" },
+    { HB_SCRIPT_GREEK, "el" },
+    { HB_SCRIPT_GUJARATI, "gu" },
+    { HB_SCRIPT_GURMUKHI, "pa" },
+    { HB_SCRIPT_HANGUL, "ko" },
+    { HB_SCRIPT_HANUNOO, "hnn" },
+    { HB_SCRIPT_HEBREW, "he" },
+    { HB_SCRIPT_HIRAGANA, "ja" },
+    { HB_SCRIPT_KATAKANA, "ja" },
+    { HB_SCRIPT_KHMER, "km" },
+    { HB_SCRIPT_KANNADA, "kn" },
+    { HB_SCRIPT_LAO, "lo" },
+    { HB_SCRIPT_LATIN, "en" },
+    { HB_SCRIPT_MALAYALAM, "ml" },
+    { HB_SCRIPT_MONGOLIAN, "mn" },
+    { HB_SCRIPT_MYANMAR, "my" },
+    { HB_SCRIPT_NKO, "nqo" },
+    { HB_SCRIPT_ORIYA, "or" },
+    { HB_SCRIPT_SINHALA, "si" },
+    { HB_SCRIPT_SYLOTI_NAGRI, "syl" },
+    { HB_SCRIPT_SYRIAC, "syr" },
+    { HB_SCRIPT_TAGBANWA, "tbw" },
+    { HB_SCRIPT_TAMIL, "ta" },
+    { HB_SCRIPT_TELUGU, "te" },
+    { HB_SCRIPT_TAGALOG, "tl" },
+    { HB_SCRIPT_THAANA, "dv" },
+    { HB_SCRIPT_THAI, "th" },
+    { HB_SCRIPT_TIBETAN, "bo" },
+    { HB_SCRIPT_UGARITIC, "uga" },
+    { HB_SCRIPT_OLD_PERSIAN, "peo" }
+};
+
+static constexpr size_t LANG_COUNT = sizeof(HB_SCRIPT_FOR_LANG) / sizeof(HBScriptForLang);
+static constexpr size_t SAMPLE_COUNT = sizeof(HB_SAMPLE_LANGUAGES) / sizeof(HBSampleLanguage);
+
+static constexpr bool sortedByScript(const HBSampleLanguage *entries, size_t count)
 {
-    size_t entryCount = sizeof(HB_SCRIPT_FOR_LANG) / sizeof(HBScriptForLang);
+    return (count < 2) || ((uint32_t(entries[0].script) < uint32_t(entries[1].script)) && sortedByScript(entries + 1, count - 1));
+}
+
+static_assert(sortedByScript(HB_SAMPLE_LANGUAGES, SAMPLE_COUNT), "HB_SAMPLE_LANGUAGES MUST BE SORTED BY SCRIPT");
+
+/*
+ * THE LANGUAGE-TAGS OF HB_SCRIPT_FOR_LANG HAVE AT MOST 6 CHARACTERS: PACKED IN 64 BITS, THEY ARE THE KEYS OF LangIndex
+ * RETURNS 0 FOR THE LONGER TAGS (I.E. NOT IN THE TABLE)
+ */
+static uint64_t packTag(const char *tag)
+{
+    uint64_t key = 0;
     
-    for (int i = 0; i < entryCount; i++)
+    for (int i = 0; tag[i]; i++)
     {
-        auto entry = HB_SCRIPT_FOR_LANG[i];
+        if (i == 7)
+        {
+            return 0;
+        }
         
-        size_t scriptCount = sizeof(entry.scripts) / sizeof(hb_script_t);
-        std::vector<hb_script_t> scripts;
+        key = (key << 8) | uint8_t(tag[i]);
+    }
+    
+    return key;
+}
+
+/*
+ * OPEN-ADDRESSING HASH-TABLE OF HB_SCRIPT_FOR_LANG, I.E. LOOKING-UP A LANGUAGE IN CONSTANT-TIME
+ * CREATED ONCE PER PROCESS (NOT PER LangHelper) AND IMMUTABLE, I.E. THREAD-SAFE
+ */
+class LangIndex
+{
+public:
+    static const LangIndex& get()
+    {
+        static const LangIndex instance;
+        return instance;
+    }
+    
+    const HBScriptForLang* find(const char *tag) const
+    {
+        auto key = packTag(tag);
         
-        for (int j = 0; j < scriptCount; j++)
+        if (key)
         {
-            if (entry.scripts[j])
+            for (auto slot = hash(key); entries[slot]; slot = (slot + 1) & (SIZE - 1))
             {
-                scripts.push_back(entry.scripts[j]);
+                if (keys[slot] == key)
+                {
+                    return entries[slot];
+                }
             }
-            else
+        }
+        
+        return NULL;
+    }
+    
+protected:
+    static constexpr int BITS = 9;
+    static constexpr size_t SIZE = 1 << BITS;
+    static_assert(SIZE >= 2 * LANG_COUNT, "LangIndex IS TOO SMALL");
+    
+    uint64_t keys[SIZE];
+    const HBScriptForLang *entries[SIZE];
+    
+    static size_t hash(uint64_t key)
+    {
+        return (key * 0x9e3779b97f4a7c15ULL) >> (64 - BITS);
+    }
+    
+    LangIndex()
+    {
+        std::fill(keys, keys + SIZE, 0);
+        std::fill(entries, entries + SIZE, nullptr);
+        
+        for (auto &entry : HB_SCRIPT_FOR_LANG)
+        {
+            auto key = packTag(entry.lang);
+            auto slot = hash(key);
+            
+            while (entries[slot])
             {
-                break;
+                slot = (slot + 1) & (SIZE - 1);
             }
+            
+            keys[slot] = key;
+            entries[slot] = &entry;
         }
+    }
+};
+
+static const HBScriptForLang& findEntry(const Language &lang)
+{
+    if (!lang.empty())
+    {
+        auto entry = LangIndex::get().find(hb_language_to_string(lang.get()));
         
-        assert(scripts.size() > 0);
-        scriptMap[entry.lang] = scripts;
+        if (entry)
+        {
+            return *entry;
+        }
     }
     
-    /*
-     * DEFAULT-VALUE
-     */
-    std::vector<hb_script_t> invalid;
-    invalid.push_back(HB_SCRIPT_INVALID);
-    scriptMap[""] = invalid;
+    return UNKNOWN_LANG;
 }
 
 /*
- * DATA FROM pango-language.c
+ * THE FIRST SCRIPT OF AN ENTRY IS ALWAYS DEFINED (HB_SCRIPT_INVALID FOR UNKNOWN_LANG), THE FOLLOWING ONES ARE OPTIONAL
  */
-static void initSampleLanguageMap(std::map<hb_script_t, std::string> &sampleLanguageMap)
+static size_t getScriptCount(const HBScriptForLang &entry)
 {
-    sampleLanguageMap[HB_SCRIPT_ARABIC] = "ar";
-    sampleLanguageMap[HB_SCRIPT_ARMENIAN] = "hy";
-    sampleLanguageMap[HB_SCRIPT_BENGALI] = "bn";
-    sampleLanguageMap[HB_SCRIPT_CHEROKEE] = "chr";
-    sampleLanguageMap[HB_SCRIPT_COPTIC] = "cop";
-    sampleLanguageMap[HB_SCRIPT_CYRILLIC] = "ru";
-    sampleLanguageMap[HB_SCRIPT_DEVANAGARI] = "hi";
-    sampleLanguageMap[HB_SCRIPT_ETHIOPIC] = "am";
-    sampleLanguageMap[HB_SCRIPT_GEORGIAN] = "ka";
-    sampleLanguageMap[HB_SCRIPT_GREEK] = "el";
-    sampleLanguageMap[HB_SCRIPT_GUJARATI] = "gu";
-    sampleLanguageMap[HB_SCRIPT_GURMUKHI] = "pa";
-    sampleLanguageMap[HB_SCRIPT_HANGUL] = "ko";
-    sampleLanguageMap[HB_SCRIPT_HEBREW] = "he";
-    sampleLanguageMap[HB_SCRIPT_HIRAGANA] = "ja";
-    sampleLanguageMap[HB_SCRIPT_KANNADA] = "kn";
-    sampleLanguageMap[HB_SCRIPT_KATAKANA] = "ja";
-    sampleLanguageMap[HB_SCRIPT_KHMER] = "km";
-    sampleLanguageMap[HB_SCRIPT_LAO] = "lo";
-    sampleLanguageMap[HB_SCRIPT_LATIN] = "en";
-    sampleLanguageMap[HB_SCRIPT_MALAYALAM] = "ml";
-    sampleLanguageMap[HB_SCRIPT_MONGOLIAN] = "mn";
-    sampleLanguageMap[HB_SCRIPT_MYANMAR] = "my";
-    sampleLanguageMap[HB_SCRIPT_ORIYA] = "or";
-    sampleLanguageMap[HB_SCRIPT_SINHALA] = "si";
-    sampleLanguageMap[HB_SCRIPT_SYRIAC] = "syr";
-    sampleLanguageMap[HB_SCRIPT_TAMIL] = "ta";
-    sampleLanguageMap[HB_SCRIPT_TELUGU] = "te";
-    sampleLanguageMap[HB_SCRIPT_THAANA] = "dv";
-    sampleLanguageMap[HB_SCRIPT_THAI] = "th";
-    sampleLanguageMap[HB_SCRIPT_TIBETAN] = "bo";
-    sampleLanguageMap[HB_SCRIPT_CANADIAN_ABORIGINAL] = "iu";
-    sampleLanguageMap[HB_SCRIPT_TAGALOG] = "tl";
-    sampleLanguageMap[HB_SCRIPT_HANUNOO] = "hnn";
-    sampleLanguageMap[HB_SCRIPT_BUHID] = "bku";
-    sampleLanguageMap[HB_SCRIPT_TAGBANWA] = "tbw";
-    sampleLanguageMap[HB_SCRIPT_UGARITIC] = "uga";
-    sampleLanguageMap[HB_SCRIPT_BUGINESE] = "bug";
-    sampleLanguageMap[HB_SCRIPT_SYLOTI_NAGRI] = "syl";
-    sampleLanguageMap[HB_SCRIPT_OLD_PERSIAN] = "peo";
-    sampleLanguageMap[HB_SCRIPT_NKO] = "nqo";
+    size_t count = 1;
     
-    /*
-     * DEFAULT-VALUE
-     */
-    sampleLanguageMap[HB_SCRIPT_INVALID] = "";
-};
+    while ((count < 3) && entry.scripts[count])
+    {
+        count++;
+    }
+    
+    return count;
+}
+
+static bool entryIncludesScript(const HBScriptForLang &entry, hb_script_t script)
+{
+    auto count = getScriptCount(entry);
+    
+    for (size_t i = 0; i < count; i++)
+    {
+        if (entry.scripts[i] == script)
+        {
+            return true;
+        }
+    }
+    
+    return false;
+}
 
 LangHelper::LangHelper()
+:
+generation(0)
 {
-    initScriptMap(scriptMap);
-    initSampleLanguageMap(sampleLanguageMap);
     setDefaultLanguages(DEFAULT_LANGUAGES);
 }
 
 void LangHelper::setDefaultLanguages(const std::string &languages)
 {
-    defaultLanguageSet.clear();
+    std::vector<std::string> tags;
     
     for (auto &lang : ci::split(languages, ":"))
     {
-        defaultLanguageSet.insert(lang);
+        tags.push_back(Language(lang).toString()); // CANONICAL
     }
-}
-
-const std::vector<hb_script_t>& LangHelper::getScriptsForLang(const std::string &lang) const
-{
-    auto it = scriptMap.find(lang);
     
-    if (it == scriptMap.end())
+    std::sort(tags.begin(), tags.end());
+    tags.erase(std::unique(tags.begin(), tags.end()), tags.end());
+    
+    defaultLanguages.assign(tags.begin(), tags.end());
+    generation++;
+    
+    /*
+     * RESOLVING STEPS 2 AND 3 OF detectLanguage() FOR EACH SCRIPT OF THE TABLES
+     * (FOR THE OTHER SCRIPTS, THE RESULT IS THE EMPTY LANGUAGE)
+     */
+    resolvedLanguages.clear();
+    
+    auto resolve = [this](hb_script_t script)
     {
-        it = scriptMap.find("");
-    }
+        if (resolvedLanguages.count(script))
+        {
+            return;
+        }
+        
+        auto language = getDefaultLanguage(script);
+        resolvedLanguages[script] = language.empty() ? getSampleLanguage(script) : language;
+    };
     
-    return it->second;
-}
-
-bool LangHelper::includesScript(const std::string &lang, hb_script_t script) const
-{
-    for (auto &value : getScriptsForLang(lang))
+    resolve(HB_SCRIPT_INVALID);
+    
+    for (auto &entry : HB_SCRIPT_FOR_LANG)
     {
-        if (value == script)
+        for (size_t i = 0; i < getScriptCount(entry); i++)
         {
-            return true;
+            resolve(entry.scripts[i]);
         }
     }
     
-    return false;
+    for (auto &entry : HB_SAMPLE_LANGUAGES)
+    {
+        resolve(entry.script);
+    }
 }
 
-std::string LangHelper::getDefaultLanguage(hb_script_t script) const
+uint32_t LangHelper::getGeneration() const
 {
-    for (auto &lang : defaultLanguageSet)
+    return generation;
+}
+
+std::vector<hb_script_t> LangHelper::getScriptsForLang(const Language &lang) const
+{
+    auto &entry = findEntry(lang);
+    return std::vector<hb_script_t>(entry.scripts, entry.scripts + getScriptCount(entry));
+}
+
+bool LangHelper::includesScript(const Language &lang, hb_script_t script) const
+{
+    return entryIncludesScript(findEntry(lang), script);
+}
+
+Language LangHelper::getDefaultLanguage(hb_script_t script) const
+{
+    for (auto &lang : defaultLanguages)
     {
-        for (auto &value : getScriptsForLang(lang))
+        if (includesScript(lang, script))
         {
-            if (value == script)
-            {
-                return lang;
-            }
+            return lang;
         }
     }
     
-    return "";
+    return Language();
 }
 
-std::string LangHelper::getSampleLanguage(hb_script_t script) const
+Language LangHelper::getSampleLanguage(hb_script_t script) const
 {
-    auto it = sampleLanguageMap.find(script);
+    auto end = HB_SAMPLE_LANGUAGES + SAMPLE_COUNT;
+    auto it = std::lower_bound(HB_SAMPLE_LANGUAGES, end, script, [](const HBSampleLanguage &entry, hb_script_t script) { return uint32_t(entry.script) < uint32_t(script); });
     
-    if (it == sampleLanguageMap.end())
+    if ((it != end) && (it->script == script))
     {
-        it = sampleLanguageMap.find(HB_SCRIPT_INVALID);
+        return Language(it->lang);
     }
     
-    return it->second;
+    return Language();
 }
 
-std::string LangHelper::detectLanguage(hb_script_t script, const std::string &langHint) const
+Language LangHelper::detectLanguage(hb_script_t script, const Language &langHint) const
 {
     /*
      * 1. CAN @script BE USED TO WRITE @langHint?
@@ -439,17 +582,10 @@ std::string LangHelper::detectLanguage(hb_script_t script, const std::string &la
     
     /*
      * 2. CAN @script BE USED TO WRITE ONE OF THE "DEFAULT LANGUAGES"?
-     */
-    
-    auto defaultLanguage = getDefaultLanguage(script);
-    
-    if (!defaultLanguage.empty())
-    {
-        return defaultLanguage;
-    }
-    
-    /*
      * 3. IS THERE A PREDOMINANT LANGUAGE THAT IS LIKELY FOR @script?
+     *
+     * (PRE-RESOLVED BY setDefaultLanguages)
      */
-    return getSampleLanguage(script);
+    auto it = resolvedLanguages.find(script);
+    return (it == resolvedLanguages.end()) ? Language() : it->second;
 }
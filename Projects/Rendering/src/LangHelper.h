@@ -13,12 +13,10 @@
 
 #pragma once
 
-#include "hb.h"
+#include "Language.h"
 
 #include <vector>
-#include <map>
-#include <set>
-#include <string>
+#include <unordered_map>
 
 class LangHelper
 {
@@ -27,6 +25,9 @@ public:
     
     /*
      * EXPECTS A LIST LANGUAGES SEPARATED BY COLONS
+     *
+     * ALSO PRE-RESOLVING THE LANGUAGE DETECTED FOR EACH SCRIPT WITHOUT langHint (SEE detectLanguage)
+     * NOT THREAD-SAFE: SHOULD NOT BE INVOKED WHILE LINES ARE ITEMIZED
      */
     void setDefaultLanguages(const std::string &languages);
     
@@ -38,17 +39,17 @@ public:
      * some that use two (Latin and Cyrillic for example), and a few
      * use three (Japanese for example).
      */
-    const std::vector<hb_script_t>& getScriptsForLang(const std::string &lang) const;
+    std::vector<hb_script_t> getScriptsForLang(const Language &lang) const;
     
     /*
      * DETERMINES IF @script MAY BE USED TO WRITE @lang
      */
-    bool includesScript(const std::string &lang, hb_script_t script) const;
+    bool includesScript(const Language &lang, hb_script_t script) const;
     
     /*
      * RETURNS THE RESOLVED LANGUAGE IF @script MAY BE USED TO WRITE ONE OF THE "DEFAULT LANGUAGES"
      */
-    std::string getDefaultLanguage(hb_script_t script) const;
+    Language getDefaultLanguage(hb_script_t script) const;
     
     /*
      * QUOTING PANGO:
@@ -69,7 +70,7 @@ public:
      * of shared characters. No sample language can be provided
      * for many historical scripts as well.
      */
-    std::string getSampleLanguage(hb_script_t script) const;
+    Language getSampleLanguage(hb_script_t script) const;
     
     /*
      * TRYING TO DETECT A LANGUAGE FOR @script BY ASKING 3 QUESTIONS:
@@ -77,11 +78,18 @@ public:
      * 1. CAN @script BE USED TO WRITE @langHint?
      * 2. CAN @script BE USED TO WRITE ONE OF THE "DEFAULT LANGUAGES"?
      * 3. IS THERE A PREDOMINANT LANGUAGE THAT IS LIKELY FOR @script?
+     *
+     * QUESTION 1 IS A HASH-LOOKUP IN THE (STATIC) LANGUAGE-TABLE, QUESTIONS 2 AND 3 ARE ANSWERED IN ADVANCE BY setDefaultLanguages()
+     */
+    Language detectLanguage(hb_script_t script, const Language &langHint = Language()) const;
+    
+    /*
+     * INCREMENTED BY EACH setDefaultLanguages(), E.G. FOR INVALIDATING THE LINES ITEMIZED WITH THE PREVIOUS LANGUAGES (SEE ItemizationCache)
      */
-    std::string detectLanguage(hb_script_t script, const std::string &langHint = "") const;
+    uint32_t getGeneration() const;
     
 protected:
-    std::map<std::string, std::vector<hb_script_t>> scriptMap;
-    std::map<hb_script_t, std::string> sampleLanguageMap;
-    std::set<std::string> defaultLanguageSet;
+    uint32_t generation;
+    std::vector<Language> defaultLanguages; // IN ALPHABETICAL ORDER, WITHOUT DUPLICATES (THE FIRST ONE WRITTEN WITH A GIVEN SCRIPT IS PREFERRED)
+    std::unordered_map<uint32_t, Language> resolvedLanguages; // SCRIPT -> DEFAULT (OR SAMPLE) LANGUAGE, REBUILT BY setDefaultLanguages()
 };
@@ -0,0 +1,83 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+/*
+ * AN INTERNED LANGUAGE-TAG, E.G. Language("zh-cn")
+ *
+ * - BACKED BY hb_language_t: HARFBUZZ IS KEEPING ONE ATOM PER CANONICAL TAG (LOWERCASE, WITH '-' IN PLACE OF '_') FOR THE LIFETIME OF THE PROCESS
+ * - COPIES AND COMPARISONS ARE POINTER-BASED, AND THE ATOM IS PASSED AS IS TO hb_buffer_set_language()
+ * - THE EMPTY TAG IS HB_LANGUAGE_INVALID
+ * - THE ORDER OF operator< IS ARBITRARY, BUT STABLE DURING THE LIFETIME OF THE PROCESS (ENOUGH FOR THE KEYS OF std::map)
+ *
+ * INTERNING A STRING IS A LOOKUP IN THE (THREAD-SAFE) LIST OF ATOMS OF HARFBUZZ:
+ * THE LANGUAGES USED REPEATEDLY (E.G. AS langHint) SHOULD BE CONVERTED ONCE, RATHER THAN BEFORE EACH LAYOUT
+ */
+
+#pragma once
+
+#include "hb.h"
+
+#include <string>
+#include <functional>
+
+class Language
+{
+public:
+    Language()
+    :
+    language(HB_LANGUAGE_INVALID)
+    {}
+
+    Language(hb_language_t language)
+    :
+    language(language)
+    {}
+
+    Language(const std::string &tag)
+    :
+    language(hb_language_from_string(tag.data(), tag.size()))
+    {}
+
+    Language(const char *tag)
+    :
+    language(hb_language_from_string(tag, -1))
+    {}
+
+    bool empty() const
+    {
+        return (language == HB_LANGUAGE_INVALID);
+    }
+
+    hb_language_t get() const
+    {
+        return language;
+    }
+
+    std::string toString() const
+    {
+        return empty() ? "" : hb_language_to_string(language);
+    }
+
+    bool operator==(const Language &rhs) const
+    {
+        return (language == rhs.language);
+    }
+
+    bool operator!=(const Language &rhs) const
+    {
+        return (language != rhs.language);
+    }
+
+    bool operator<(const Language &rhs) const
+    {
+        return std::less<hb_language_t>()(language, rhs.language);
+    }
+
+protected:
+    hb_language_t language;
+};
@@ -19,9 +19,9 @@ size(0)
     assert(capacity > 0);
 }
 
-shared_ptr<LineLayout> LayoutCache::getLineLayout(VirtualFont *virtualFont, const string &text, const string &langHint, hb_direction_t overallDirection)
+shared_ptr<LineLayout> LayoutCache::getLineLayout(VirtualFont *virtualFont, const string &text, const Language &langHint, hb_direction_t overallDirection, const FeatureList &features)
 {
-    const LineLayoutKey key(virtualFont, text, langHint, overallDirection);
+    const LineLayoutKey key(virtualFont, text, langHint, overallDirection, features);
     auto it = cache.left.find(key);
     
     if (it != cache.left.end())
@@ -57,7 +57,7 @@ shared_ptr<LineLayout> LayoutCache::getLineLayout(VirtualFont *virtualFont, cons
         /*
          * NEW ENTRIES ARE INSERTED AT THE TAIL OF THE bimaps::list_of
          */
-        auto value = shared_ptr<LineLayout>(virtualFont->createLineLayout(text, langHint, overallDirection));
+        auto value = shared_ptr<LineLayout>(virtualFont->createLineLayout(text, langHint, overallDirection, features));
         cache.insert(typename container_type::value_type(key, value));
         
         return value;
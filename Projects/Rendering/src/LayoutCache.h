@@ -14,6 +14,7 @@
 #pragma once
 
 #include "LineLayout.h"
+#include "FeatureList.h"
 
 #include <boost/bimap.hpp>
 #include <boost/bimap/list_of.hpp>
@@ -30,20 +31,22 @@ public:
     {
         VirtualFont *virtualFont;
         std::string text;
-        std::string langHint;
+        Language langHint;
         hb_direction_t overallDirection;
+        FeatureList features;
         
-        LineLayoutKey(VirtualFont *virtualFont, const std::string &text, const std::string &langHint, hb_direction_t overallDirection)
+        LineLayoutKey(VirtualFont *virtualFont, const std::string &text, const Language &langHint, hb_direction_t overallDirection, const FeatureList &features)
         :
         virtualFont(virtualFont),
         text(text),
         langHint(langHint),
-        overallDirection(overallDirection)
+        overallDirection(overallDirection),
+        features(features)
         {}
         
         bool operator<(const LineLayoutKey &rhs) const
         {
-            return tie(virtualFont, overallDirection, langHint, text) < tie(rhs.virtualFont, rhs.overallDirection, rhs.langHint, rhs.text);
+            return tie(virtualFont, overallDirection, langHint, features, text) < tie(rhs.virtualFont, rhs.overallDirection, rhs.langHint, rhs.features, rhs.text);
         }
     };
     
@@ -52,7 +55,7 @@ public:
     /*
      * THE CACHED INSTANCES ARE MANAGED BY LayoutCache AND WILL BE VALID AS LONG AS THE LATTER IS ALIVE
      */
-    std::shared_ptr<LineLayout> getLineLayout(VirtualFont *virtualFont, const std::string &text, const std::string &langHint = "", hb_direction_t overallDirection = HB_DIRECTION_INVALID);
+    std::shared_ptr<LineLayout> getLineLayout(VirtualFont *virtualFont, const std::string &text, const Language &langHint = Language(), hb_direction_t overallDirection = HB_DIRECTION_INVALID, const FeatureList &features = FeatureList());
 
     void clear();
     void setCapacity(size_t newCapacity);
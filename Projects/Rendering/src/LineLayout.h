@@ -8,14 +8,22 @@
 
 #pragma once
 
-#include "hb.h"
+#include "Language.h"
 
 #include "cinder/Vector.h"
 
 #include <vector>
+#include <memory>
 
 class ActualFont;
 class VirtualFont;
+class LineSource;
+
+/*
+ * FLAT REPRESENTATION:
+ * - THE SHAPES OF ALL THE CLUSTERS ARE STORED CONTIGUOUSLY IN LineLayout::shapes
+ * - EACH Cluster IS REFERRING TO ITS RANGE OF SHAPES AND TO ITS FONT VIA INDICES
+ */
 
 struct Shape
 {
@@ -31,40 +39,57 @@ struct Shape
 
 struct Cluster
 {
-    ActualFont *font;
-    
+    uint32_t shapeIndex; // INDEX OF THE FIRST SHAPE IN LineLayout::shapes
+    uint16_t shapeCount;
+    uint16_t fontIndex; // INDEX IN LineLayout::fonts
     float combinedAdvance;
-    std::vector<Shape> shapes;
     
-    Cluster(ActualFont *font, hb_codepoint_t codepoint, const ci::Vec2f &offset, float advance)
+    Cluster(uint32_t shapeIndex, uint16_t shapeCount, uint16_t fontIndex, float combinedAdvance)
     :
-    font(font),
-    combinedAdvance(advance)
-    {
-        shapes.emplace_back(codepoint, offset);
-    }
+    shapeIndex(shapeIndex),
+    shapeCount(shapeCount),
+    fontIndex(fontIndex),
+    combinedAdvance(combinedAdvance)
+    {}
+};
+
+/*
+ * THE WIDTH AND VERTICAL METRICS OF A LINE, WITHOUT ITS CLUSTERS (SEE VirtualFont::measureLine)
+ */
+struct LineMetrics
+{
+    float advance;
+    float maxHeight;
+    float maxAscent;
+    float maxDescent;
     
-    void addShape(hb_codepoint_t codepoint, const ci::Vec2f &offset, float advance)
-    {
-        shapes.emplace_back(codepoint, ci::Vec2f(combinedAdvance, 0) + offset);
-        combinedAdvance += advance;
-    }
+    LineMetrics()
+    :
+    advance(0),
+    maxHeight(0),
+    maxAscent(0),
+    maxDescent(0)
+    {}
 };
 
 struct LineLayout
 {
     VirtualFont *font;
-    std::string langHint;
+    Language langHint;
     hb_direction_t overallDirection;
-
-    std::vector<Cluster> clusters;
-
+    
+    std::vector<ActualFont*> fonts; // THE FONTS TRIED FOR SHAPING (NOT NECESSARILY LOADED, SEE FontIndex), I.E. TAKING PART IN THE LINE'S METRICS
+    std::vector<Cluster> clusters; // IN VISUAL ORDER
+    std::vector<Shape> shapes;
+    
+    std::shared_ptr<const LineSource> source; // ONLY DEFINED FOR THE EDITABLE LAYOUTS (SEE VirtualFont::editLineLayout)
+    
     float advance;
     float maxHeight;
     float maxAscent;
     float maxDescent;
     
-    LineLayout(VirtualFont *font, const std::string &langHint, hb_direction_t overallDirection)
+    LineLayout(VirtualFont *font, const Language &langHint, hb_direction_t overallDirection)
     :
     font(font),
     langHint(langHint),
@@ -75,9 +100,25 @@ struct LineLayout
     maxDescent(0)
     {}
     
-    void addCluster(const Cluster &cluster)
+    void addCluster(uint16_t fontIndex, const Shape *clusterShapes, uint16_t shapeCount, float combinedAdvance)
+    {
+        clusters.emplace_back(shapes.size(), shapeCount, fontIndex, combinedAdvance);
+        shapes.insert(shapes.end(), clusterShapes, clusterShapes + shapeCount);
+        advance += combinedAdvance;
+    }
+    
+    ActualFont* getFont(const Cluster &cluster) const
+    {
+        return fonts[cluster.fontIndex];
+    }
+    
+    const Shape* getShapes(const Cluster &cluster) const
+    {
+        return shapes.data() + cluster.shapeIndex;
+    }
+    
+    size_t getMemoryUsage() const
     {
-        clusters.emplace_back(cluster);
-        advance += cluster.combinedAdvance;
+        return sizeof(LineLayout) + fonts.capacity() * sizeof(ActualFont*) + clusters.capacity() * sizeof(Cluster) + shapes.capacity() * sizeof(Shape);
     }
 };
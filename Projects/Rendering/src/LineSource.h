@@ -0,0 +1,97 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+/*
+ * THE LOGICAL SOURCE OF AN EDITABLE LineLayout (SEE VirtualFont::createEditableLineLayout AND VirtualFont::editLineLayout)
+ *
+ * - THE ITEMIZED TextLine, AND THE SHAPED WORDS OF EACH RUN (THE SAME WORDS AS WITH THE WordCache)
+ * - THE SCRIPT-ITEMS OF THE TEXT (SEE TextItemizer::processEditedText)
+ * - WHEN THE WordCache IS DISABLED: ONE ENTRY PER RUN, SHAPED AS A WHOLE
+ * - IMMUTABLE: THE WORDS WHICH ARE NOT AFFECTED BY AN EDIT ARE SHARED WITH THE NEXT LineSource
+ */
+
+#pragma once
+
+#include "TextItemizer.h"
+#include "WordCache.h"
+
+class LineSource
+{
+public:
+    struct Entry
+    {
+        int32_t start; // IN line.text
+        int32_t end;
+        size_t runIndex; // IN line.runs
+        std::shared_ptr<WordCache::Word> word; // CLUSTERS IN LOGICAL ORDER
+
+        Entry(int32_t start, int32_t end, size_t runIndex, std::shared_ptr<WordCache::Word> word)
+        :
+        start(start),
+        end(end),
+        runIndex(runIndex),
+        word(word)
+        {}
+    };
+
+    TextLine line;
+    Language langHint; // AS PASSED TO createEditableLineLayout() (line.langHint IS THE RESOLVED ONE)
+    hb_direction_t overallDirection; // DITTO
+    bool splitIntoWords; // FALSE IF THE WordCache WAS DISABLED
+    std::vector<Entry> entries; // IN THE ORDER OF line.runs, THEN IN LOGICAL ORDER
+
+    std::vector<TextItemizer::ScriptAndLanguageItem> scriptItems;
+    std::vector<int32_t> safeItemEnds;
+
+    LineSource(const TextLine &line, const Language &langHint, hb_direction_t overallDirection, bool splitIntoWords)
+    :
+    langHint(langHint),
+    overallDirection(overallDirection),
+    splitIntoWords(splitIntoWords)
+    {
+        this->line.assign(line); // line IS USUALLY context.line, WHOSE BUFFER SHOULD NOT BE SHARED
+    }
+
+    /*
+     * MUST BE INVOKED ONCE ALL THE ENTRIES ARE ADDED
+     */
+    void sortEntries()
+    {
+        sortedEntries.resize(entries.size());
+
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            sortedEntries[i] = i;
+        }
+
+        std::sort(sortedEntries.begin(), sortedEntries.end(), [this](size_t lhs, size_t rhs) { return entries[lhs].start < entries[rhs].start; });
+    }
+
+    /*
+     * RETURNS THE ENTRY COVERING EXACTLY [start, end), OR NULL
+     */
+    const Entry* findEntry(int32_t start, int32_t end) const
+    {
+        auto it = std::lower_bound(sortedEntries.begin(), sortedEntries.end(), start, [this](size_t index, int32_t start) { return entries[index].start < start; });
+
+        if ((it != sortedEntries.end()) && (entries[*it].start == start) && (entries[*it].end == end))
+        {
+            return &entries[*it];
+        }
+
+        return NULL;
+    }
+
+    const TextRun& getRun(const Entry &entry) const
+    {
+        return line.runs[entry.runIndex];
+    }
+
+protected:
+    std::vector<size_t> sortedEntries; // INDICES IN entries, SORTED BY start
+};
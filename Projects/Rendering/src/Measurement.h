@@ -0,0 +1,1964 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+/*
+ * MEASURING THE PERFORMANCE OF THE VirtualFont SYSTEM
+ *
+ * NOT USED BY DEFAULT: SEE THE COMMENTED-OUT INVOCATIONS IN Sketch::setup()
+ */
+
+#pragma once
+
+#include "FontManager.h"
+#include "AllocationCounter.h"
+#include "TextParagraph.h"
+
+#include "chronotext/utils/Utils.h"
+
+#include "cinder/Timer.h"
+#include "cinder/Rand.h"
+
+#include "unicode/unistr.h"
+
+#include <map>
+#include <memory>
+
+class Measurement
+{
+public:
+    /*
+     * COMPARING THE "DIRECT" AND "TEXTURE BUCKET" MODES WHEN DRAWING THE SAME LINES
+     * MUST BE INVOKED WHILE AN OPENGL CONTEXT IS AVAILABLE
+     *
+     * NOTE: ONLY THE CPU-TIME IS MEASURED (THE GPU MAY STILL BE BUSY AFTERWARDS)
+     */
+    static void drawing(VirtualFont &font, const std::vector<std::string> &lines, int frameCount = 1000)
+    {
+        drawFrame(font, lines, VirtualFont::MODE_DIRECT); // ENSURES THAT THE LAYOUTS AND THE GLYPHS ARE CACHED
+
+        for (auto mode : {VirtualFont::MODE_DIRECT, VirtualFont::MODE_TEXTURE_BUCKET})
+        {
+            ci::Timer timer(true);
+            int drawCallCount = 0;
+
+            for (int i = 0; i < frameCount; i++)
+            {
+                drawCallCount = drawFrame(font, lines, mode);
+            }
+
+            glFinish();
+            timer.stop();
+
+            LOGI << ((mode == VirtualFont::MODE_DIRECT) ? "DIRECT" : "TEXTURE BUCKET") << ": "
+            << drawCallCount << " DRAW-CALLS PER FRAME | "
+            << (timer.getSeconds() * 1000 / frameCount) << " MS PER FRAME" << std::endl;
+        }
+    }
+
+    /*
+     * FLOODING THE GlyphRasterizer WITH codepointCount CONSECUTIVE CODEPOINTS (CJK BY DEFAULT)
+     * AND CHECKING THAT EVERY GLYPH IS EVENTUALLY RESOLVED
+     *
+     * REQUIRES FontManager::enableAsyncRasterization()
+     * MUST BE INVOKED WHILE AN OPENGL CONTEXT IS AVAILABLE
+     */
+    static bool rasterization(FontManager &fontManager, VirtualFont &font, UChar32 firstCodepoint = 0x4e00, int codepointCount = 4096, int budget = 32, double timeout = 30)
+    {
+        UnicodeString text;
+        
+        for (int i = 0; i < codepointCount; i++)
+        {
+            text.append(firstCodepoint + i);
+        }
+        
+        std::string utf8;
+        text.toUTF8String(utf8);
+        
+        const std::vector<std::string> lines(1, utf8);
+        
+        // ---
+        
+        ci::Timer timer(true);
+        int frameCount = 0;
+        
+        do
+        {
+            drawFrame(font, lines, VirtualFont::MODE_TEXTURE_BUCKET); // REQUESTING THE MISSING GLYPHS
+            fontManager.uploadGlyphs(budget);
+            frameCount++;
+            
+            if (timer.getSeconds() > timeout)
+            {
+                LOGI << "RASTERIZATION: TIMEOUT | " << fontManager.getPendingGlyphCount() << " GLYPHS STILL PENDING" << std::endl;
+                return false;
+            }
+        }
+        while (fontManager.getPendingGlyphCount() > 0);
+        
+        timer.stop();
+        
+        /*
+         * AT THIS STAGE, DRAWING THE SAME TEXT SHOULD NOT TRIGGER ANY NEW REQUEST
+         */
+        drawFrame(font, lines, VirtualFont::MODE_TEXTURE_BUCKET);
+        bool resolved = (fontManager.getPendingGlyphCount() == 0);
+        
+        LOGI << "RASTERIZATION: " << (resolved ? "ALL GLYPHS RESOLVED" : "UNRESOLVED GLYPHS") << " | "
+        << codepointCount << " CODEPOINTS | "
+        << frameCount << " FRAMES | "
+        << (timer.getSeconds() * 1000) << " MS" << std::endl;
+        
+        return resolved;
+    }
+    
+    /*
+     * COMPARING THE TIME-TO-FIRST-FRAME WITH AN EMPTY ("COLD") AND WITH A FILLED ("WARM") GlyphDiskCache
+     * EACH PASS IS USING A NEW FontManager, I.E. NOTHING IS CACHED IN MEMORY
+     *
+     * WARNING: THE CACHE-FILES IN directory ARE REMOVED BEFORE THE "COLD" PASS
+     * MUST BE INVOKED WHILE AN OPENGL CONTEXT IS AVAILABLE
+     */
+    static void diskCaching(const ci::fs::path &directory, const std::vector<std::string> &lines)
+    {
+        GlyphDiskCache::clear(directory);
+        
+        for (auto warm : {false, true})
+        {
+            ci::Timer timer(true);
+            
+            FontManager fontManager;
+            fontManager.loadConfig(chr::InputSource::getResource("Fonts.xml"));
+            fontManager.enableDiskCache(directory);
+            
+            drawFrame(*fontManager.getCachedFont("sans-serif"), lines, VirtualFont::MODE_TEXTURE_BUCKET);
+            
+            glFinish();
+            timer.stop();
+            
+            LOGI << (warm ? "WARM" : "COLD") << " DISK-CACHE: "
+            << (timer.getSeconds() * 1000) << " MS TO FIRST FRAME" << std::endl;
+        }
+    }
+    
+    /*
+     * COMPARING THE PAGED GLYPH-TABLE OF ActualFont WITH THE std::map<uint32_t, std::unique_ptr<Glyph>> IT REPLACED
+     * THE LOOKED-UP GLYPHS ARE THE ONES USED BY lines (E.G. A MIX OF LATIN, ARABIC AND CJK)
+     *
+     * THE "MAP" PASS IS REPLICATING THE FORMER HOT-PATH: reload(), map-LOOKUP, TEXTURE-CHECK
+     * MUST BE INVOKED WHILE AN OPENGL CONTEXT IS AVAILABLE
+     */
+    static void glyphLookup(VirtualFont &font, const std::vector<std::string> &lines, int iterationCount = 1000)
+    {
+        std::vector<std::pair<ActualFont*, uint32_t>> lookups;
+        std::map<ActualFont*, std::map<uint32_t, std::unique_ptr<ActualFont::Glyph>>> glyphMaps;
+        
+        for (auto &line : lines)
+        {
+            auto layout = font.getCachedLineLayout(line);
+            
+            for (auto &cluster : layout->clusters)
+            {
+                auto actualFont = layout->getFont(cluster);
+                auto shapes = layout->getShapes(cluster);
+                
+                for (int i = 0; i < cluster.shapeCount; i++)
+                {
+                    auto glyph = actualFont->getGlyph(shapes[i].codepoint); // ENSURES THAT THE GLYPH IS DEFINED
+                    
+                    if (glyph)
+                    {
+                        lookups.emplace_back(actualFont, shapes[i].codepoint);
+                        glyphMaps[actualFont][shapes[i].codepoint] = std::unique_ptr<ActualFont::Glyph>(new ActualFont::Glyph(*glyph));
+                    }
+                }
+            }
+        }
+        
+        if (lookups.empty())
+        {
+            return;
+        }
+        
+        // ---
+        
+        size_t checksum = 0; // PREVENTS THE COMPILER FROM OPTIMIZING THE LOOKUPS AWAY
+        
+        ci::Timer timer1(true);
+        
+        for (int i = 0; i < iterationCount; i++)
+        {
+            for (auto &lookup : lookups)
+            {
+                auto font = lookup.first;
+                font->reload();
+                
+                auto &glyphMap = glyphMaps[font];
+                auto entry = glyphMap.find(lookup.second);
+                
+                if (entry != glyphMap.end())
+                {
+                    auto glyph = entry->second.get();
+                    
+                    if (glyph->texture && glyph->texture->isLoaded())
+                    {
+                        font->textureStore->touch(glyph->texture, true);
+                    }
+                    
+                    checksum += size_t(glyph->texture);
+                }
+            }
+        }
+        
+        timer1.stop();
+        
+        // ---
+        
+        ci::Timer timer2(true);
+        
+        for (int i = 0; i < iterationCount; i++)
+        {
+            for (auto &lookup : lookups)
+            {
+                checksum -= size_t(lookup.first->getGlyph(lookup.second)->texture);
+            }
+        }
+        
+        timer2.stop();
+        
+        // ---
+        
+        double lookupCount = double(lookups.size()) * iterationCount;
+        
+        LOGI << "GLYPH-LOOKUP: " << lookups.size() << " GLYPHS PER ITERATION | "
+        << "MAP: " << (timer1.getSeconds() * 1e9 / lookupCount) << " NS | "
+        << "PAGED TABLE: " << (timer2.getSeconds() * 1e9 / lookupCount) << " NS"
+        << (checksum ? " | CHECKSUM MISMATCH" : "") << std::endl;
+    }
+    
+    /*
+     * COMPARING THE COLD-START (CREATION OF THE "sans-serif" VirtualFont, THEN FIRST FRAME) WITHOUT AND WITH A FontIndex
+     * EACH PASS IS USING A NEW FontManager
+     *
+     * WARNING: THE FILE AT filePath IS REMOVED BEFORE THE FIRST PASS
+     * MUST BE INVOKED WHILE AN OPENGL CONTEXT IS AVAILABLE
+     */
+    static void fontIndexing(const ci::fs::path &filePath, const std::vector<std::string> &lines)
+    {
+        ci::fs::remove(filePath);
+        
+        for (auto pass : {"NO FONT-INDEX", "COLD FONT-INDEX", "WARM FONT-INDEX"})
+        {
+            ci::Timer timer(true);
+            
+            FontManager fontManager;
+            fontManager.loadConfig(chr::InputSource::getResource("Fonts.xml"));
+            
+            if (pass != std::string("NO FONT-INDEX"))
+            {
+                fontManager.enableFontIndex(filePath);
+            }
+            
+            auto font = fontManager.getCachedFont("sans-serif");
+            double creationTime = timer.getSeconds();
+            
+            drawFrame(*font, lines, VirtualFont::MODE_TEXTURE_BUCKET);
+            
+            glFinish();
+            timer.stop();
+            
+            int loadedCount = 0;
+            
+            for (auto &it : fontManager.actualFonts)
+            {
+                loadedCount += it.second->loaded ? 1 : 0;
+            }
+            
+            LOGI << pass << ": "
+            << (creationTime * 1000) << " MS TO CREATE THE VirtualFont | "
+            << (timer.getSeconds() * 1000) << " MS TO FIRST FRAME | "
+            << loadedCount << "/" << fontManager.actualFonts.size() << " ActualFont INSTANCES LOADED" << std::endl;
+        }
+    }
+    
+    /*
+     * REPORTING, FOR EACH LOADED FontFace, HOW MUCH OF THE FONT-DATA IS MAPPED AND HOW MUCH IS ACTUALLY RESIDENT
+     * FOR FONT-DATA COPIED TO THE HEAP (E.G. ANDROID ASSETS), EVERYTHING IS RESIDENT
+     */
+    static void fontMemory(const FontManager &fontManager)
+    {
+        size_t totalMapped = 0;
+        size_t totalResident = 0;
+        
+        for (auto &it : fontManager.fontFaces)
+        {
+            auto &face = *it.second;
+            
+            if (face.isLoaded())
+            {
+                LOGI << it.first.uri << " " << it.first.faceIndex << ": "
+                << (face.isMapped() ? "MAPPED" : "HEAP") << " | "
+                << face.getResidentSize() << " RESIDENT BYTES | "
+                << face.getMappedSize() << " MAPPED BYTES" << std::endl;
+                
+                totalMapped += face.getMappedSize();
+                totalResident += face.getResidentSize();
+            }
+        }
+        
+        LOGI << "FONT-MEMORY: " << totalResident << " RESIDENT BYTES | " << totalMapped << " MAPPED BYTES" << std::endl;
+    }
+    
+    /*
+     * COMPARING LINE-SHAPING WITHOUT CACHE, WITH WordCache, WITH LayoutCache AND WITH BOTH
+     * THE LINES ARE GENERATED AS IN THE LayoutCaching PROJECT: sentences PICKED RANDOMLY (SEED 123), lineCount LINES PER ITERATION
+     *
+     * CORRECTNESS: EACH sentence, AND EACH LINE OF THE FIRST ITERATION, IS ALSO SHAPED AS A WHOLE AND COMPARED
+     * AS WELL AS LINES WITH A RUN-BOUNDARY WITHOUT A SPACE, SHAPED AFTER A LINE CACHING THE SAME WORD IN ANOTHER CONTEXT
+     *
+     * WARNING: THE LayoutCache AND THE WordCache OF fontManager ARE CLEARED
+     */
+    static void wordCaching(FontManager &fontManager, VirtualFont &font, const std::vector<std::string> &sentences, int lineCount = 11, int maxSentencesPerLine = 3, int iterationCount = 1000)
+    {
+        auto lines = createRandomLines(sentences, lineCount * iterationCount, maxSentencesPerLine);
+        
+        auto &layoutCache = fontManager.layoutCache;
+        auto &wordCache = fontManager.wordCache;
+        bool wasEnabled = wordCache.isEnabled();
+        
+        int mismatchCount = 0;
+        int checkCount = 0;
+        
+        for (auto &line : sentences)
+        {
+            mismatchCount += compareLayouts(font, wordCache, line) ? 0 : 1;
+            checkCount++;
+        }
+        
+        for (int i = 0; i < lineCount; i++)
+        {
+            mismatchCount += compareLayouts(font, wordCache, lines[i]) ? 0 : 1;
+            checkCount++;
+        }
+        
+        /*
+         * E.G. "بب" IS CACHED WITH ISOLATED FORMS, BUT IS JOINING THE FOLLOWING SYRIAC RUN IN "ببܒܒ"
+         */
+        std::vector<std::pair<std::string, std::string>> contextLines =
+        {
+            { u8"بب", u8"ببܒܒ" },
+            { u8"ب", u8"ܒب" },
+            { u8"ب", u8"بߊ" },
+            { u8"hello بب", u8"hello ببܒܒ world" }
+        };
+        
+        for (auto &contextLine : contextLines)
+        {
+            wordCache.clear();
+            wordCache.setEnabled(true);
+            delete font.createLineLayout(contextLine.first);
+            
+            mismatchCount += compareLayouts(font, wordCache, contextLine.second) ? 0 : 1;
+            checkCount++;
+        }
+        
+        // ---
+        
+        for (auto pass : {"NO CACHE", "WORD CACHE", "LINE CACHE", "LINE + WORD CACHE"})
+        {
+            bool useWordCache = (pass == std::string("WORD CACHE")) || (pass == std::string("LINE + WORD CACHE"));
+            bool useLineCache = (pass == std::string("LINE CACHE")) || (pass == std::string("LINE + WORD CACHE"));
+            
+            layoutCache.clear();
+            wordCache.clear();
+            wordCache.resetCounters();
+            wordCache.setEnabled(useWordCache);
+            
+            ci::Timer timer(true);
+            
+            for (auto &line : lines)
+            {
+                if (useLineCache)
+                {
+                    font.getCachedLineLayout(line);
+                }
+                else
+                {
+                    delete font.createLineLayout(line);
+                }
+            }
+            
+            timer.stop();
+            
+            auto lookupCount = wordCache.getHitCount() + wordCache.getMissCount();
+            
+            std::string hitRate;
+            
+            if (useWordCache && lookupCount)
+            {
+                hitRate = " | WORD HIT-RATE: " + chr::toString(100.0 * wordCache.getHitCount() / lookupCount) + "% OF " + chr::toString(lookupCount) + " WORDS";
+            }
+            
+            LOGI << pass << ": " << (timer.getSeconds() * 1000) << " MS FOR " << lines.size() << " LINES" << hitRate << std::endl;
+        }
+        
+        LOGI << "WORD CACHE CORRECTNESS: " << mismatchCount << " MISMATCHES OVER " << checkCount << " LINES" << std::endl;
+        
+        layoutCache.clear();
+        wordCache.clear();
+        wordCache.resetCounters();
+        wordCache.setEnabled(wasEnabled);
+    }
+    
+    /*
+     * COUNTING THE hb_shape() CALLS AND THE SHAPED UTF-16 CODE-UNITS PER LINE, FOR EACH sentence
+     * AND FOR lineCount MIXED-SCRIPT LINES (sentences PICKED RANDOMLY, SEED 123)
+     *
+     * THE WordCache IS DISABLED MEANWHILE: EACH TEXT-RUN IS SHAPED AS A WHOLE, THEN FALLBACK-FONTS ARE SHAPING THE MISSING RANGES
+     * A "SHAPED / TEXT" RATIO OF 1 MEANS THAT NO CODE-UNIT HAS BEEN SHAPED MORE THAN ONCE
+     */
+    static void fallbackShaping(FontManager &fontManager, VirtualFont &font, const std::vector<std::string> &sentences, int lineCount = 1000, int maxSentencesPerLine = 3)
+    {
+        auto &wordCache = fontManager.wordCache;
+        bool wasEnabled = wordCache.isEnabled();
+        wordCache.setEnabled(false);
+        
+        for (auto pass : {"SENTENCES", "MIXED LINES"})
+        {
+            auto lines = (pass == std::string("SENTENCES")) ? sentences : createRandomLines(sentences, lineCount, maxSentencesPerLine);
+            
+            uint64_t textLength = 0;
+            font.resetShapingCounters();
+            
+            for (auto &line : lines)
+            {
+                textLength += UnicodeString::fromUTF8(line).length();
+                delete font.createLineLayout(line);
+            }
+            
+            LOGI << pass << ": "
+            << (double(font.getShapeCallCount()) / lines.size()) << " hb_shape() CALLS PER LINE | "
+            << (double(font.getShapedCodeUnitCount()) / lines.size()) << " SHAPED CODE-UNITS PER LINE | "
+            << "SHAPED / TEXT: " << (double(font.getShapedCodeUnitCount()) / textLength) << std::endl;
+        }
+        
+        wordCache.setEnabled(wasEnabled);
+    }
+    
+    /*
+     * MEASURING createLineLayout() FOR lineCount MIXED-SCRIPT LINES (sentences PICKED RANDOMLY, SEED 123), WITHOUT AND WITH THE WordCache:
+     * - HEAP-ALLOCATIONS PER LINE (SEE AllocationCounter)
+     * - NANOSECONDS PER GLYPH
+     * - MEMORY PER LAYOUT (SEE LineLayout::getMemoryUsage)
+     *
+     * EACH PASS IS PRECEDED BY A WARM-UP ITERATION (GLYPHS, WORDS AND SCRATCH-STORAGE ARE CACHED)
+     */
+    static void layoutCreation(FontManager &fontManager, VirtualFont &font, const std::vector<std::string> &sentences, int lineCount = 1000, int maxSentencesPerLine = 3, int iterationCount = 10)
+    {
+        auto lines = createRandomLines(sentences, lineCount, maxSentencesPerLine);
+        
+        auto &wordCache = fontManager.wordCache;
+        bool wasEnabled = wordCache.isEnabled();
+        
+        for (auto pass : {"NO WORD CACHE", "WORD CACHE"})
+        {
+            wordCache.setEnabled(pass == std::string("WORD CACHE"));
+            
+            size_t shapeCount = 0;
+            size_t memoryUsage = 0;
+            
+            for (auto &line : lines)
+            {
+                std::unique_ptr<LineLayout> layout(font.createLineLayout(line));
+                
+                shapeCount += layout->shapes.size();
+                memoryUsage += layout->getMemoryUsage();
+            }
+            
+            auto allocationCount = AllocationCounter::getCount();
+            ci::Timer timer(true);
+            
+            for (int i = 0; i < iterationCount; i++)
+            {
+                for (auto &line : lines)
+                {
+                    delete font.createLineLayout(line);
+                }
+            }
+            
+            timer.stop();
+            allocationCount = AllocationCounter::getCount() - allocationCount;
+            
+            double createCount = double(lines.size()) * iterationCount;
+            
+            LOGI << pass << ": "
+            << formatAllocations(allocationCount / createCount) << " ALLOCATIONS PER LINE | "
+            << (timer.getSeconds() * 1e9 / (double(shapeCount) * iterationCount)) << " NS PER GLYPH | "
+            << (double(memoryUsage) / lines.size()) << " BYTES PER LAYOUT" << std::endl;
+        }
+        
+        wordCache.setEnabled(wasEnabled);
+    }
+    
+    /*
+     * CHECKING THAT, ONCE A ShapingContext HAS GROWN ENOUGH, createLineLayout() IS ONLY ALLOCATING THE RESULTING LineLayout
+     * FOR EACH sentence AND FOR lineCount MIXED-SCRIPT LINES (SEED 123), WITHOUT AND WITH THE WordCache,
+     * AND FINALLY WITH A WARM ItemizationCache (NO MISS EXPECTED WITH THE DEFAULT CAPACITY)
+     *
+     * THE ALLOCATIONS OF THE RESULT ARE MEASURED BY COPYING IT (THE COPY IS ALLOCATING THE SAME BLOCKS)
+     * NOT COUNTED: MEMORY ALLOCATED VIA malloc() BY ICU AND HARFBUZZ (THE UBiDi AND hb_buffer_t ARE REUSED TOO)
+     *
+     * RETURNS FALSE IF ANY LINE IS PERFORMING EXTRA ALLOCATIONS, OR IF THE ALLOCATIONS ARE NOT COUNTED (SEE AllocationCounter)
+     */
+    static bool shapingAllocations(FontManager &fontManager, VirtualFont &font, const std::vector<std::string> &sentences, int lineCount = 1000, int maxSentencesPerLine = 3)
+    {
+        if (!AllocationCounter::isEnabled())
+        {
+            LOGI << "SHAPING ALLOCATIONS: NOT MEASURED (MEASURE_ALLOCATIONS IS NOT DEFINED)" << std::endl;
+            return false;
+        }
+        
+        auto lines = createRandomLines(sentences, lineCount, maxSentencesPerLine);
+        lines.insert(lines.end(), sentences.begin(), sentences.end());
+        
+        auto &wordCache = fontManager.wordCache;
+        bool wasEnabled = wordCache.isEnabled();
+        bool success = true;
+        
+        ShapingContext context;
+        
+        for (auto pass : {"NO WORD CACHE", "WORD CACHE"})
+        {
+            wordCache.setEnabled(pass == std::string("WORD CACHE"));
+            
+            for (auto &line : lines)
+            {
+                delete font.createLineLayout(context, line); // GROWING THE ShapingContext, CACHING THE GLYPHS AND THE WORDS
+            }
+            
+            uint64_t extraCount = 0;
+            int failureCount = 0;
+            
+            for (auto &line : lines)
+            {
+                auto count1 = AllocationCounter::getCount();
+                std::unique_ptr<LineLayout> layout(font.createLineLayout(context, line));
+                
+                auto count2 = AllocationCounter::getCount();
+                std::unique_ptr<LineLayout> copy(new LineLayout(*layout));
+                
+                auto count3 = AllocationCounter::getCount();
+                auto extra = (count2 - count1) - (count3 - count2);
+                
+                if (extra)
+                {
+                    extraCount += extra;
+                    failureCount++;
+                }
+            }
+            
+            LOGI << pass << ": " << failureCount << "/" << lines.size() << " LINES WITH EXTRA ALLOCATIONS | "
+            << (double(extraCount) / lines.size()) << " EXTRA ALLOCATIONS PER LINE" << std::endl;
+            
+            success &= (failureCount == 0);
+        }
+        
+        /*
+         * ItemizationCache HITS: ALL THE LINES ARE ITEMIZED ONCE (WARM-UP) AND THEN RETRIEVED FROM THE CACHE
+         * A CACHED LINE SHARED WITH context.line WOULD BE CLONED VIA malloc() BY THE NEXT reset() (NOT COUNTED),
+         * HENCE THE CHECKING OF THE BUFFER OF context.line, WHICH SHOULD REMAIN THE SAME
+         */
+        auto &itemizationCache = fontManager.itemizationCache;
+        bool wasItemizationCacheEnabled = itemizationCache.isEnabled();
+        
+        itemizationCache.setEnabled(true);
+        wordCache.setEnabled(true);
+        
+        for (auto &line : lines)
+        {
+            delete font.createLineLayout(context, line);
+        }
+        
+        auto missCount = itemizationCache.getMissCount();
+        auto buffer = context.line.text.getBuffer();
+        
+        uint64_t extraCount = 0;
+        int failureCount = 0;
+        
+        for (auto &line : lines)
+        {
+            auto count1 = AllocationCounter::getCount();
+            std::unique_ptr<LineLayout> layout(font.createLineLayout(context, line));
+            
+            auto count2 = AllocationCounter::getCount();
+            std::unique_ptr<LineLayout> copy(new LineLayout(*layout));
+            
+            auto count3 = AllocationCounter::getCount();
+            auto extra = (count2 - count1) - (count3 - count2);
+            
+            if (extra || (context.line.text.getBuffer() != buffer))
+            {
+                extraCount += extra;
+                failureCount++;
+            }
+        }
+        
+        missCount = itemizationCache.getMissCount() - missCount;
+        
+        LOGI << "ITEMIZATION CACHE HITS: " << failureCount << "/" << lines.size() << " LINES WITH EXTRA ALLOCATIONS (OR A CLONED BUFFER) | "
+        << (double(extraCount) / lines.size()) << " EXTRA ALLOCATIONS PER LINE | " << missCount << " MISSES" << std::endl;
+        
+        success &= (failureCount == 0) && (missCount == 0);
+        
+        wordCache.setEnabled(wasEnabled);
+        itemizationCache.setEnabled(wasItemizationCacheEnabled);
+        
+        return success;
+    }
+    
+    /*
+     * COMPARING VirtualFont::measureLine() WITH createLineLayout() + getAdvance(), ON TWO CORPORA:
+     * THE sentences THEMSELVES, AND lineCount MIXED-SCRIPT LINES (SEED 123), WITHOUT AND WITH THE WordCache
+     *
+     * - NANOSECONDS PER LINE FOR createLineLayout(), measureLine() WITHOUT THE WidthCache AND measureLine() WITH IT (WARM)
+     *   NOTE: WITH THE DEFAULT CAPACITY, THE WidthCache IS ONLY HOLDING A FRACTION OF THE MIXED LINES
+     * - COST RATIO: measureLine() (WITHOUT THE WidthCache) VS createLineLayout()
+     * - MAXIMUM DIFFERENCE BETWEEN THE MEASURED AND THE LAID-OUT VALUES
+     */
+    static void lineMeasuring(FontManager &fontManager, VirtualFont &font, const std::vector<std::string> &sentences, int lineCount = 1000, int maxSentencesPerLine = 3, int iterationCount = 10)
+    {
+        auto &wordCache = fontManager.wordCache;
+        auto &widthCache = font.widthCache;
+        bool wasWordCacheEnabled = wordCache.isEnabled();
+        bool wasWidthCacheEnabled = widthCache.isEnabled();
+        
+        std::map<std::string, std::vector<std::string>> corpora;
+        corpora["SENTENCES"] = sentences;
+        corpora["MIXED LINES"] = createRandomLines(sentences, lineCount, maxSentencesPerLine);
+        
+        for (auto &corpus : corpora)
+        {
+            auto &lines = corpus.second;
+            
+            for (auto pass : {"NO WORD CACHE", "WORD CACHE"})
+            {
+                wordCache.setEnabled(pass == std::string("WORD CACHE"));
+                widthCache.clear();
+                
+                float maxDifference = 0;
+                
+                for (auto &line : lines)
+                {
+                    std::unique_ptr<LineLayout> layout(font.createLineLayout(line)); // WARMING-UP THE GLYPHS AND THE WORDS
+                    
+                    widthCache.setEnabled(false);
+                    auto metrics = font.measureLine(line);
+                    
+                    maxDifference = std::max(maxDifference, std::abs(metrics.advance - font.getAdvance(*layout)));
+                    maxDifference = std::max(maxDifference, std::abs(metrics.maxHeight - font.getHeight(*layout)));
+                    maxDifference = std::max(maxDifference, std::abs(metrics.maxAscent - font.getAscent(*layout)));
+                    maxDifference = std::max(maxDifference, std::abs(metrics.maxDescent - font.getDescent(*layout)));
+                    
+                    widthCache.setEnabled(true);
+                    font.measureLine(line); // WARMING-UP THE WidthCache
+                }
+                
+                double createCount = double(lines.size()) * iterationCount;
+                double seconds[3];
+                
+                for (int mode = 0; mode < 3; mode++)
+                {
+                    widthCache.setEnabled(mode == 2);
+                    ci::Timer timer(true);
+                    
+                    for (int i = 0; i < iterationCount; i++)
+                    {
+                        for (auto &line : lines)
+                        {
+                            if (mode == 0)
+                            {
+                                std::unique_ptr<LineLayout> layout(font.createLineLayout(line));
+                                font.getAdvance(*layout);
+                            }
+                            else
+                            {
+                                font.measureLine(line);
+                            }
+                        }
+                    }
+                    
+                    seconds[mode] = timer.getSeconds();
+                }
+                
+                LOGI << corpus.first << " | " << pass << ": "
+                << (seconds[0] * 1e9 / createCount) << " NS PER createLineLayout() | "
+                << (seconds[1] * 1e9 / createCount) << " NS PER measureLine() | "
+                << (seconds[2] * 1e9 / createCount) << " NS PER CACHED measureLine() | "
+                << "RATIO: " << (seconds[1] / seconds[0]) << " | MAX DIFFERENCE: " << maxDifference << std::endl;
+            }
+        }
+        
+        wordCache.setEnabled(wasWordCacheEnabled);
+        widthCache.setEnabled(wasWidthCacheEnabled);
+    }
+    
+    /*
+     * MEASURING VirtualFont::createLineLayouts() FOR lineCount MIXED-SCRIPT LINES (SEED 123), WITH 1 TO maxThreadCount THREADS
+     * (I.E. THE CALLING THREAD AND UP TO maxThreadCount - 1 WORKERS): LINES PER SECOND, AND SPEEDUP RELATIVE TO A SINGLE THREAD
+     *
+     * THE WordCache IS CLEARED BEFORE EACH ITERATION, I.E. ALL THE WORDS ARE SHAPED CONCURRENTLY
+     * EACH RESULT IS COMPARED WITH THE ONE CREATED BY createLineLayout() ON THE CALLING THREAD
+     *
+     * RETURNS FALSE IF ANY LAYOUT IS NOT IDENTICAL
+     */
+    static bool parallelLayout(FontManager &fontManager, VirtualFont &font, const std::vector<std::string> &sentences, int lineCount = 10000, int maxSentencesPerLine = 3, int maxThreadCount = 8, int iterationCount = 5)
+    {
+        auto lines = createRandomLines(sentences, lineCount, maxSentencesPerLine);
+        
+        auto &wordCache = fontManager.wordCache;
+        auto &workerPool = fontManager.workerPool;
+        int previousWorkerCount = workerPool.getWorkerCount();
+        
+        std::vector<std::unique_ptr<LineLayout>> references;
+        
+        for (auto &line : lines)
+        {
+            references.emplace_back(font.createLineLayout(line));
+        }
+        
+        bool success = true;
+        double baseRate = 0;
+        
+        for (int threadCount = 1; threadCount <= maxThreadCount; threadCount++)
+        {
+            workerPool.setWorkerCount(threadCount - 1);
+            
+            double seconds = 0;
+            int failureCount = 0;
+            
+            for (int i = 0; i < iterationCount; i++)
+            {
+                wordCache.clear();
+                
+                ci::Timer timer(true);
+                auto layouts = font.createLineLayouts(lines);
+                timer.stop();
+                
+                seconds += timer.getSeconds();
+                
+                for (size_t j = 0; j < layouts.size(); j++)
+                {
+                    if (!sameLayouts(*references[j], *layouts[j]))
+                    {
+                        failureCount++;
+                    }
+                    
+                    delete layouts[j];
+                }
+            }
+            
+            double rate = lines.size() * iterationCount / seconds;
+            
+            if (threadCount == 1)
+            {
+                baseRate = rate;
+            }
+            
+            LOGI << threadCount << " THREAD(S): " << rate << " LINES PER SECOND | SPEEDUP: " << (rate / baseRate) << " | "
+            << failureCount << "/" << (lines.size() * iterationCount) << " DIFFERENT LAYOUTS" << std::endl;
+            
+            success &= (failureCount == 0);
+        }
+        
+        workerPool.setWorkerCount(previousWorkerCount);
+        return success;
+    }
+    
+    /*
+     * COMPARING THE "SIMPLE TEXT" FAST-PATH (SEE SimpleShaper) WITH THE REGULAR PATH, WITHOUT AND WITH THE WordCache, ON:
+     * - lineCount LINES MADE OF THE SIMPLE sentences (PICKED RANDOMLY, SEED 123)
+     * - ONE LINE PER SIMPLE CHARACTER a: "a b0 a b1 ... a bn", I.E. EVERY PAIR OF SIMPLE CHARACTERS (AND ITS KERNING)
+     *
+     * - NUMBER OF DIFFERENT LAYOUTS (VIA createLineLayout) AND MEASUREMENTS (VIA measureLine, WITHOUT THE WidthCache), FOR 3 LANGUAGE-HINTS
+     * - LINES PER SECOND (createLineLayout) FOR BOTH PATHS
+     *
+     * RETURNS FALSE IF ANY LAYOUT OR MEASUREMENT IS NOT IDENTICAL, OR IF THE FAST-PATH IS NOT TAKEN (E.G. THE FONT IS NOT USABLE)
+     */
+    static bool simpleText(FontManager &fontManager, VirtualFont &font, const std::vector<std::string> &sentences, int lineCount = 1000, int maxSentencesPerLine = 3, int iterationCount = 10)
+    {
+        std::vector<uint8_t> codes;
+        std::vector<std::string> simpleSentences;
+        
+        for (auto &sentence : sentences)
+        {
+            if (SimpleShaper::decode(sentence, codes))
+            {
+                simpleSentences.push_back(sentence);
+            }
+        }
+        
+        if (simpleSentences.empty())
+        {
+            LOGI << "NO SIMPLE SENTENCE" << std::endl;
+            return false;
+        }
+        
+        std::vector<std::string> characters;
+        
+        for (UChar32 c = 0x20; c < 0x100; c++)
+        {
+            std::string character;
+            UnicodeString(c).toUTF8String(character);
+            
+            if (SimpleShaper::decode(character + "a", codes))
+            {
+                characters.push_back(character);
+            }
+        }
+        
+        auto lines = createRandomLines(simpleSentences, lineCount, maxSentencesPerLine);
+        
+        for (auto &first : characters)
+        {
+            std::string line;
+            
+            for (auto &second : characters)
+            {
+                line += first;
+                line += second;
+            }
+            
+            lines.push_back(line);
+        }
+        
+        auto &wordCache = fontManager.wordCache;
+        auto &widthCache = font.widthCache;
+        bool wasWordCacheEnabled = wordCache.isEnabled();
+        bool wasWidthCacheEnabled = widthCache.isEnabled();
+        bool wasSimpleTextUsed = font.useSimpleText;
+        
+        widthCache.setEnabled(false);
+        bool success = true;
+        
+        for (auto pass : {"NO WORD CACHE", "WORD CACHE"})
+        {
+            wordCache.setEnabled(pass == std::string("WORD CACHE"));
+            
+            int layoutFailureCount = 0;
+            int measurementFailureCount = 0;
+            font.resetShapingCounters();
+            
+            for (auto langHint : {"", "fr", "de"})
+            {
+                for (auto &line : lines)
+                {
+                    font.useSimpleText = true;
+                    std::unique_ptr<LineLayout> layout1(font.createLineLayout(line, langHint));
+                    auto metrics1 = font.measureLine(line, langHint);
+                    
+                    font.useSimpleText = false;
+                    std::unique_ptr<LineLayout> layout2(font.createLineLayout(line, langHint));
+                    auto metrics2 = font.measureLine(line, langHint);
+                    
+                    if (!sameLayouts(*layout1, *layout2) || (layout1->langHint != layout2->langHint) || (layout1->overallDirection != layout2->overallDirection))
+                    {
+                        layoutFailureCount++;
+                    }
+                    
+                    if ((metrics1.advance != metrics2.advance) || (metrics1.maxHeight != metrics2.maxHeight) || (metrics1.maxAscent != metrics2.maxAscent) || (metrics1.maxDescent != metrics2.maxDescent))
+                    {
+                        measurementFailureCount++;
+                    }
+                }
+            }
+            
+            size_t comparisonCount = lines.size() * 3;
+            size_t simpleCount = font.getSimpleLineCount() / 2; // EACH LINE IS LAID-OUT AND MEASURED
+            
+            double seconds[2];
+            
+            for (int path = 0; path < 2; path++)
+            {
+                font.useSimpleText = (path == 1);
+                ci::Timer timer(true);
+                
+                for (int i = 0; i < iterationCount; i++)
+                {
+                    for (auto &line : lines)
+                    {
+                        delete font.createLineLayout(line);
+                    }
+                }
+                
+                seconds[path] = timer.getSeconds();
+            }
+            
+            LOGI << pass << ": "
+            << simpleCount << "/" << comparisonCount << " LINES VIA THE FAST-PATH | "
+            << layoutFailureCount << " DIFFERENT LAYOUTS | "
+            << measurementFailureCount << " DIFFERENT MEASUREMENTS | "
+            << (lines.size() * iterationCount / seconds[0]) << " LINES PER SECOND (REGULAR) | "
+            << (lines.size() * iterationCount / seconds[1]) << " LINES PER SECOND (FAST-PATH) | "
+            << "SPEEDUP: " << (seconds[0] / seconds[1]) << std::endl;
+            
+            success &= (layoutFailureCount == 0) && (measurementFailureCount == 0) && (simpleCount == comparisonCount);
+        }
+        
+        wordCache.setEnabled(wasWordCacheEnabled);
+        widthCache.setEnabled(wasWidthCacheEnabled);
+        font.useSimpleText = wasSimpleTextUsed;
+        
+        return success;
+    }
+    
+    /*
+     * COMPARING THE NATIVE GLYPH-QUERIES (SEE OpenTypeTables) WITH THE ONES OF FREETYPE, FOR EACH ActualFont LOADED WHILE SHAPING THE LINES:
+     *
+     * 1) EXHAUSTIVELY: EACH UNICODE CODEPOINT AND EACH GLYPH-ID
+     * 2) THE RESULTING LAYOUTS (WITHOUT WordCache NOR SIMPLE-TEXT FAST-PATH, I.E. EACH LINE IS FULLY SHAPED)
+     *
+     * RETURNS FALSE IF THERE IS ANY DIFFERENCE
+     */
+    static bool nativeFontFuncs(FontManager &fontManager, VirtualFont &font, const std::vector<std::string> &sentences, int lineCount = 1000, int maxSentencesPerLine = 3, int iterationCount = 10)
+    {
+        auto lines = createRandomLines(sentences, lineCount, maxSentencesPerLine);
+        
+        auto &wordCache = fontManager.wordCache;
+        bool wasWordCacheEnabled = wordCache.isEnabled();
+        bool wasSimpleTextUsed = font.useSimpleText;
+        
+        wordCache.setEnabled(false);
+        font.useSimpleText = false;
+        
+        int layoutFailureCount = 0;
+        
+        for (auto &line : lines)
+        {
+            setNativeFontFuncs(fontManager, true);
+            std::unique_ptr<LineLayout> layout1(font.createLineLayout(line));
+            
+            setNativeFontFuncs(fontManager, false);
+            std::unique_ptr<LineLayout> layout2(font.createLineLayout(line));
+            
+            if (!sameLayouts(*layout1, *layout2))
+            {
+                layoutFailureCount++;
+            }
+        }
+        
+        bool success = (layoutFailureCount == 0);
+        
+        for (auto &it : fontManager.actualFonts)
+        {
+            auto actualFont = it.second.get();
+            
+            if (actualFont->loaded)
+            {
+                if (!actualFont->openTypeCache)
+                {
+                    LOGI << actualFont->getFullName() << " " << actualFont->baseSize << ": NATIVE GLYPH-QUERIES NOT USABLE" << std::endl;
+                    continue;
+                }
+                
+                auto tables = actualFont->face->getOpenTypeTables();
+                auto cache = actualFont->openTypeCache.get();
+                auto parent = hb_font_get_parent(actualFont->hbFont);
+                
+                int glyphFailureCount = 0;
+                int advanceFailureCount = 0;
+                
+                std::lock_guard<std::mutex> lock(actualFont->face->mutex);
+                FT_Activate_Size(actualFont->ftSize);
+                
+                for (hb_codepoint_t unicode = 0; unicode <= 0x10ffff; unicode++)
+                {
+                    hb_codepoint_t glyph1 = 0;
+                    hb_codepoint_t glyph2 = 0;
+                    
+                    bool found1 = tables->getGlyph(cache, unicode, &glyph1);
+                    bool found2 = hb_font_get_glyph(parent, unicode, 0, &glyph2);
+                    
+                    if ((found1 != found2) || (glyph1 != glyph2))
+                    {
+                        glyphFailureCount++;
+                    }
+                }
+                
+                for (hb_codepoint_t glyph = 0; glyph <= actualFont->ftFace->num_glyphs; glyph++) // INCLUDING ONE OUT-OF-RANGE GLYPH
+                {
+                    if (tables->getHAdvance(cache, glyph) != hb_font_get_glyph_h_advance(parent, glyph))
+                    {
+                        advanceFailureCount++;
+                    }
+                }
+                
+                LOGI << actualFont->getFullName() << " " << actualFont->baseSize << ": "
+                << glyphFailureCount << " DIFFERENT GLYPHS | "
+                << advanceFailureCount << "/" << (actualFont->ftFace->num_glyphs + 1) << " DIFFERENT ADVANCES" << std::endl;
+                
+                success &= (glyphFailureCount == 0) && (advanceFailureCount == 0);
+            }
+        }
+        
+        double seconds[2];
+        
+        for (int path = 0; path < 2; path++)
+        {
+            setNativeFontFuncs(fontManager, path == 1);
+            ci::Timer timer(true);
+            
+            for (int i = 0; i < iterationCount; i++)
+            {
+                for (auto &line : lines)
+                {
+                    delete font.createLineLayout(line);
+                }
+            }
+            
+            seconds[path] = timer.getSeconds();
+        }
+        
+        LOGI << layoutFailureCount << "/" << lines.size() << " DIFFERENT LAYOUTS | "
+        << (lines.size() * iterationCount / seconds[0]) << " LINES PER SECOND (FREETYPE) | "
+        << (lines.size() * iterationCount / seconds[1]) << " LINES PER SECOND (NATIVE) | "
+        << "SPEEDUP: " << (seconds[0] / seconds[1]) << std::endl;
+        
+        setNativeFontFuncs(fontManager, true);
+        wordCache.setEnabled(wasWordCacheEnabled);
+        font.useSimpleText = wasSimpleTextUsed;
+        
+        return success;
+    }
+    
+    /*
+     * SHAPING THE LINES WITH DIFFERENT FEATURE-LISTS (WITHOUT WordCache NOR SIMPLE-TEXT FAST-PATH, I.E. EACH LINE IS FULLY SHAPED):
+     *
+     * - NUMBER OF LAYOUTS DIFFERING FROM THE ONES WITHOUT FEATURES
+     * - LINES PER SECOND: WITH FEATURES, THE SHAPE-PLANS ARE NOW CACHED BY HARFBUZZ (SEE hb-shape-plan.cc),
+     *   I.E. THE COST SHOULD BE THE SAME AS WITHOUT FEATURES
+     *
+     * RETURNS FALSE IF THE FEATURES ENABLED BY DEFAULT ("kern,liga") ARE CHANGING ANY LAYOUT,
+     * OR IF THE LayoutCache IS NOT DISTINGUISHING BETWEEN FEATURE-LISTS
+     */
+    static bool featureShaping(FontManager &fontManager, VirtualFont &font, const std::vector<std::string> &sentences, int lineCount = 1000, int maxSentencesPerLine = 3, int iterationCount = 10)
+    {
+        auto lines = createRandomLines(sentences, lineCount, maxSentencesPerLine);
+        
+        auto &wordCache = fontManager.wordCache;
+        bool wasWordCacheEnabled = wordCache.isEnabled();
+        bool wasSimpleTextUsed = font.useSimpleText;
+        
+        wordCache.setEnabled(false);
+        font.useSimpleText = false;
+        
+        bool success = true;
+        
+        for (auto input : {"", "liga=1,kern", "kern=0", "-liga,-kern,tnum"})
+        {
+            FeatureList features(input);
+            int differenceCount = 0;
+            
+            for (auto &line : lines)
+            {
+                std::unique_ptr<LineLayout> layout1(font.createLineLayout(line));
+                std::unique_ptr<LineLayout> layout2(font.createLineLayout(line, "", HB_DIRECTION_INVALID, features));
+                
+                if (!sameLayouts(*layout1, *layout2))
+                {
+                    differenceCount++;
+                }
+            }
+            
+            ci::Timer timer(true);
+            
+            for (int i = 0; i < iterationCount; i++)
+            {
+                for (auto &line : lines)
+                {
+                    delete font.createLineLayout(line, "", HB_DIRECTION_INVALID, features);
+                }
+            }
+            
+            double seconds = timer.getSeconds();
+            
+            LOGI << "FEATURES [" << features.toString() << "]: "
+            << differenceCount << "/" << lines.size() << " DIFFERENT LAYOUTS | "
+            << (lines.size() * iterationCount / seconds) << " LINES PER SECOND" << std::endl;
+            
+            if (features == FeatureList("kern,liga"))
+            {
+                success &= (differenceCount == 0);
+            }
+        }
+        
+        auto layout1 = font.getCachedLineLayout(lines.front());
+        auto layout2 = font.getCachedLineLayout(lines.front(), "", HB_DIRECTION_INVALID, FeatureList("kern=0"));
+        auto layout3 = font.getCachedLineLayout(lines.front(), "", HB_DIRECTION_INVALID, FeatureList("kern=0"));
+        
+        success &= (layout1 != layout2) && (layout2 == layout3);
+        
+        wordCache.setEnabled(wasWordCacheEnabled);
+        font.useSimpleText = wasSimpleTextUsed;
+        
+        return success;
+    }
+    
+    /*
+     * EDITING LINES VIA VirtualFont::editLineLayout(), WITHOUT AND WITH THE WordCache:
+     *
+     * 1) editCount RANDOM EDITS (SEED 123): REMOVALS OF A FEW CHARACTERS, OR INSERTIONS OF FRAGMENTS OF sentences (E.G. MIXING LTR AND RTL),
+     *    AT RANDOM OFFSETS, STARTING FROM A LINE OF RANDOM sentences: EACH RESULT IS COMPARED WITH createLineLayout() FOR THE SAME TEXT
+     * 2) PER-KEYSTROKE LATENCY ON A LINE OF AT LEAST lineLength UTF-8 BYTES: TYPING A CHARACTER AT A RANDOM OFFSET, THEN ERASING IT,
+     *    VIA createLineLayout() AND VIA editLineLayout()
+     *
+     * RETURNS FALSE IF ANY LAYOUT IS NOT IDENTICAL
+     */
+    static bool incrementalLayout(FontManager &fontManager, VirtualFont &font, const std::vector<std::string> &sentences, int editCount = 1000, size_t lineLength = 2048, int keystrokeCount = 250)
+    {
+        auto &wordCache = fontManager.wordCache;
+        bool wasWordCacheEnabled = wordCache.isEnabled();
+        
+        bool success = true;
+        ci::Rand rnd(123);
+        
+        for (auto pass : {"NO WORD CACHE", "WORD CACHE"})
+        {
+            wordCache.setEnabled(pass == std::string("WORD CACHE"));
+            
+            int failureCount = 0;
+            std::unique_ptr<LineLayout> layout(font.createEditableLineLayout(createRandomLines(sentences, 1, 5).front()));
+            
+            for (int i = 0; i < editCount; i++)
+            {
+                auto &text = layout->source->line.text;
+                int32_t length = text.length();
+                int32_t offset = getCharStart(text, rnd.nextInt(length + 1));
+                
+                int32_t removedLength = 0;
+                std::string inserted;
+                
+                if ((length > 0) && (rnd.nextBool() || (length > 500)))
+                {
+                    removedLength = getCharStart(text, offset + rnd.nextInt(1, 8)) - offset;
+                }
+                else if (rnd.nextInt(4) == 0)
+                {
+                    static const char* pairedCharacters[] = {"(", ")", "[", "]", u8"\u00ab", u8"\u00bb"}; // AFFECTING THE SCRIPT OF THE ENCLOSED TEXT
+                    inserted = pairedCharacters[rnd.nextInt(6)];
+                }
+                else
+                {
+                    auto sentence = UnicodeString::fromUTF8(sentences[rnd.nextInt(sentences.size())]);
+                    int32_t start = getCharStart(sentence, rnd.nextInt(std::max(1, sentence.length())));
+                    int32_t end = std::max(getCharStart(sentence, start + rnd.nextInt(1, 12)), sentence.moveIndex32(start, 1));
+                    
+                    UnicodeString(sentence, start, end - start).toUTF8String(inserted);
+                }
+                
+                layout.reset(font.editLineLayout(*layout, offset, removedLength, inserted));
+                
+                std::string utf8;
+                layout->source->line.text.toUTF8String(utf8);
+                std::unique_ptr<LineLayout> reference(font.createLineLayout(utf8));
+                
+                if (!sameLayouts(*layout, *reference) || (layout->langHint != reference->langHint) || (layout->overallDirection != reference->overallDirection) || !sameRuns(layout->source->line.runs, fontManager.itemizer.processLine(utf8).runs))
+                {
+                    failureCount++;
+                }
+            }
+            
+            // ---
+            
+            std::string line;
+            
+            while (line.size() < lineLength)
+            {
+                line += sentences[rnd.nextInt(sentences.size())];
+                line += " ";
+            }
+            
+            auto text = UnicodeString::fromUTF8(line);
+            std::vector<std::pair<int32_t, std::string>> keystrokes; // OFFSET, AND EDITED TEXT (FOR createLineLayout)
+            
+            for (int i = 0; i < keystrokeCount; i++)
+            {
+                int32_t offset = getCharStart(text, rnd.nextInt(text.length() + 1));
+                
+                std::string edited;
+                UnicodeString(text).insert(offset, 'e').toUTF8String(edited);
+                
+                keystrokes.emplace_back(offset, edited);
+            }
+            
+            font.resetShapingCounters();
+            ci::Timer timer1(true);
+            
+            for (auto &keystroke : keystrokes)
+            {
+                delete font.createLineLayout(keystroke.second);
+                delete font.createLineLayout(line);
+            }
+            
+            timer1.stop();
+            auto fullCodeUnitCount = font.getShapedCodeUnitCount();
+            
+            layout.reset(font.createEditableLineLayout(line));
+            font.resetShapingCounters();
+            ci::Timer timer2(true);
+            
+            for (auto &keystroke : keystrokes)
+            {
+                layout.reset(font.editLineLayout(*layout, keystroke.first, 0, "e"));
+                layout.reset(font.editLineLayout(*layout, keystroke.first, 1, ""));
+            }
+            
+            timer2.stop();
+            auto incrementalCodeUnitCount = font.getShapedCodeUnitCount();
+            
+            int keystrokeEditCount = keystrokeCount * 2;
+            
+            LOGI << pass << ": "
+            << failureCount << "/" << editCount << " DIFFERENT LAYOUTS | "
+            << line.size() << " BYTES | "
+            << (timer1.getSeconds() * 1000 / keystrokeEditCount) << " MS PER KEYSTROKE (FULL) | "
+            << (timer2.getSeconds() * 1000 / keystrokeEditCount) << " MS PER KEYSTROKE (INCREMENTAL) | "
+            << (fullCodeUnitCount / keystrokeEditCount) << " VS " << (incrementalCodeUnitCount / keystrokeEditCount) << " CODE-UNITS SHAPED PER KEYSTROKE" << std::endl;
+            
+            success &= (failureCount == 0);
+        }
+        
+        wordCache.setEnabled(wasWordCacheEnabled);
+        
+        return success;
+    }
+    
+    /*
+     * MERGING THE SCRIPT-ITEMS AND THE DIRECTION-ITEMS INTO RUNS (SEE TextItemizer::mergeItems), FOR LINES OF RANDOM sentences (I.E. MIXING LTR AND RTL):
+     *
+     * 1) EQUIVALENCE: THE RUNS OF TextItemizer::processLine() ARE COMPARED WITH THE ONES OF THE PREVIOUS (QUADRATIC) IMPLEMENTATION,
+     *    FOR lineCount RANDOM LINES, AND FOR THE LINES OF STEP 2
+     * 2) SCALING: NANOSECONDS PER CHARACTER, FOR LINES OF 100 TO 100K CHARACTERS:
+     *    FOR THE WHOLE ITEMIZATION (processLine), AND FOR THE PREVIOUS MERGING ALONE
+     *
+     * RETURNS FALSE IF ANY LINE IS MERGED DIFFERENTLY
+     */
+    static bool runMerging(FontManager &fontManager, const std::vector<std::string> &sentences, int lineCount = 1000, int maxSentencesPerLine = 3)
+    {
+        auto &itemizer = fontManager.itemizer;
+        auto &context = ShapingContext::getDefault();
+        
+        int failureCount = 0;
+        std::vector<TextRun> previousRuns;
+        
+        for (auto &line : createRandomLines(sentences, lineCount, maxSentencesPerLine))
+        {
+            itemizer.processLine(context, line);
+            mergeItemsPreviously(context.scriptAndLanguageItems, context.directionItems, previousRuns);
+            
+            if (!sameRuns(context.line.runs, previousRuns))
+            {
+                failureCount++;
+            }
+        }
+        
+        LOGI << failureCount << "/" << lineCount << " DIFFERENTLY MERGED LINES" << std::endl;
+        
+        ci::Rand rnd(123);
+        
+        for (int32_t length = 100; length <= 100000; length *= 10)
+        {
+            UnicodeString text;
+            
+            while (text.length() < length)
+            {
+                text += UnicodeString::fromUTF8(sentences[rnd.nextInt(sentences.size())] + " ");
+            }
+            
+            std::string line;
+            text.tempSubString(0, getCharStart(text, length)).toUTF8String(line);
+            
+            itemizer.processLine(context, line);
+            mergeItemsPreviously(context.scriptAndLanguageItems, context.directionItems, previousRuns);
+            
+            bool different = !sameRuns(context.line.runs, previousRuns);
+            auto runCount = context.line.runs.size();
+            
+            int iterationCount = std::max(1, 1000000 / length);
+            ci::Timer timer1(true);
+            
+            for (int i = 0; i < iterationCount; i++)
+            {
+                itemizer.processLine(context, line);
+            }
+            
+            timer1.stop();
+            ci::Timer timer2(true);
+            
+            for (int i = 0; i < iterationCount; i++)
+            {
+                mergeItemsPreviously(context.scriptAndLanguageItems, context.directionItems, previousRuns);
+            }
+            
+            timer2.stop();
+            double scale = 1e9 / (double(iterationCount) * length);
+            
+            LOGI << length << " CHARACTERS | "
+            << runCount << " RUNS | "
+            << (different ? "DIFFERENT" : "SAME") << " RUNS | "
+            << (timer1.getSeconds() * scale) << " NS PER CHARACTER (ITEMIZATION) | "
+            << (timer2.getSeconds() * scale) << " NS PER CHARACTER (PREVIOUS MERGING ALONE)" << std::endl;
+            
+            if (different)
+            {
+                failureCount++;
+            }
+        }
+        
+        return (failureCount == 0);
+    }
+    
+    /*
+     * ITEMIZING AND LAYING-OUT lineCount SHORT LINES (SEED 123): 1 TO maxWordsPerLine CONSECUTIVE WORDS OF A RANDOM sentence,
+     * WITHOUT AND WITH A langHint (THE SIMPLE-TEXT FAST-PATH IS DISABLED, I.E. ALL THE LINES ARE GOING THROUGH THE ITEMIZER)
+     *
+     * - LINES PER SECOND FOR TextItemizer::processLine() AND FOR VirtualFont::createLineLayout()
+     * - ALLOCATIONS PER LINE FOR processLine(), ONCE THE ShapingContext HAS GROWN ENOUGH
+     */
+    static void shortLines(FontManager &fontManager, VirtualFont &font, const std::vector<std::string> &sentences, int lineCount = 10000, int maxWordsPerLine = 4, int iterationCount = 10)
+    {
+        auto lines = createShortLines(sentences, lineCount, maxWordsPerLine);
+        
+        auto &itemizer = fontManager.itemizer;
+        auto &context = ShapingContext::getDefault();
+        
+        bool wasSimpleTextUsed = font.useSimpleText;
+        font.useSimpleText = false;
+        
+        for (auto langHint : {Language(), Language("en")}) // INTERNED ONCE
+        {
+            for (auto &line : lines)
+            {
+                delete font.createLineLayout(context, line, langHint); // GROWING THE ShapingContext, CACHING THE GLYPHS AND THE WORDS
+            }
+            
+            auto count = AllocationCounter::getCount();
+            ci::Timer timer1(true);
+            
+            for (int i = 0; i < iterationCount; i++)
+            {
+                for (auto &line : lines)
+                {
+                    itemizer.processLine(context, line, langHint);
+                }
+            }
+            
+            timer1.stop();
+            auto allocationCount = AllocationCounter::getCount() - count;
+            
+            ci::Timer timer2(true);
+            
+            for (int i = 0; i < iterationCount; i++)
+            {
+                for (auto &line : lines)
+                {
+                    delete font.createLineLayout(context, line, langHint);
+                }
+            }
+            
+            timer2.stop();
+            double total = double(lines.size()) * iterationCount;
+            
+            LOGI << "LANG-HINT [" << langHint.toString() << "]: "
+            << (total / timer1.getSeconds()) << " LINES PER SECOND (ITEMIZATION) | "
+            << (total / timer2.getSeconds()) << " LINES PER SECOND (LAYOUT) | "
+            << formatAllocations(allocationCount / total) << " ALLOCATIONS PER LINE (ITEMIZATION)" << std::endl;
+        }
+        
+        font.useSimpleText = wasSimpleTextUsed;
+    }
+    
+    /*
+     * THE COST OF LangHelper:
+     *
+     * - CONSTRUCTION (E.G. ONCE PER FontManager), IN MICROSECONDS
+     * - detectLanguage() FOR THE SCRIPTS OF THE RUNS OF sentences, WITHOUT AND WITH A langHint, IN NANOSECONDS PER CALL
+     */
+    static void languageDetection(FontManager &fontManager, const std::vector<std::string> &sentences, int constructionCount = 100, int iterationCount = 1000)
+    {
+        ci::Timer timer1(true);
+        
+        for (int i = 0; i < constructionCount; i++)
+        {
+            LangHelper langHelper;
+        }
+        
+        timer1.stop();
+        
+        LOGI << "CONSTRUCTION: " << (timer1.getSeconds() * 1e6 / constructionCount) << " MICROSECONDS" << std::endl;
+        
+        std::vector<hb_script_t> scripts;
+        
+        for (auto &sentence : sentences)
+        {
+            for (auto &run : fontManager.itemizer.processLine(sentence).runs)
+            {
+                scripts.push_back(run.script);
+            }
+        }
+        
+        auto &langHelper = fontManager.langHelper;
+        
+        for (auto langHint : {Language(), Language("ja")})
+        {
+            int hintedCount = 0;
+            ci::Timer timer2(true);
+            
+            for (int i = 0; i < iterationCount; i++)
+            {
+                for (auto script : scripts)
+                {
+                    hintedCount += (langHelper.detectLanguage(script, langHint) == langHint);
+                }
+            }
+            
+            timer2.stop();
+            
+            LOGI << "LANG-HINT [" << langHint.toString() << "]: "
+            << (timer2.getSeconds() * 1e9 / (double(scripts.size()) * iterationCount)) << " NANOSECONDS PER CALL | "
+            << (hintedCount / iterationCount) << "/" << scripts.size() << " RUNS RESOLVED TO THE LANG-HINT" << std::endl;
+        }
+    }
+    
+    /*
+     * WRAPPING PARAGRAPHS VIA TextItemizer::processParagraph() AND processParagraphLine()
+     *
+     * 1) CORRECTNESS, FOR THE BIDI EXAMPLES OF http://people.w3.org/rishida/scripts/bidi (AS IN SimpleBIDI):
+     *    - THE WHOLE RANGE OF EACH PARAGRAPH HAS THE SAME RUNS AS WITH TextItemizer::processText()
+     *    - WRAPPED AT EACH WIDTH BETWEEN 1 AND THE LENGTH OF THE PARAGRAPH: THE RUNS OF EACH LINE ARE MATCHING
+     *      THE VISUAL-MAP AND THE LEVELS OF AN INDEPENDENT ubidi_setLine(), AND THE SCRIPTS OF THE PARAGRAPH
+     *    - ALSO COUNTING THE LINES WHICH WOULD BE ITEMIZED DIFFERENTLY ALONE (I.E. LOSING THEIR BIDI-CONTEXT)
+     *
+     * 2) RE-WRAPPING A PARAGRAPH OF paragraphLength CODE-UNITS, MIXING HEBREW AND ENGLISH, AT WIDTHS FROM minWidth TO maxWidth (IN CODE-UNITS):
+     *    ITEMIZING EACH LINE ALONE VIA processText(), VERSUS DERIVING IT FROM A PARAGRAPH PROCESSED ONCE
+     *
+     * RETURNS FALSE IF ANY LINE IS WRONG
+     */
+    static bool paragraphWrapping(FontManager &fontManager, int32_t paragraphLength = 5000, int32_t minWidth = 20, int32_t maxWidth = 200, int iterationCount = 10)
+    {
+        auto &itemizer = fontManager.itemizer;
+        auto &context = ShapingContext::getDefault();
+        
+        TextParagraph paragraph;
+        std::vector<TextRun> runs;
+        
+        UBiDi *referenceParagraph = ubidi_open();
+        UBiDi *referenceLine = ubidi_open();
+        
+        int lineCount = 0;
+        int failureCount = 0;
+        int contextCount = 0;
+        
+        for (auto &example : getBidiExamples())
+        {
+            auto text = UnicodeString::fromUTF8(example.first);
+            auto length = text.length();
+            
+            itemizer.processParagraph(paragraph, text, Language(), example.second);
+            runs = itemizer.processParagraphLine(context, paragraph, 0, length).runs;
+            
+            if (!sameRuns(runs, itemizer.processText(context, text, Language(), example.second).runs))
+            {
+                failureCount++;
+            }
+            
+            UErrorCode error = U_ZERO_ERROR;
+            ubidi_setPara(referenceParagraph, text.getBuffer(), length, (example.second == HB_DIRECTION_RTL) ? 1 : UBIDI_DEFAULT_LTR, 0, &error);
+            
+            for (int32_t width = 1; width <= length; width++)
+            {
+                for (auto &range : wrapParagraph(text, width))
+                {
+                    error = U_ZERO_ERROR;
+                    ubidi_setLine(referenceParagraph, range.first, range.second, referenceLine, &error);
+                    runs = itemizer.processParagraphLine(context, paragraph, range.first, range.second).runs;
+                    
+                    if (!checkParagraphLine(paragraph, runs, range.first, referenceLine))
+                    {
+                        failureCount++;
+                    }
+                    
+                    if (!sameRuns(runs, itemizer.processText(context, text.tempSubString(range.first, range.second - range.first), Language(), example.second).runs))
+                    {
+                        contextCount++;
+                    }
+                    
+                    lineCount++;
+                }
+            }
+        }
+        
+        ubidi_close(referenceLine);
+        ubidi_close(referenceParagraph);
+        
+        LOGI << failureCount << "/" << lineCount << " WRONG LINES | "
+        << contextCount << "/" << lineCount << " LINES ITEMIZED DIFFERENTLY ALONE" << std::endl;
+        
+        // ---
+        
+        auto examples = getBidiExamples();
+        UnicodeString text;
+        
+        for (int i = 0; text.length() < paragraphLength; i++)
+        {
+            auto &example = examples[(i % 2) ? 7 : (((i / 2) % 2) ? 3 : 4)]; // HEBREW, INTERLEAVED WITH THE EXAMPLES MIXING HEBREW AND ENGLISH
+            text += UnicodeString::fromUTF8(example.first + " ");
+        }
+        
+        text.truncate(getCharStart(text, paragraphLength));
+        
+        ci::Timer timer1(true);
+        
+        for (int i = 0; i < iterationCount; i++)
+        {
+            itemizer.processParagraph(paragraph, text, Language(), HB_DIRECTION_RTL);
+        }
+        
+        timer1.stop();
+        
+        LOGI << text.length() << " CODE-UNITS | " << (timer1.getSeconds() * 1e6 / iterationCount) << " MICROSECONDS PER processParagraph()" << std::endl;
+        
+        double total1 = 0;
+        double total2 = 0;
+        
+        for (int32_t width = minWidth; width <= maxWidth; width += 10)
+        {
+            auto ranges = wrapParagraph(text, width);
+            
+            ci::Timer timer2(true);
+            
+            for (int i = 0; i < iterationCount; i++)
+            {
+                for (auto &range : ranges)
+                {
+                    itemizer.processText(context, text.tempSubString(range.first, range.second - range.first), Language(), HB_DIRECTION_RTL);
+                }
+            }
+            
+            timer2.stop();
+            ci::Timer timer3(true);
+            
+            for (int i = 0; i < iterationCount; i++)
+            {
+                for (auto &range : ranges)
+                {
+                    itemizer.processParagraphLine(context, paragraph, range.first, range.second);
+                }
+            }
+            
+            timer3.stop();
+            
+            total1 += timer2.getSeconds();
+            total2 += timer3.getSeconds();
+            
+            LOGI << "WIDTH " << width << " | "
+            << ranges.size() << " LINES | "
+            << (timer2.getSeconds() * 1e6 / iterationCount) << " MICROSECONDS (LINES ALONE) | "
+            << (timer3.getSeconds() * 1e6 / iterationCount) << " MICROSECONDS (PARAGRAPH-LINES)" << std::endl;
+        }
+        
+        LOGI << "ALL WIDTHS: "
+        << (total1 * 1e3 / iterationCount) << " MILLISECONDS (LINES ALONE) | "
+        << (total2 * 1e3 / iterationCount) << " MILLISECONDS (PARAGRAPH-LINES)" << std::endl;
+        
+        return (failureCount == 0);
+    }
+    
+    /*
+     * A UI-SCREEN OF lineCount SHORT LINES (AS IN shortLines()), LAID-OUT WITH EACH OF fonts (E.G. THE SAME LABELS IN THREE STYLES)
+     * THE LayoutCache IS NOT INVOLVED (ITS KEYS ARE INCLUDING THE VirtualFont), THE WordCache IS WARM,
+     * AND THE LATIN-1 LINES ARE TAKING THE SIMPLE-TEXT FAST-PATH (I.E. THEY ARE NOT ITEMIZED)
+     *
+     * - MILLISECONDS PER SCREEN, WITHOUT AND WITH THE ItemizationCache (CLEARED BEFORE EACH SCREEN)
+     * - HITS AND MISSES OF THE ItemizationCache, AND ITS MEMORY-USAGE ONCE A SCREEN IS LAID-OUT
+     * - CORRECTNESS: THE LAYOUTS ARE IDENTICAL WITHOUT THE ItemizationCache, UPON MISS AND UPON HIT
+     *
+     * RETURNS FALSE IF ANY LAYOUT IS DIFFERENT
+     */
+    static bool itemizationCaching(FontManager &fontManager, const std::vector<std::shared_ptr<VirtualFont>> &fonts, const std::vector<std::string> &sentences, int lineCount = 100, int maxWordsPerLine = 4, int iterationCount = 100)
+    {
+        auto lines = createShortLines(sentences, lineCount, maxWordsPerLine);
+        
+        auto &itemizationCache = fontManager.itemizationCache;
+        bool wasEnabled = itemizationCache.isEnabled();
+        
+        int failureCount = 0;
+        itemizationCache.clear();
+        
+        for (auto &font : fonts)
+        {
+            for (auto &line : lines)
+            {
+                itemizationCache.setEnabled(false);
+                std::unique_ptr<LineLayout> reference(font->createLineLayout(line)); // ALSO CACHING THE GLYPHS AND THE WORDS
+                
+                itemizationCache.setEnabled(true);
+                
+                for (int i = 0; i < 2; i++)
+                {
+                    std::unique_ptr<LineLayout> layout(font->createLineLayout(line));
+                    
+                    if (!sameLayouts(*reference, *layout) || (reference->langHint != layout->langHint) || (reference->overallDirection != layout->overallDirection))
+                    {
+                        failureCount++;
+                    }
+                }
+            }
+        }
+        
+        LOGI << failureCount << "/" << (fonts.size() * lines.size() * 2) << " DIFFERENT LAYOUTS" << std::endl;
+        
+        auto &context = ShapingContext::getDefault();
+        
+        for (auto enabled : {false, true})
+        {
+            itemizationCache.setEnabled(enabled);
+            itemizationCache.resetCounters();
+            
+            ci::Timer timer(true);
+            
+            for (int i = 0; i < iterationCount; i++)
+            {
+                itemizationCache.clear();
+                
+                for (auto &font : fonts)
+                {
+                    for (auto &line : lines)
+                    {
+                        delete font->createLineLayout(context, line);
+                    }
+                }
+            }
+            
+            timer.stop();
+            
+            LOGI << (enabled ? "ITEMIZATION CACHE" : "NO ITEMIZATION CACHE") << ": "
+            << (timer.getSeconds() * 1e3 / iterationCount) << " MILLISECONDS PER SCREEN | "
+            << (itemizationCache.getHitCount() / iterationCount) << " HITS | "
+            << (itemizationCache.getMissCount() / iterationCount) << " MISSES | "
+            << itemizationCache.getMemoryUsage() << " BYTES" << std::endl;
+        }
+        
+        itemizationCache.setEnabled(wasEnabled);
+        return (failureCount == 0);
+    }
+    
+protected:
+    /*
+     * "N/A" WHEN THE ALLOCATIONS ARE NOT COUNTED (SEE AllocationCounter)
+     */
+    static std::string formatAllocations(double count)
+    {
+        return AllocationCounter::isEnabled() ? chr::toString(count) : "N/A";
+    }
+    
+    static void setNativeFontFuncs(FontManager &fontManager, bool enabled)
+    {
+        for (auto &it : fontManager.actualFonts)
+        {
+            it.second->useNativeFontFuncs = enabled;
+        }
+    }
+    
+    /*
+     * THE START OF THE CHARACTER AT index (OR THE LENGTH OF text, BEYOND ITS END), I.E. NOT SPLITTING SURROGATE-PAIRS
+     */
+    static int32_t getCharStart(const UnicodeString &text, int32_t index)
+    {
+        return (index >= text.length()) ? text.length() : text.getChar32Start(index);
+    }
+    
+    /*
+     * FROM http://people.w3.org/rishida/scripts/bidi (SEE SimpleBIDI/src/Test.cpp), WITH THEIR OVERALL-DIRECTION
+     */
+    static std::vector<std::pair<std::string, hb_direction_t>> getBidiExamples()
+    {
+        return
+        {
+            { u8"The title is مفتاح معايير الويب in Arabic.", HB_DIRECTION_INVALID },
+            { u8"The title is \"مفتاح معايير الويب!\u200f\" in Arabic.", HB_DIRECTION_INVALID },
+            { u8"The names of these states in Arabic are مصر,‎ البحرين and الكويت respectively.", HB_DIRECTION_INVALID },
+            { u8"W3C‏ (World Wide Web Consortium) מעביר את שירותי הארחה באירופה ל - ERCIM.", HB_DIRECTION_RTL },
+            { u8"The title says \"W3C, פעילות הבינאום\" in Hebrew.", HB_DIRECTION_INVALID },
+            { u8"one two ثلاثة four خمسة", HB_DIRECTION_INVALID },
+            { u8"one two ثلاثة 1234 خمسة", HB_DIRECTION_INVALID },
+            { u8"וְהָהַר, מַהוּ לַזֵּה? – זֹאת הִיא הַשְּׁאֵלָה.", HB_DIRECTION_RTL },
+        };
+    }
+    
+    /*
+     * GREEDY WRAPPING: AS MANY WORDS AS POSSIBLE PER LINE (THE SPACES REMAINING AT THE END OF THE LINES)
+     * A WORD LONGER THAN width IS BROKEN BETWEEN CHARACTERS
+     */
+    static std::vector<std::pair<int32_t, int32_t>> wrapParagraph(const UnicodeString &text, int32_t width)
+    {
+        std::vector<std::pair<int32_t, int32_t>> ranges;
+        int32_t start = 0;
+        
+        while (start < text.length())
+        {
+            int32_t end = std::min(text.length(), start + width);
+            
+            if (end < text.length())
+            {
+                int32_t position = end;
+                
+                while ((position > start) && (text[position - 1] != ' '))
+                {
+                    position--;
+                }
+                
+                end = (position > start) ? position : std::max(getCharStart(text, end), text.moveIndex32(start, 1));
+            }
+            
+            ranges.emplace_back(start, end);
+            start = end;
+        }
+        
+        return ranges;
+    }
+    
+    /*
+     * runs: A LINE OF paragraph, STARTING AT start
+     * reference: THE SAME LINE, AS SET BY ubidi_setLine()
+     */
+    static bool checkParagraphLine(const TextParagraph &paragraph, const std::vector<TextRun> &runs, int32_t start, UBiDi *reference)
+    {
+        UErrorCode error = U_ZERO_ERROR;
+        
+        std::vector<int32_t> visualMap(ubidi_getLength(reference));
+        ubidi_getVisualMap(reference, visualMap.data(), &error);
+        
+        size_t visualIndex = 0;
+        
+        for (auto &run : runs)
+        {
+            for (int32_t i = 0; i < run.end - run.start; i++)
+            {
+                auto index = (run.direction == HB_DIRECTION_RTL) ? (run.end - 1 - i) : (run.start + i);
+                
+                if ((visualIndex == visualMap.size()) || (visualMap[visualIndex++] != index))
+                {
+                    return false;
+                }
+                
+                if (((ubidi_getLevelAt(reference, index) & 1) != 0) != (run.direction == HB_DIRECTION_RTL))
+                {
+                    return false;
+                }
+                
+                for (auto &item : paragraph.scriptAndLanguageItems)
+                {
+                    if ((start + index >= item.start) && (start + index < item.end) && (item.data.first != run.script))
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+        
+        return (visualIndex == visualMap.size());
+    }
+    
+    /*
+     * 1 TO maxWordsPerLine CONSECUTIVE WORDS OF A RANDOM sentence (SEED 123)
+     */
+    static std::vector<std::string> createShortLines(const std::vector<std::string> &sentences, int lineCount, int maxWordsPerLine)
+    {
+        std::vector<std::string> lines;
+        ci::Rand rnd(123);
+        
+        for (int i = 0; i < lineCount; i++)
+        {
+            auto words = ci::split(sentences[rnd.nextInt(sentences.size())], " ");
+            int start = rnd.nextInt(words.size());
+            int end = std::min<int>(words.size(), start + rnd.nextInt(1, maxWordsPerLine + 1));
+            
+            std::string line;
+            
+            for (int j = start; j < end; j++)
+            {
+                line += (j > start) ? " " : "";
+                line += words[j];
+            }
+            
+            lines.push_back(line);
+        }
+        
+        return lines;
+    }
+    
+    static std::vector<std::string> createRandomLines(const std::vector<std::string> &sentences, int lineCount, int maxSentencesPerLine)
+    {
+        std::vector<std::string> lines;
+        ci::Rand rnd(123);
+        
+        for (int i = 0; i < lineCount; i++)
+        {
+            std::string line;
+            int sentenceCount = rnd.nextInt(1, maxSentencesPerLine);
+            
+            for (int j = 0; j < sentenceCount; j++)
+            {
+                line += sentences[rnd.nextInt(sentences.size())];
+                line += " ";
+            }
+            
+            lines.push_back(line);
+        }
+        
+        return lines;
+    }
+    
+    /*
+     * RETURNS TRUE IF THE LINE IS SHAPED IDENTICALLY WITH AND WITHOUT THE WordCache
+     */
+    static bool compareLayouts(VirtualFont &font, WordCache &wordCache, const std::string &line)
+    {
+        wordCache.setEnabled(true);
+        std::unique_ptr<LineLayout> layout1(font.createLineLayout(line));
+        
+        wordCache.setEnabled(false);
+        std::unique_ptr<LineLayout> layout2(font.createLineLayout(line));
+        
+        return sameLayouts(*layout1, *layout2);
+    }
+    
+    /*
+     * THE PREVIOUS IMPLEMENTATION OF TextItemizer::mergeItems(), FOR REFERENCE:
+     * LOOKING-UP THE SCRIPT-ITEMS FROM THE START FOR EACH DIRECTION-ITEM, AND INSERTING THE RTL RUNS ONE BY ONE
+     */
+    static void mergeItemsPreviously(const std::vector<TextItemizer::ScriptAndLanguageItem> &scriptAndLanguageItems, const std::vector<TextItemizer::DirectionItem> &directionItems, std::vector<TextRun> &runs)
+    {
+        runs.clear();
+        
+        for (auto &directionItem : directionItems)
+        {
+            auto position = directionItem.start;
+            auto end = directionItem.end;
+            auto rtlInsertionPoint = runs.end();
+            
+            auto scriptAndLanguageIterator = scriptAndLanguageItems.begin();
+            
+            while ((scriptAndLanguageIterator != scriptAndLanguageItems.end()) && ((scriptAndLanguageIterator->start > position) || (scriptAndLanguageIterator->end <= position)))
+            {
+                ++scriptAndLanguageIterator;
+            }
+            
+            while (position < end)
+            {
+                TextRun run;
+                run.start = position;
+                run.end = std::min(scriptAndLanguageIterator->end, end);
+                run.script = scriptAndLanguageIterator->data.first;
+                run.language = scriptAndLanguageIterator->data.second;
+                run.direction = directionItem.data;
+                
+                if (directionItem.data == HB_DIRECTION_LTR)
+                {
+                    runs.push_back(run);
+                }
+                else
+                {
+                    rtlInsertionPoint = runs.insert(rtlInsertionPoint, run);
+                }
+                
+                position = run.end;
+                
+                if (scriptAndLanguageIterator->end == position)
+                {
+                    ++scriptAndLanguageIterator;
+                }
+            }
+        }
+    }
+    
+    static bool sameRuns(const std::vector<TextRun> &runs1, const std::vector<TextRun> &runs2)
+    {
+        if (runs1.size() != runs2.size())
+        {
+            return false;
+        }
+        
+        for (size_t i = 0; i < runs1.size(); i++)
+        {
+            auto &run1 = runs1[i];
+            auto &run2 = runs2[i];
+            
+            if ((run1.start != run2.start) || (run1.end != run2.end) || (run1.script != run2.script) || (run1.language != run2.language) || (run1.direction != run2.direction))
+            {
+                return false;
+            }
+        }
+        
+        return true;
+    }
+    
+    /*
+     * BIT-IDENTICAL: SAME FONTS, GLYPHS, POSITIONS AND ADVANCES
+     */
+    static bool sameLayouts(const LineLayout &layout1, const LineLayout &layout2)
+    {
+        if ((layout1.clusters.size() != layout2.clusters.size()) || (layout1.advance != layout2.advance) || (layout1.maxHeight != layout2.maxHeight) || (layout1.maxAscent != layout2.maxAscent) || (layout1.maxDescent != layout2.maxDescent))
+        {
+            return false;
+        }
+        
+        for (size_t i = 0; i < layout1.clusters.size(); i++)
+        {
+            auto &cluster1 = layout1.clusters[i];
+            auto &cluster2 = layout2.clusters[i];
+            
+            if ((layout1.getFont(cluster1) != layout2.getFont(cluster2)) || (cluster1.combinedAdvance != cluster2.combinedAdvance) || (cluster1.shapeCount != cluster2.shapeCount))
+            {
+                return false;
+            }
+            
+            auto shapes1 = layout1.getShapes(cluster1);
+            auto shapes2 = layout2.getShapes(cluster2);
+            
+            for (int j = 0; j < cluster1.shapeCount; j++)
+            {
+                if ((shapes1[j].codepoint != shapes2[j].codepoint) || (shapes1[j].position != shapes2[j].position))
+                {
+                    return false;
+                }
+            }
+        }
+        
+        return true;
+    }
+    
+    static int drawFrame(VirtualFont &font, const std::vector<std::string> &lines, VirtualFont::Mode mode)
+    {
+        font.begin(mode);
+
+        for (auto &line : lines)
+        {
+            auto layout = font.getCachedLineLayout(line);
+            ci::Vec2f position(0, 0);
+
+            for (auto &cluster : layout->clusters)
+            {
+                font.drawCluster(*layout, cluster, position);
+                position.x += font.getAdvance(cluster);
+            }
+        }
+
+        font.end();
+        return font.getDrawCallCount();
+    }
+};
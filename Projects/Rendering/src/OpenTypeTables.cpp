@@ -0,0 +1,469 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+#include "OpenTypeTables.h"
+
+#include "hb-cache-private.hh"
+#include "hb-ot-cmap-table.hh"
+#include "hb-ot-hmtx-table.hh"
+#include "hb-ot.h"
+
+using namespace std;
+
+struct OpenTypeTables::Cache
+{
+    FT_Fixed xScale;
+
+    hb_cmap_cache_t cmapCache; // UNICODE -> GLYPH (0 FOR THE MISSING CHARACTERS)
+    hb_advance_cache_t advanceCache; // GLYPH -> SCALED ADVANCE
+
+    Cache(FT_Fixed xScale)
+    :
+    xScale(xScale)
+    {
+        cmapCache.clear();
+        advanceCache.clear();
+    }
+};
+
+/*
+ * BIG-ENDIAN READING OF A TABLE (THE HARFBUZZ STRUCTURES ARE NOT EXPOSING THE PAIRS)
+ * OUT-OF-BOUNDS READS ARE RETURNING 0, I.E. A TRUNCATED TABLE IS READ AS EMPTY
+ */
+struct TableReader
+{
+    const uint8_t *data;
+    unsigned int length;
+
+    TableReader(hb_blob_t *blob)
+    {
+        data = reinterpret_cast<const uint8_t*>(hb_blob_get_data(blob, &length));
+    }
+
+    uint16_t u16(unsigned int offset) const
+    {
+        return (offset + 2 <= length) ? ((data[offset] << 8) | data[offset + 1]) : 0;
+    }
+
+    uint32_t u32(unsigned int offset) const
+    {
+        return (uint32_t(u16(offset)) << 16) | u16(offset + 2);
+    }
+
+    bool nonZero(unsigned int offset, unsigned int size) const
+    {
+        for (unsigned int i = 0; i < size; i++)
+        {
+            if ((offset + i < length) && data[offset + i])
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+};
+
+/*
+ * RETURNS THE COVERAGE-INDEX OF glyph, OR -1
+ */
+static int getCoverageIndex(const TableReader &table, unsigned int coverage, hb_codepoint_t glyph)
+{
+    unsigned int count = table.u16(coverage + 2);
+
+    if (table.u16(coverage) == 1)
+    {
+        for (unsigned int i = 0; i < count; i++)
+        {
+            if (table.u16(coverage + 4 + i * 2) == glyph)
+            {
+                return i;
+            }
+        }
+    }
+    else if (table.u16(coverage) == 2)
+    {
+        for (unsigned int i = 0; i < count; i++)
+        {
+            unsigned int record = coverage + 4 + i * 6;
+
+            if ((glyph >= table.u16(record)) && (glyph <= table.u16(record + 2)))
+            {
+                return table.u16(record + 4) + (glyph - table.u16(record));
+            }
+        }
+    }
+
+    return -1;
+}
+
+static unsigned int getClass(const TableReader &table, unsigned int classDef, hb_codepoint_t glyph)
+{
+    if (table.u16(classDef) == 1)
+    {
+        unsigned int startGlyph = table.u16(classDef + 2);
+
+        if ((glyph >= startGlyph) && (glyph < startGlyph + table.u16(classDef + 4)))
+        {
+            return table.u16(classDef + 6 + (glyph - startGlyph) * 2);
+        }
+    }
+    else if (table.u16(classDef) == 2)
+    {
+        unsigned int count = table.u16(classDef + 2);
+
+        for (unsigned int i = 0; i < count; i++)
+        {
+            unsigned int record = classDef + 4 + i * 6;
+
+            if ((glyph >= table.u16(record)) && (glyph <= table.u16(record + 2)))
+            {
+                return table.u16(record + 4);
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * TRUE IF AT LEAST ONE GLYPH OF THE COVERAGE IS OF THE GIVEN CLASS
+ */
+static bool coversClass(const TableReader &table, unsigned int coverage, unsigned int classDef, unsigned int glyphClass)
+{
+    unsigned int count = table.u16(coverage + 2);
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (table.u16(coverage) == 1)
+        {
+            if (getClass(table, classDef, table.u16(coverage + 4 + i * 2)) == glyphClass)
+            {
+                return true;
+            }
+        }
+        else if (table.u16(coverage) == 2)
+        {
+            unsigned int record = coverage + 4 + i * 6;
+
+            for (unsigned int glyph = table.u16(record); glyph <= table.u16(record + 2); glyph++)
+            {
+                if (getClass(table, classDef, glyph) == glyphClass)
+                {
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+static unsigned int getValueSize(uint16_t valueFormat)
+{
+    unsigned int size = 0;
+
+    for (int bit = 0; bit < 8; bit++)
+    {
+        size += (valueFormat >> bit) & 1;
+    }
+
+    return size * 2;
+}
+
+/*
+ * PairPos FORMAT 1 (PAIRS OF GLYPHS) OR FORMAT 2 (PAIRS OF CLASSES)
+ */
+static bool pairPosKerns(const TableReader &table, unsigned int subtable, hb_codepoint_t glyph)
+{
+    unsigned int coverage = subtable + table.u16(subtable + 2);
+    unsigned int size1 = getValueSize(table.u16(subtable + 4));
+    unsigned int size2 = getValueSize(table.u16(subtable + 6));
+    unsigned int recordSize = size1 + size2;
+
+    int coverageIndex = getCoverageIndex(table, coverage, glyph);
+
+    if (table.u16(subtable) == 1)
+    {
+        unsigned int pairSetCount = table.u16(subtable + 8);
+
+        for (unsigned int i = 0; i < pairSetCount; i++)
+        {
+            unsigned int pairSet = subtable + table.u16(subtable + 10 + i * 2);
+            unsigned int pairCount = table.u16(pairSet);
+
+            for (unsigned int j = 0; j < pairCount; j++)
+            {
+                unsigned int record = pairSet + 2 + j * (2 + recordSize);
+
+                if (((int(i) == coverageIndex) || (table.u16(record) == glyph)) && table.nonZero(record + 2, recordSize))
+                {
+                    return true;
+                }
+            }
+        }
+    }
+    else if (table.u16(subtable) == 2)
+    {
+        unsigned int classDef1 = subtable + table.u16(subtable + 8);
+        unsigned int classDef2 = subtable + table.u16(subtable + 10);
+        unsigned int class1Count = table.u16(subtable + 12);
+        unsigned int class2Count = table.u16(subtable + 14);
+        unsigned int records = subtable + 16;
+
+        /*
+         * AS THE FIRST GLYPH: THE ROW OF ITS CLASS (ONLY IF COVERED)
+         */
+        if (coverageIndex >= 0)
+        {
+            unsigned int class1 = getClass(table, classDef1, glyph);
+
+            if ((class1 < class1Count) && table.nonZero(records + class1 * class2Count * recordSize, class2Count * recordSize))
+            {
+                return true;
+            }
+        }
+
+        /*
+         * AS THE SECOND GLYPH: THE COLUMN OF ITS CLASS (CLASS 0 INCLUDED, I.E. THE GLYPHS NOT LISTED IN classDef2),
+         * ONLY FOR THE ROWS OF A CLASS HELD BY A COVERED GLYPH (SOME FONTS ARE DEFINING UNREACHABLE ROWS)
+         */
+        unsigned int class2 = getClass(table, classDef2, glyph);
+
+        if (class2 < class2Count)
+        {
+            for (unsigned int class1 = 0; class1 < class1Count; class1++)
+            {
+                if (table.nonZero(records + (class1 * class2Count + class2) * recordSize, recordSize) && coversClass(table, coverage, classDef1, class1))
+                {
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+static bool gposKerns(const TableReader &table, hb_codepoint_t glyph)
+{
+    unsigned int lookupList = table.u16(8);
+
+    if (!lookupList)
+    {
+        return false;
+    }
+
+    unsigned int lookupCount = table.u16(lookupList);
+
+    for (unsigned int i = 0; i < lookupCount; i++)
+    {
+        unsigned int lookup = lookupList + table.u16(lookupList + 2 + i * 2);
+        unsigned int lookupType = table.u16(lookup);
+        unsigned int subtableCount = table.u16(lookup + 4);
+
+        for (unsigned int j = 0; j < subtableCount; j++)
+        {
+            unsigned int subtable = lookup + table.u16(lookup + 6 + j * 2);
+
+            /*
+             * EXTENSION LOOKUPS ARE POINTING TO THE ACTUAL SUBTABLE VIA A 32-BIT OFFSET
+             */
+            if (lookupType == 9)
+            {
+                if ((table.u16(subtable + 2) == 2) && pairPosKerns(table, subtable + table.u32(subtable + 4), glyph))
+                {
+                    return true;
+                }
+            }
+            else if ((lookupType == 2) && pairPosKerns(table, subtable, glyph))
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/*
+ * ONLY THE (MICROSOFT) VERSION 0 OF THE TABLE, AND ITS FORMAT 0 SUBTABLES, ARE USED BY FREETYPE (FT_Get_Kerning)
+ */
+static bool kernKerns(const TableReader &table, hb_codepoint_t glyph)
+{
+    if (table.u16(0) != 0)
+    {
+        return false;
+    }
+
+    unsigned int subtableCount = table.u16(2);
+    unsigned int subtable = 4;
+
+    for (unsigned int i = 0; i < subtableCount; i++)
+    {
+        unsigned int coverage = table.u16(subtable + 4);
+
+        if ((coverage >> 8) == 0)
+        {
+            unsigned int pairCount = table.u16(subtable + 6);
+
+            for (unsigned int j = 0; j < pairCount; j++)
+            {
+                unsigned int pair = subtable + 14 + j * 6;
+
+                if (((table.u16(pair) == glyph) || (table.u16(pair + 2) == glyph)) && table.u16(pair + 4))
+                {
+                    return true;
+                }
+            }
+        }
+
+        unsigned int length = table.u16(subtable + 2);
+
+        if (length < 6)
+        {
+            break;
+        }
+
+        subtable += length;
+    }
+
+    return false;
+}
+
+void OpenTypeTables::CacheDeleter::operator()(Cache *cache) const
+{
+    delete cache;
+}
+
+OpenTypeTables::OpenTypeTables(hb_face_t *face, FT_Face ftFace)
+:
+subtable(NULL),
+metrics(NULL),
+glyphCount(ftFace->num_glyphs),
+metricCount(0),
+spaceGlyph(0),
+kerningSpace(false)
+{
+    cmapBlob = OT::Sanitizer<OT::cmap>::sanitize(hb_face_reference_table(face, HB_OT_TAG_cmap));
+    hmtxBlob = OT::Sanitizer<OT::hmtx>::sanitize(hb_face_reference_table(face, HB_OT_TAG_hmtx));
+
+    auto charmap = ftFace->charmap;
+    auto hhea = static_cast<TT_HoriHeader*>(FT_Get_Sfnt_Table(ftFace, ft_sfnt_hhea));
+
+    if (charmap && hhea)
+    {
+        auto cmap = OT::Sanitizer<OT::cmap>::lock_instance(cmapBlob);
+        auto candidate = cmap->find_subtable(charmap->platform_id, charmap->encoding_id);
+
+        metricCount = hhea->number_Of_HMetrics;
+
+        if (candidate && candidate->is_supported() && (metricCount > 0) && (hb_blob_get_length(hmtxBlob) >= metricCount * OT::LongHorMetric::static_size))
+        {
+            subtable = candidate;
+            metrics = OT::Sanitizer<OT::hmtx>::lock_instance(hmtxBlob);
+        }
+    }
+
+    if (charmap)
+    {
+        spaceGlyph = FT_Get_Char_Index(ftFace, ' ');
+    }
+
+    if (spaceGlyph)
+    {
+        auto gposBlob = hb_face_reference_table(face, HB_OT_TAG_GPOS);
+        auto kernBlob = hb_face_reference_table(face, HB_TAG('k','e','r','n'));
+
+        kerningSpace = gposKerns(TableReader(gposBlob), spaceGlyph) || kernKerns(TableReader(kernBlob), spaceGlyph);
+
+        hb_blob_destroy(gposBlob);
+        hb_blob_destroy(kernBlob);
+    }
+}
+
+OpenTypeTables::~OpenTypeTables()
+{
+    hb_blob_destroy(cmapBlob);
+    hb_blob_destroy(hmtxBlob);
+}
+
+bool OpenTypeTables::isUsable() const
+{
+    return bool(subtable);
+}
+
+bool OpenTypeTables::coversSpace() const
+{
+    return spaceGlyph != 0;
+}
+
+bool OpenTypeTables::isKerningSpace() const
+{
+    return kerningSpace;
+}
+
+OpenTypeTables::CacheRef OpenTypeTables::createCache(FT_Fixed xScale) const
+{
+    return CacheRef(new Cache(xScale));
+}
+
+bool OpenTypeTables::getGlyph(Cache *cache, hb_codepoint_t unicode, hb_codepoint_t *glyph) const
+{
+    unsigned int value;
+
+    if (!cache->cmapCache.get(unicode, &value))
+    {
+        /*
+         * LIKE FT_Get_Char_Index(): 0 FOR THE MISSING CHARACTERS, AS WELL AS FOR THE OUT-OF-RANGE GLYPHS
+         */
+        hb_codepoint_t found;
+        value = (subtable->get_glyph(unicode, &found) && (found < glyphCount)) ? found : 0;
+
+        cache->cmapCache.set(unicode, value);
+    }
+
+    *glyph = value;
+    return value != 0;
+}
+
+hb_position_t OpenTypeTables::getHAdvance(Cache *cache, hb_codepoint_t glyph) const
+{
+    if (glyph >= glyphCount)
+    {
+        return 0; // LIKE hb-ft, WHEN FT_Get_Advance() FAILS
+    }
+
+    /*
+     * THE INITIAL ENTRIES OF hb_advance_cache_t (ALL BITS SET) WOULD BE "FOUND" FOR THE GLYPHS ABOVE 0xFF00
+     */
+    bool cacheable = (glyph < 0xff00);
+    unsigned int value;
+
+    if (cacheable && cache->advanceCache.get(glyph, &value))
+    {
+        return value;
+    }
+
+    /*
+     * THE GLYPHS BEYOND numberOfHMetrics ARE SHARING THE ADVANCE OF THE LAST ENTRY
+     */
+    FT_Long units = metrics->longHorMetric[std::min(glyph, metricCount - 1)].advanceWidth;
+
+    /*
+     * FOLLOWING FT_Get_Advance() AND hb_ft_get_glyph_h_advance(): FROM FONT-UNITS TO 16.16, THEN TO 26.6 (ROUNDED)
+     */
+    hb_position_t advance = (FT_MulDiv(units, cache->xScale, 64) + (1 << 9)) >> 10;
+
+    if (cacheable)
+    {
+        cache->advanceCache.set(glyph, advance);
+    }
+
+    return advance;
+}
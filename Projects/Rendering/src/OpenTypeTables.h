@@ -0,0 +1,97 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+/*
+ * NATIVE GLYPH-QUERIES, IN PLACE OF THE FT_Get_Char_Index() AND FT_Get_Advance() CALLS OF hb-ft (SEE LockedFontFuncs IN ActualFont.cpp)
+ *
+ * - THE cmap AND hmtx TABLES ARE READ DIRECTLY FROM THE FONT-DATA OF THE hb_face_t, I.E. WITHOUT LOCKING THE FT_Face
+ * - THE cmap SUBTABLE IS THE ONE OF THE CHARMAP SELECTED BY FontFace::load(), I.E. THE SAME GLYPHS AS FREETYPE
+ * - THE ADVANCES ARE SCALED LIKE FT_Get_Advance() WITH FT_LOAD_NO_HINTING, I.E. THE SAME FRACTIONAL POSITIONS AS FREETYPE
+ *   (INCLUDING THE 64x SCALE OF ActualFont::reload)
+ * - NOT USABLE (I.E. FREETYPE REMAINS IN USE) IF THE cmap SUBTABLE IS NOT OF FORMAT 4 OR 12, OR IF THE hmtx TABLE IS MISSING OR TRUNCATED
+ *
+ * - ONE INSTANCE PER FontFace, SHARED BY ALL ITS SIZES, AND IMMUTABLE ONCE CREATED
+ * - THE RESULTS ARE CACHED PER SIZE, IN A LOCK-FREE Cache (BASED ON hb_cmap_cache_t AND hb_advance_cache_t)
+ *
+ * FREETYPE IS STILL USED FOR EVERYTHING ELSE (E.G. GLYPH-EXTENTS, CONTOUR-POINTS AND RASTERIZATION)
+ *
+ * ALSO DETECTING (ONCE, REGARDLESS OF isUsable) IF THE SPACE-GLYPH IS TAKING PART IN A KERNING-PAIR (SEE isKerningSpace)
+ */
+
+#pragma once
+
+#include "FreetypeHelper.h"
+
+#include "hb.h"
+
+#include <memory>
+
+namespace OT
+{
+    struct CmapSubtable;
+    struct hmtx;
+}
+
+class OpenTypeTables
+{
+public:
+    /*
+     * DEFINED IN OpenTypeTables.cpp, I.E. WITHOUT EXPOSING THE PRIVATE HEADERS OF HARFBUZZ
+     */
+    struct Cache;
+
+    struct CacheDeleter
+    {
+        void operator()(Cache *cache) const;
+    };
+
+    typedef std::unique_ptr<Cache, CacheDeleter> CacheRef;
+
+    /*
+     * THE CHARMAP OF ftFace MUST BE SELECTED ALREADY
+     */
+    OpenTypeTables(hb_face_t *face, FT_Face ftFace);
+    ~OpenTypeTables();
+
+    bool isUsable() const;
+
+    /*
+     * xScale: THE x_scale OF THE FT_Size_Metrics OF THE SIZE USING THE CACHE
+     */
+    CacheRef createCache(FT_Fixed xScale) const;
+
+    /*
+     * SAME RESULTS AS hb-ft, WHICH IS IGNORING VARIATION-SELECTORS
+     * THREAD-SAFE
+     */
+    bool getGlyph(Cache *cache, hb_codepoint_t unicode, hb_codepoint_t *glyph) const;
+    hb_position_t getHAdvance(Cache *cache, hb_codepoint_t glyph) const;
+
+    bool coversSpace() const;
+
+    /*
+     * TRUE IF THE GLYPH OF U+0020 IS PART OF A KERNING-PAIR WITH A NON-ZERO VALUE, ON EITHER SIDE:
+     * IN A PairPos LOOKUP OF THE GPOS TABLE, OR IN A FORMAT 0 SUBTABLE OF THE kern TABLE (USED BY THE FALLBACK-KERNING OF HARFBUZZ)
+     *
+     * SUCH A FONT IS NOT COMPATIBLE WITH THE SPLITTING OF THE RUNS INTO WORDS (SEE WordCache)
+     */
+    bool isKerningSpace() const;
+
+protected:
+    hb_blob_t *cmapBlob;
+    hb_blob_t *hmtxBlob;
+
+    const OT::CmapSubtable *subtable; // NULL IF NOT USABLE
+    const OT::hmtx *metrics; // NULL IF NOT USABLE
+
+    unsigned int glyphCount;
+    unsigned int metricCount; // THE numberOfHMetrics OF THE hhea TABLE
+
+    hb_codepoint_t spaceGlyph; // 0 IF NOT COVERED
+    bool kerningSpace;
+};
@@ -16,7 +16,8 @@ using namespace chr;
 
 ReloadableTexture::ReloadableTexture(const GlyphData &glyphData)
 :
-textureId(0)
+textureId(0),
+lastUse(0)
 {
     load(glyphData);
 }
@@ -35,10 +36,17 @@ void ReloadableTexture::unload()
     }
 }
 
+ReloadableTexture::ReloadableTexture(int width, int height, bool useMipmap)
+:
+textureId(0),
+textureWidth(width),
+textureHeight(height),
+useMipmap(useMipmap),
+lastUse(0)
+{}
+
 void ReloadableTexture::load(const GlyphData &glyphData)
 {
-    unload();
-
     useMipmap = glyphData.useMipmap;
     int width = glyphData.width;
     int height = glyphData.height;
@@ -57,7 +65,13 @@ void ReloadableTexture::load(const GlyphData &glyphData)
         }
     }
 
-    // ---
+    upload(textureData);
+    delete[] textureData;
+}
+
+void ReloadableTexture::upload(const unsigned char *data)
+{
+    unload();
     
     glGenTextures(1, &textureId);
     glBindTexture(GL_TEXTURE_2D, textureId);
@@ -81,7 +95,7 @@ void ReloadableTexture::load(const GlyphData &glyphData)
         glHint(GL_GENERATE_MIPMAP_HINT, GL_NICEST);
     }
     
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, textureWidth, textureHeight, 0, GL_ALPHA, GL_UNSIGNED_BYTE, textureData);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, textureWidth, textureHeight, 0, GL_ALPHA, GL_UNSIGNED_BYTE, data);
     
     if (useMipmap)
     {
@@ -89,12 +103,34 @@ void ReloadableTexture::load(const GlyphData &glyphData)
     }
     
     glBindTexture(GL_TEXTURE_2D, 0);
-    delete[] textureData;
 }
 
-bool ReloadableTexture::isLoaded() const
+void ReloadableTexture::update(const unsigned char *data, int x, int y, int width, int height)
 {
-    return (textureId != 0);
+    if (textureId)
+    {
+        glBindTexture(GL_TEXTURE_2D, textureId);
+        
+        /*
+         * SUB-REGIONS ARE NOT NECESSARILY 4-BYTES ALIGNED
+         */
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        
+        if (useMipmap)
+        {
+            glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
+        }
+        
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_ALPHA, GL_UNSIGNED_BYTE, data);
+        
+        if (useMipmap)
+        {
+            glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_FALSE);
+        }
+        
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
 }
 
 size_t ReloadableTexture::getMemoryUsage() const
@@ -15,13 +15,40 @@
 class ReloadableTexture
 {
 public:
+    /*
+     * "STANDALONE" TEXTURE, HOLDING A SINGLE GLYPH
+     */
     ReloadableTexture(const GlyphData &glyphData);
+    
+    /*
+     * EMPTY TEXTURE OF A GIVEN SIZE (E.G. FOR A GlyphAtlas PAGE)
+     * NOTHING WILL BE UPLOADED UNTIL upload() IS INVOKED
+     */
+    ReloadableTexture(int width, int height, bool useMipmap);
+    
     ~ReloadableTexture();
     
     void unload();
     void load(const GlyphData &glyphData);
-    bool isLoaded() const;
     size_t getMemoryUsage() const;
+    
+    bool isLoaded() const
+    {
+        return (textureId != 0);
+    }
+    
+    /*
+     * data MUST CONTAIN (getWidth() * getHeight()) BYTES
+     */
+    void upload(const unsigned char *data);
+    
+    /*
+     * UPDATES A SUB-REGION OF AN ALREADY-LOADED TEXTURE
+     * data MUST CONTAIN (width * height) BYTES
+     *
+     * IN CASE OF MIPMAPPING: THE WHOLE MIPMAP-CHAIN WILL BE REGENERATED
+     */
+    void update(const unsigned char *data, int x, int y, int width, int height);
 
     void bind();
     GLuint getId() const;
@@ -33,4 +60,8 @@ protected:
     int textureWidth;
     int textureHeight;
     bool useMipmap;
+    
+    int lastUse; // THE LAST FRAME DURING WHICH THE TEXTURE WAS DRAWN (SEE TextureStore)
+    
+    friend class TextureStore;
 };
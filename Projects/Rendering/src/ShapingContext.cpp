@@ -0,0 +1,31 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+#include "ShapingContext.h"
+
+using namespace std;
+
+ShapingContext& ShapingContext::getDefault()
+{
+    static thread_local ShapingContext context;
+    return context;
+}
+
+ShapingContext::ShapingContext()
+{
+    bidi = ubidi_open();
+    lineBidi = ubidi_open();
+    buffer = hb_buffer_create();
+}
+
+ShapingContext::~ShapingContext()
+{
+    hb_buffer_destroy(buffer);
+    ubidi_close(lineBidi);
+    ubidi_close(bidi);
+}
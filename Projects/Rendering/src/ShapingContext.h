@@ -0,0 +1,103 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+/*
+ * THE STATE USED FOR ITEMIZING AND SHAPING A LINE (TextItemizer::processLine(), VirtualFont::createLineLayout() AND VirtualFont::measureLine()):
+ * - THE hb_buffer_t, THE UBiDi OBJECTS, THE DECODED TEXT, THE ITEMS AND THE SCRATCH-VECTORS
+ * - GROWN ON DEMAND AND NEVER FREED BETWEEN CALLS: IN STEADY STATE, NO HEAP-ALLOCATION IS PERFORMED
+ *
+ * NOT THREAD-SAFE: EACH THREAD SHOULD USE ITS OWN INSTANCE (SEE getDefault())
+ */
+
+#pragma once
+
+#include "TextItemizer.h"
+#include "WordCache.h"
+#include "ItemizationCache.h"
+
+class ShapingContext
+{
+public:
+    /*
+     * ONE INSTANCE PER THREAD, USED BY THE OVERLOADS NOT TAKING A ShapingContext
+     */
+    static ShapingContext& getDefault();
+    
+    ShapingContext();
+    ~ShapingContext();
+    
+    ShapingContext(const ShapingContext &other) = delete;
+    ShapingContext& operator=(const ShapingContext &other) = delete;
+    
+    /*
+     * ITEMIZATION
+     */
+    TextLine line; // RETURNED BY TextItemizer::processLine()
+    ItemizationCache::Key itemizationKey; // FOR LOOKUPS
+    UBiDi *bidi;
+    UBiDi *lineBidi; // ONLY USED VIA ubidi_setLine() (SEE TextItemizer::processParagraphLine()): REUSING bidi WAS RETURNING WRONG LEVELS FOR THE TRAILING WHITESPACES
+    std::vector<TextItemizer::ScriptAndLanguageItem> scriptAndLanguageItems;
+    std::vector<int32_t> safeItemEnds; // THE ENDS OF scriptAndLanguageItems WITHOUT PENDING PAIRED-CHARACTERS (SEE TextItemizer::processEditedText())
+    std::vector<TextItemizer::DirectionItem> directionItems;
+    
+    /*
+     * SIMPLE TEXT (SEE TextItemizer::processSimpleLine())
+     */
+    std::vector<uint8_t> simpleCodes; // ONE PER CHARACTER, BETWEEN U+0020 AND U+00FF
+    Language simpleLanguage;
+    
+    /*
+     * SHAPING
+     */
+    struct ClusterEntry
+    {
+        uint32_t cluster; // AS DEFINED BY HARFBUZZ, I.E. THE INDEX OF THE FIRST CODE-UNIT
+        uint32_t shapeIndex; // INDEX IN shapes
+        uint16_t shapeCount;
+        uint16_t fontIndex;
+        float combinedAdvance;
+        
+        ClusterEntry(uint32_t cluster, uint32_t shapeIndex, uint16_t fontIndex)
+        :
+        cluster(cluster),
+        shapeIndex(shapeIndex),
+        shapeCount(0),
+        fontIndex(fontIndex),
+        combinedAdvance(0)
+        {}
+        
+        bool operator<(const ClusterEntry &rhs) const
+        {
+            return cluster < rhs.cluster;
+        }
+    };
+    
+    hb_buffer_t *buffer;
+    
+    std::vector<ClusterEntry> entries;
+    std::vector<Shape> shapes;
+    std::vector<std::pair<int32_t, int32_t>> missingRanges;
+    std::vector<std::pair<int32_t, int32_t>> nextMissingRanges;
+    
+    /*
+     * ASSEMBLY
+     */
+    WordCache::Key wordKey; // FOR LOOKUPS
+    std::vector<WordCache::Word> runWords; // TWO PER RUN: THE WHOLE RUN WHEN THE WordCache IS DISABLED, OTHERWISE THE NON-CACHEABLE WORDS
+    std::vector<std::shared_ptr<WordCache::Word>> cachedWords;
+    std::vector<const WordCache::Word*> words; // IN LOGICAL ORDER
+    std::vector<std::pair<size_t, bool>> runEnds; // PER RUN: END-INDEX IN words AND "BACKWARD" DIRECTION
+    
+    std::vector<ActualFont*> fonts;
+    std::vector<uint16_t> fontIndices;
+    
+    /*
+     * MEASUREMENT
+     */
+    std::vector<ActualFont*> rangeFonts;
+};
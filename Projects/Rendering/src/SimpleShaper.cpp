@@ -0,0 +1,366 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+#include "SimpleShaper.h"
+
+#include "hb-ot.h"
+
+#include "unicode/uchar.h"
+#include "unicode/uscript.h"
+
+#include <cstring>
+
+using namespace std;
+
+static const uint8_t CLASS_SIMPLE = 1;
+static const uint8_t CLASS_LATIN = 2;
+
+/*
+ * THE CLASS OF EACH CODE BETWEEN U+0000 AND U+00FF, AS DEFINED BY ICU
+ */
+struct CharacterClasses
+{
+    uint8_t values[256];
+
+    CharacterClasses()
+    {
+        memset(values, 0, sizeof(values));
+
+        for (UChar32 c = 0x20; c < 0x100; c++)
+        {
+            UErrorCode error = U_ZERO_ERROR;
+            auto script = uscript_getScript(c, &error);
+            auto type = u_charType(c);
+            auto direction = u_charDirection(c);
+
+            bool simple = U_SUCCESS(error) && ((script == USCRIPT_LATIN) || (script == USCRIPT_COMMON));
+            simple &= (type != U_CONTROL_CHAR) && (type != U_FORMAT_CHAR);
+            simple &= (type != U_NON_SPACING_MARK) && (type != U_ENCLOSING_MARK) && (type != U_COMBINING_SPACING_MARK);
+            simple &= !u_hasBinaryProperty(c, UCHAR_DEFAULT_IGNORABLE_CODE_POINT);
+
+            switch (direction)
+            {
+                case U_LEFT_TO_RIGHT:
+                case U_EUROPEAN_NUMBER:
+                case U_EUROPEAN_NUMBER_SEPARATOR:
+                case U_EUROPEAN_NUMBER_TERMINATOR:
+                case U_COMMON_NUMBER_SEPARATOR:
+                case U_WHITE_SPACE_NEUTRAL:
+                case U_OTHER_NEUTRAL:
+                    break;
+
+                default:
+                    simple = false;
+                    break;
+            }
+
+            if (simple)
+            {
+                values[c] = CLASS_SIMPLE | ((script == USCRIPT_LATIN) ? CLASS_LATIN : 0);
+            }
+        }
+    }
+
+    static const CharacterClasses& get()
+    {
+        static CharacterClasses instance;
+        return instance;
+    }
+};
+
+/*
+ * 8 BYTES WITHOUT ANY BYTE >= 0x80, < 0x20 OR EQUAL TO 0x7F
+ *
+ * "HASLESS" AND "HASZERO" FROM: http://graphics.stanford.edu/~seander/bithacks.html#ZeroInWord
+ */
+static inline bool isPrintableASCII(uint64_t word)
+{
+    const uint64_t ONES = 0x0101010101010101ULL;
+    const uint64_t HIGHS = 0x8080808080808080ULL;
+
+    if (word & HIGHS)
+    {
+        return false;
+    }
+
+    uint64_t lower = (word - ONES * 0x20) & ~word & HIGHS;
+
+    uint64_t deletes = word ^ (ONES * 0x7f);
+    deletes = (deletes - ONES) & ~deletes & HIGHS;
+
+    return !(lower | deletes);
+}
+
+/*
+ * PREPARING buffer FOR SHAPING LATIN TEXT, THE SAME WAY AS TextRun::apply()
+ */
+static void prepareBuffer(hb_buffer_t *buffer, hb_language_t language, const vector<uint32_t> &codes)
+{
+    hb_buffer_clear_contents(buffer);
+
+    hb_buffer_set_script(buffer, HB_SCRIPT_LATIN);
+    hb_buffer_set_direction(buffer, HB_DIRECTION_LTR);
+    hb_buffer_set_language(buffer, language);
+
+    hb_buffer_add_utf32(buffer, codes.data(), codes.size(), 0, codes.size());
+}
+
+bool SimpleShaper::decode(const string &input, vector<uint8_t> &codes)
+{
+    auto &classes = CharacterClasses::get().values;
+
+    auto data = reinterpret_cast<const uint8_t*>(input.data());
+    size_t size = input.size();
+
+    codes.resize(size); // AT MOST ONE CODE PER BYTE
+    auto output = codes.data();
+
+    size_t count = 0;
+    size_t i = 0;
+    bool latin = false;
+
+    while (i < size)
+    {
+        if (i + 8 <= size)
+        {
+            uint64_t word;
+            memcpy(&word, data + i, 8);
+
+            if (isPrintableASCII(word))
+            {
+                memcpy(output + count, data + i, 8);
+
+                if (!latin)
+                {
+                    for (int j = 0; j < 8; j++)
+                    {
+                        latin |= bool(classes[data[i + j]] & CLASS_LATIN);
+                    }
+                }
+
+                count += 8;
+                i += 8;
+                continue;
+            }
+        }
+
+        uint32_t code = data[i++];
+
+        if (code >= 0x80)
+        {
+            /*
+             * TWO-BYTE SEQUENCES FOR U+0080 TO U+00FF ONLY
+             */
+            if (((code == 0xc2) || (code == 0xc3)) && (i < size) && ((data[i] & 0xc0) == 0x80))
+            {
+                code = ((code & 0x1f) << 6) | (data[i++] & 0x3f);
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        auto value = classes[code];
+
+        if (!(value & CLASS_SIMPLE))
+        {
+            return false;
+        }
+
+        latin |= bool(value & CLASS_LATIN);
+        output[count++] = code;
+    }
+
+    codes.resize(count);
+    return latin;
+}
+
+/*
+ * FOLLOWING hb_ot_map_builder_t
+ */
+uint32_t SimpleShaper::getKey(hb_face_t *face, hb_language_t language)
+{
+    hb_tag_t scriptTags[3] = {HB_TAG_NONE, HB_TAG_NONE, HB_TAG_NONE};
+    hb_ot_tags_from_script(HB_SCRIPT_LATIN, &scriptTags[0], &scriptTags[1]);
+
+    hb_tag_t languageTag = hb_ot_tag_from_language(language);
+    hb_tag_t tableTags[2] = {HB_OT_TAG_GSUB, HB_OT_TAG_GPOS};
+
+    uint32_t key = 0;
+
+    for (auto tableTag : tableTags)
+    {
+        unsigned int scriptIndex;
+        unsigned int languageIndex;
+        hb_tag_t chosenScript;
+
+        hb_ot_layout_table_choose_script(face, tableTag, scriptTags, &scriptIndex, &chosenScript);
+        hb_ot_layout_script_find_language(face, tableTag, scriptIndex, languageTag, &languageIndex);
+
+        key = (key << 16) | (languageIndex & 0xffff);
+    }
+
+    return key;
+}
+
+SimpleShaper::SimpleShaper(hb_font_t *font, hb_language_t language)
+:
+usable(false),
+codeCount(0)
+{
+    memset(glyphs, 0, sizeof(glyphs));
+    memset(advances, 0, sizeof(advances));
+    memset(indices, 0, sizeof(indices));
+
+    auto &classes = CharacterClasses::get().values;
+    auto buffer = hb_buffer_create();
+
+    /*
+     * 1) THE GLYPH AND THE (UNKERNED) ADVANCE OF EACH SIMPLE CHARACTER, SHAPED ALONE
+     */
+    vector<uint32_t> codes;
+    vector<uint32_t> sequence(1);
+
+    for (uint32_t code = 0; code < 256; code++)
+    {
+        if (classes[code] & CLASS_SIMPLE)
+        {
+            sequence[0] = code;
+            prepareBuffer(buffer, language, sequence);
+            hb_shape(font, buffer, NULL, 0);
+
+            unsigned int glyphCount;
+            auto glyphInfos = hb_buffer_get_glyph_infos(buffer, &glyphCount);
+            auto glyphPositions = hb_buffer_get_glyph_positions(buffer, NULL);
+
+            if ((glyphCount == 1) && glyphInfos[0].codepoint && !glyphPositions[0].x_offset && !glyphPositions[0].y_offset && !glyphPositions[0].y_advance)
+            {
+                glyphs[code] = glyphInfos[0].codepoint;
+                advances[code] = glyphPositions[0].x_advance;
+                indices[code] = codes.size();
+
+                codes.push_back(code);
+            }
+        }
+    }
+
+    codeCount = codes.size();
+
+    /*
+     * 2) THE GSUB-LOOKUPS SHOULD NOT BE ABLE TO PRODUCE ANY OTHER GLYPH (E.G. A LIGATURE)
+     */
+    if (codeCount > 0)
+    {
+        auto inputGlyphs = hb_set_create();
+        auto closureGlyphs = hb_set_create();
+
+        for (auto code : codes)
+        {
+            hb_set_add(inputGlyphs, glyphs[code]);
+        }
+
+        prepareBuffer(buffer, language, codes);
+        hb_ot_shape_glyphs_closure(font, buffer, NULL, 0, closureGlyphs);
+
+        usable = hb_set_is_equal(inputGlyphs, closureGlyphs);
+
+        hb_set_destroy(inputGlyphs);
+        hb_set_destroy(closureGlyphs);
+    }
+
+    /*
+     * 3) KERNING: SHAPING A SEQUENCE WHERE EACH PAIR OF CHARACTERS IS APPEARING (AT LEAST) TWICE, IN DIFFERENT CONTEXTS
+     *    I.E. "a b0 a b1 ... a bn" FOR EACH CHARACTER a
+     *
+     *    THE FONT IS NOT USABLE IF A GLYPH IS SUBSTITUTED OR OFFSET, OR IF THE SAME PAIR IS NOT ALWAYS KERNED IDENTICALLY
+     */
+    if (usable)
+    {
+        sequence.clear();
+        sequence.reserve(codeCount * codeCount * 2);
+
+        for (auto first : codes)
+        {
+            for (auto second : codes)
+            {
+                sequence.push_back(first);
+                sequence.push_back(second);
+            }
+        }
+
+        prepareBuffer(buffer, language, sequence);
+        hb_shape(font, buffer, NULL, 0);
+
+        unsigned int glyphCount;
+        auto glyphInfos = hb_buffer_get_glyph_infos(buffer, &glyphCount);
+        auto glyphPositions = hb_buffer_get_glyph_positions(buffer, NULL);
+
+        usable = (glyphCount == sequence.size());
+
+        kernings.assign(codeCount * codeCount, 0);
+        vector<bool> defined(codeCount * codeCount, false);
+
+        for (size_t i = 0; usable && (i < glyphCount); i++)
+        {
+            auto code = sequence[i];
+            auto &position = glyphPositions[i];
+
+            usable = (glyphInfos[i].codepoint == glyphs[code]) && (glyphInfos[i].cluster == i) && !position.x_offset && !position.y_offset && !position.y_advance;
+
+            if (usable)
+            {
+                hb_position_t kerning = position.x_advance - advances[code];
+
+                if (i + 1 < glyphCount)
+                {
+                    size_t index = indices[code] * codeCount + indices[sequence[i + 1]];
+
+                    if (defined[index])
+                    {
+                        usable = (kernings[index] == kerning);
+                    }
+                    else
+                    {
+                        kernings[index] = kerning;
+                        defined[index] = true;
+                    }
+                }
+                else
+                {
+                    usable = (kerning == 0);
+                }
+            }
+        }
+    }
+
+    if (!usable)
+    {
+        vector<hb_position_t>().swap(kernings);
+    }
+
+    hb_buffer_destroy(buffer);
+}
+
+bool SimpleShaper::isUsable() const
+{
+    return usable;
+}
+
+bool SimpleShaper::covers(const vector<uint8_t> &codes) const
+{
+    for (auto code : codes)
+    {
+        if (!glyphs[code])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
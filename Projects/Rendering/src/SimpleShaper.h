@@ -0,0 +1,82 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+/*
+ * FAST-PATH FOR "SIMPLE TEXT" (SEE VirtualFont::createLineLayout), BYPASSING ICU AND HARFBUZZ:
+ *
+ * - SIMPLE TEXT: LATIN-1 CHARACTERS (U+0020 TO U+00FF) WHICH ARE NEITHER CONTROLS, MARKS, DEFAULT-IGNORABLES NOR RTL,
+ *   WITH AT LEAST ONE LATIN LETTER, I.E. WHAT TextItemizer::processLine() WOULD TURN INTO A SINGLE LTR LATIN RUN
+ *
+ * - FOR A GIVEN FONT: THE GLYPH, THE ADVANCE AND THE KERNING (WITH EACH FOLLOWING CHARACTER) OF EACH SIMPLE CHARACTER
+ *   ARE PRECOMPUTED BY SHAPING WITH HARFBUZZ, SO THAT THE RESULTING LineLayout IS IDENTICAL TO THE ONE OF THE REGULAR PATH
+ *
+ * - A FONT IS NOT USABLE (I.E. isUsable() IS FALSE) IF ITS GSUB-LOOKUPS CAN AFFECT SIMPLE TEXT (E.G. LIGATURES),
+ *   OR IF ITS POSITIONING CAN'T BE EXPRESSED AS "PAIR-KERNING APPLIED TO THE ADVANCE OF THE FIRST GLYPH"
+ *   (E.G. GLYPH-OFFSETS, CONTEXTUAL KERNING, OR THE "FALLBACK" KERNING OF FONTS WITHOUT GPOS TABLE)
+ *
+ * - IMMUTABLE ONCE CREATED, I.E. THREAD-SAFE (SEE ActualFont::getSimpleShaper)
+ */
+
+#pragma once
+
+#include "hb.h"
+
+#include <string>
+#include <vector>
+
+class SimpleShaper
+{
+public:
+    /*
+     * DECODING THE UTF-8 input INTO codes (ONE PER CHARACTER)
+     * RETURNS FALSE UNLESS input IS SIMPLE TEXT (THE CONTENT OF codes IS THEN UNDEFINED)
+     *
+     * PRINTABLE-ASCII IS PROCESSED 8 BYTES AT A TIME
+     */
+    static bool decode(const std::string &input, std::vector<uint8_t> &codes);
+
+    /*
+     * THE LANGUAGE-SYSTEMS (OF THE GSUB AND GPOS TABLES) SELECTED BY HARFBUZZ FOR SHAPING LATIN TEXT IN language:
+     * LANGUAGES SHARING THE SAME KEY ARE SHAPED IDENTICALLY, I.E. THEY CAN SHARE THE SAME SimpleShaper
+     */
+    static uint32_t getKey(hb_face_t *face, hb_language_t language);
+
+    SimpleShaper(hb_font_t *font, hb_language_t language);
+
+    bool isUsable() const;
+    bool covers(const std::vector<uint8_t> &codes) const;
+
+    inline hb_codepoint_t getGlyph(uint8_t code) const
+    {
+        return glyphs[code];
+    }
+
+    /*
+     * THE ADVANCE OF code, KERNED WITH nextCode (0: NO KERNING, E.G. AT THE END OF A WORD)
+     * BOTH CODES MUST BE COVERED
+     */
+    inline hb_position_t getAdvance(uint8_t code, uint8_t nextCode) const
+    {
+        if (nextCode)
+        {
+            return advances[code] + kernings[indices[code] * codeCount + indices[nextCode]];
+        }
+
+        return advances[code];
+    }
+
+protected:
+    bool usable;
+
+    hb_codepoint_t glyphs[256]; // 0 FOR THE CODES NOT COVERED
+    hb_position_t advances[256];
+    uint8_t indices[256]; // INDEX OF EACH COVERED CODE, FOR ADDRESSING kernings
+
+    int codeCount; // THE NUMBER OF COVERED CODES
+    std::vector<hb_position_t> kernings; // codeCount * codeCount
+};
@@ -7,6 +7,7 @@
  */
 
 #include "Sketch.h"
+#include "Measurement.h"
 
 #include "chronotext/InputSource.h"
 #include "chronotext/utils/Utils.h"
@@ -23,6 +24,8 @@ const float LINE_SPACING = 66;
 const int LINE_COUNT = 11;
 const int MAX_SENTENCES_PER_LINE = 3;
 
+const int GLYPH_UPLOADS_PER_FRAME = 32;
+
 Sketch::Sketch(void *context, void *delegate)
 :
 CinderSketch(context, delegate)
@@ -60,6 +63,35 @@ void Sketch::setup(bool renewContext)
         
         shuffleLines();
         
+//      Measurement::drawing(*fontManager.getCachedFont("sans-serif"), lines);
+//      Measurement::glyphLookup(*fontManager.getCachedFont("sans-serif"), lines);
+        
+//      Measurement::diskCaching(getDocumentsDirectory() / "GlyphDiskCache", lines);
+        
+//      Measurement::fontMemory(fontManager);
+//      Measurement::fontIndexing(getDocumentsDirectory() / "FontIndex.bin", lines);
+        
+//      Measurement::wordCaching(fontManager, *fontManager.getCachedFont("sans-serif"), sentences);
+//      Measurement::fallbackShaping(fontManager, *fontManager.getCachedFont("sans-serif"), sentences);
+//      Measurement::layoutCreation(fontManager, *fontManager.getCachedFont("sans-serif"), sentences);
+//      Measurement::shapingAllocations(fontManager, *fontManager.getCachedFont("sans-serif"), sentences);
+//      Measurement::parallelLayout(fontManager, *fontManager.getCachedFont("sans-serif"), sentences);
+//      Measurement::lineMeasuring(fontManager, *fontManager.getCachedFont("sans-serif"), sentences);
+//      Measurement::simpleText(fontManager, *fontManager.getCachedFont("sans-serif"), sentences);
+//      Measurement::nativeFontFuncs(fontManager, *fontManager.getCachedFont("sans-serif"), sentences);
+//      Measurement::featureShaping(fontManager, *fontManager.getCachedFont("sans-serif"), sentences);
+//      Measurement::incrementalLayout(fontManager, *fontManager.getCachedFont("sans-serif"), sentences);
+//      Measurement::runMerging(fontManager, sentences);
+//      Measurement::shortLines(fontManager, *fontManager.getCachedFont("sans-serif"), sentences);
+//      Measurement::languageDetection(fontManager, sentences);
+//      Measurement::paragraphWrapping(fontManager);
+//      Measurement::itemizationCaching(fontManager, { fontManager.getCachedFont("sans-serif", VirtualFont::STYLE_REGULAR, 16), fontManager.getCachedFont("sans-serif", VirtualFont::STYLE_REGULAR, 24), fontManager.getCachedFont("sans-serif", VirtualFont::STYLE_BOLD, 24) }, sentences);
+        
+        fontManager.enableAsyncRasterization();
+//      Measurement::rasterization(fontManager, *fontManager.getCachedFont("sans-serif"));
+        
+        // ---
+        
         fontSize = 27;
         align = VirtualFont::ALIGN_BASELINE;
         oscillate = true; // TOGGLE BY PRESSING SPACE ON THE DESKTOP
@@ -84,6 +116,9 @@ void Sketch::draw()
 {
     gl::clear(Color::gray(0.5f), false);
     
+    fontManager.beginFrame();
+    fontManager.uploadGlyphs(GLYPH_UPLOADS_PER_FRAME);
+    
     Vec2i windowSize = getWindowSize();
     gl::setMatricesWindow(windowSize, true);
     
@@ -127,7 +162,7 @@ void Sketch::drawTextLine(VirtualFont &font, const string &text, float y, float
 
     for (auto &cluster : layout->clusters)
     {
-        font.drawCluster(cluster, position);
+        font.drawCluster(*layout, cluster, position);
         position.x += font.getAdvance(cluster);
     }
 }
@@ -93,6 +93,146 @@
  *     - ALIASES DEFINED IN FontConfig/Aliases, E.G.
  *       - "Arial" FOR "sans-serif"
  *       - "Times" FOR "serif"
+ *
+ * 15) TEXTURE-ATLASES:
+ *     - GlyphAtlas: N FIXED-SIZE "ALPHA" PAGES PER ActualFont, FILLED VIA "SHELF PACKING"
+ *     - GLYPHS CAN BE ADDED ON-THE-FLY, EVEN WITH MIPMAPPING:
+ *       THE PAGES ARE KEPT IN MEMORY AND THE MIPMAP-CHAIN IS REGENERATED UPON EACH ADDITION
+ *     - STANDALONE-TEXTURES ARE STILL USED FOR GLYPHS WHICH CAN'T FIT IN THE ATLAS
+ *     - FontManager::getTextureOccupancy()
+ *
+ * 16) BATCHED GLYPH RENDERING:
+ *     - VirtualFont::begin() NOW ACCEPTS A MODE:
+ *       - MODE_TEXTURE_BUCKET (DEFAULT): QUADS ARE ACCUMULATED PER TEXTURE (INTERLEAVED POSITIONS,
+ *         TEXTURE-COORDS AND COLORS) AND DRAWN UPON end() VIA glDrawElements, ONE DRAW-CALL PER TEXTURE
+ *       - MODE_DIRECT: ONE DRAW-CALL PER GLYPH, FOR DEBUGGING
+ *     - Measurement::drawing() FOR COMPARING THE TWO MODES
+ *
+ * 17) ASYNCHRONOUS GLYPH RASTERIZATION:
+ *     - FontManager::enableAsyncRasterization(): GLYPHS ARE RASTERIZED BY A POOL OF WORKER-THREADS (GlyphRasterizer)
+ *       - THE FT_Face OF EACH ActualFont IS SHARED, PROTECTED BY A MUTEX (ALSO LOCKED DURING SHAPING)
+ *       - PENDING GLYPHS ARE SKIPPED WHEN DRAWN
+ *     - FontManager::uploadGlyphs(): UPLOADING THE FINISHED GLYPHS, WITHIN A PER-FRAME BUDGET
+ *     - Measurement::rasterization() FOR CHECKING THAT A FLOOD OF REQUESTS IS EVENTUALLY RESOLVED
+ *
+ * 18) DISTANCE-FIELD GLYPHS:
+ *     - ENABLED VIA <VirtualFont distance-field="true"> IN THE FONT'S XML-DEFINITION
+ *     - COMPUTED ON THE CPU FROM THE FREETYPE BITMAP (DistanceField), AT HALF THE RESOLUTION OF baseSize
+ *     - NO MIPMAPS: A SINGLE TEXTURE IS SERVING ALL THE SIZES
+ *     - RENDERED VIA ALPHA-TESTING (THE ONLY OPTION WITH THE FIXED-FUNCTION PIPELINE)
+ *
+ * 19) PERSISTENT GLYPH CACHE:
+ *     - FontManager::enableDiskCache(): ONE MEMORY-MAPPED FILE PER ActualFont (GlyphDiskCache)
+ *     - VERSIONED, SIGNED (FONT CHECKSUM, RASTERIZATION PARAMETERS), SIZE-CAPPED AND CHECKSUMMED PER RECORD
+ *     - Measurement::diskCaching() FOR COMPARING "COLD" AND "WARM" TIME-TO-FIRST-FRAME
+ *
+ * 20) GLOBAL TEXTURE STORE:
+ *     - FontManager::textureStore: BYTE-BUDGET ACROSS ALL THE ActualFont INSTANCES
+ *     - LEAST-RECENTLY-DRAWN ATLAS-PAGES AND STANDALONE-TEXTURES ARE DISCARDED IN FontManager::beginFrame()
+ *     - HIT, MISS AND EVICTION COUNTERS
+ *
+ * 21) PAGED GLYPH TABLE:
+ *     - ActualFont IS STORING ITS GLYPHS IN PAGES OF 256 CONTIGUOUS RECORDS, INDEXED BY GLYPH-ID
+ *     - INLINE FAST-PATH FOR getGlyph(), WITHOUT reload() OR TEXTURE-RELOADING
+ *     - Measurement::glyphLookup(): ~4 NS PER LOOKUP, VERSUS ~15 NS WITH THE FORMER std::map
+ *
+ * 22) SHARED FONT-FACES:
+ *     - ONE FT_Face AND ONE hb_face_t PER (URI, FACE-INDEX), SHARED BY ALL THE SIZES (FontFace)
+ *     - EACH ActualFont IS USING ITS OWN FT_Size AND hb_font_t ON TOP OF IT
+ *     - REFERENCE-COUNTED: THE FONT-FILE IS CLOSED WHEN ITS LAST SIZE IS UNLOADED
+ *
+ * 23) MEMORY-MAPPED FONT-DATA:
+ *     - FONT-FILES ARE MAPPED READ-ONLY AND SHARED WITHOUT COPY BY FREETYPE AND HARFBUZZ (VIA AN hb_blob_t)
+ *     - COPYING TO THE HEAP ONLY AS A FALLBACK (E.G. ANDROID ASSETS)
+ *     - Measurement::fontMemory(): RESIDENT VS MAPPED BYTES PER FONT
+ *
+ * 24) FONT-INDEX:
+ *     - FontManager::enableFontIndex(): PERSISTED METADATA PER FONT-FILE (FontIndex):
+ *       USABILITY, UNSCALED METRICS AND CODEPOINT COVERAGE
+ *     - ANSWERING THE QUESTIONS MENTIONED IN 13) WITHOUT LOADING: THE ActualFont INSTANCES OF A NEW VirtualFont
+ *       ARE LOADED ONLY WHEN SOME TEXT-RUN IS COVERED BY THEM
+ *     - Measurement::fontIndexing() FOR COMPARING THE COLD-START WITHOUT AND WITH A FontIndex
+ *
+ * 25) WORD-CACHE:
+ *     - SECOND-LEVEL CACHE UNDERNEATH LayoutCache (WordCache): TEXT-RUNS ARE SPLIT AFTER SPACES
+ *       AND THE RESULTING "WORDS" ARE SHAPED ONLY ONCE PER FONT-SET, SCRIPT, LANGUAGE AND DIRECTION
+ *     - THE RUNS ARE NOT SPLIT WHEN THEIR SPACES ARE KERNED BY THE FONT (OpenTypeTables::isKerningSpace())
+ *     - Measurement::wordCaching(): TIMINGS, HIT-RATE AND COMPARISON WITH WHOLE-RUN SHAPING
+ *
+ * 26) PARTIAL FALLBACK-SHAPING:
+ *     - A FALLBACK-FONT IS ONLY SHAPING THE RANGES OF CLUSTERS LEFT UNRESOLVED BY THE PREVIOUS FONTS (WITH CONTEXT)
+ *     - Measurement::fallbackShaping(): hb_shape() CALLS AND SHAPED CODE-UNITS PER LINE
+ *
+ * 27) FLAT LINE-LAYOUTS:
+ *     - ONE CONTIGUOUS ARRAY OF SHAPES PER LineLayout, CLUSTERS REFERRING TO THEIR SHAPES AND FONT VIA INDICES
+ *     - LINEAR-TIME CLUSTER ASSEMBLY (NO MORE std::map), USING PER-THREAD SCRATCH-STORAGE
+ *     - Measurement::layoutCreation(): ALLOCATIONS PER LINE (AllocationCounter, WITH MEASURE_ALLOCATIONS DEFINED), NS PER GLYPH, BYTES PER LAYOUT
+ *
+ * 28) SHAPING-CONTEXT:
+ *     - THE hb_buffer_t, UBiDi, DECODED TEXT, ITEMS AND SCRATCH-VECTORS ARE OWNED BY A ShapingContext
+ *       (EXPLICIT, OR ONE PER THREAD BY DEFAULT) AND REUSED ACROSS LINES
+ *     - Measurement::shapingAllocations(): NO HEAP-ALLOCATION PER LINE, APART FROM THE RESULTING LineLayout
+ *
+ * 29) PARALLEL LAYOUT:
+ *     - VirtualFont::createLineLayouts(): A BATCH OF LINES SHAPED ON THE WORK-STEALING WorkerPool OF FontManager
+ *     - HARFBUZZ IS NOT COMPILED WITH HB_NO_MT ANYMORE: THE hb_face_t INSTANCES ARE SHARED BY THE WORKERS
+ *     - THE FT_Face IS ONLY LOCKED DURING THE GLYPH-QUERIES OF hb_shape(), AND NOT DURING THE WHOLE SHAPING
+ *     - THREAD-SAFE ActualFont::reload(), FontFace::acquire() AND WordCache
+ *     - Measurement::parallelLayout(): SCALING FROM 1 TO 8 THREADS, AND COMPARISON WITH SINGLE-THREADED RESULTS
+ *
+ * 30) WIDTH-ONLY MEASUREMENT:
+ *     - VirtualFont::measureLine(): ADVANCE AND VERTICAL METRICS OF A LINE, WITHOUT CREATING ITS CLUSTERS AND SHAPES
+ *     - SAME ITEMIZATION, WORD-SPLITTING AND FALLBACK-LOGIC AS createLineLayout(), CACHED PER VirtualFont (WidthCache)
+ *     - Measurement::lineMeasuring(): COST RATIO VS createLineLayout()
+ *
+ * 31) SIMPLE-TEXT FAST-PATH:
+ *     - LATIN-1 LINES WITHOUT MARKS OR RTL CHARACTERS ARE LAID-OUT WITHOUT ICU NOR HARFBUZZ (TextItemizer::processSimpleLine)
+ *     - PER ActualFont: GLYPHS, ADVANCES AND PAIR-KERNINGS PRECOMPUTED VIA HARFBUZZ (SimpleShaper), UNLESS GSUB OR GPOS CAN'T BE REPRODUCED
+ *     - FIXED: OUT-OF-BOUNDS WRITE IN ScriptRun WHEN A CLOSING BRACKET IS PRECEDING THE FIRST LETTER
+ *     - Measurement::simpleText(): BIT-IDENTICAL TO THE REGULAR PATH, AND LINES PER SECOND FOR BOTH PATHS
+ *
+ * 32) NATIVE GLYPH-QUERIES:
+ *     - THE GLYPH-LOOKUPS AND HORIZONTAL ADVANCES OF hb_shape() ARE READ FROM THE cmap AND hmtx TABLES (OpenTypeTables), WITHOUT LOCKING THE FT_Face
+ *     - SAME RESULTS AS FT_Get_Char_Index() AND FT_Get_Advance(), INCLUDING THE 64x FRACTIONAL SCALE
+ *     - LOCK-FREE CACHES PER ActualFont, BASED ON hb_cmap_cache_t AND hb_advance_cache_t (NOW ATOMIC)
+ *     - Measurement::nativeFontFuncs(): EXHAUSTIVE COMPARISON WITH FREETYPE, AND LINES PER SECOND FOR BOTH
+ *
+ * 33) OPENTYPE-FEATURES:
+ *     - FeatureList (E.G. "kern=0,-liga,tnum"): OPTIONAL ARGUMENT OF createLineLayout(), createLineLayouts(), measureLine() AND getCachedLineLayout()
+ *     - PART OF THE KEYS OF LayoutCache, WordCache AND WidthCache (THE SIMPLE-TEXT FAST-PATH IS ONLY TAKEN WITHOUT FEATURES)
+ *     - HARFBUZZ: THE SHAPE-PLANS WITH USER-FEATURES ARE NOW CACHED, IN A BOUNDED AND LOCK-FREE HASH-TABLE PER hb_face_t
+ *     - Measurement::featureShaping(): LINES PER SECOND WITH AND WITHOUT FEATURES
+ *
+ * 34) INCREMENTAL RE-LAYOUT:
+ *     - VirtualFont::createEditableLineLayout() AND VirtualFont::editLineLayout(): A LineLayout KEEPING ITS LineSource, WHICH CAN BE EDITED
+ *     - ONLY THE SCRIPT-ITEMS AND THE WORDS (OR THE RUNS, WITHOUT THE WordCache) AFFECTED BY AN EDIT ARE PROCESSED AGAIN
+ *     - THE BIDI RESOLUTION REMAINS DONE FOR THE WHOLE LINE
+ *     - Measurement::incrementalLayout(): EQUALITY WITH THE FULL LAYOUT AFTER RANDOM EDITS, AND LATENCY PER KEYSTROKE ON A 2KB LINE
+ *
+ * 35) LINEAR RUN-MERGING:
+ *     - TextItemizer::mergeItems(): BINARY-SEARCH OF THE FIRST SCRIPT-ITEM OF EACH DIRECTION-ITEM, AND RTL RUNS REVERSED AS A BLOCK
+ *     - Measurement::runMerging(): EQUIVALENCE WITH THE PREVIOUS IMPLEMENTATION, AND SCALING FROM 100 TO 100K CHARACTERS
+ *
+ * 36) INTERNED LANGUAGES:
+ *     - Language: AN ATOM BACKED BY hb_language_t, IN PLACE OF std::string FOR THE LANGUAGES AND THE LANG-HINTS
+ *       (TextRun, TextLine, LineLayout, LangHelper, THE FONT-SETS OF VirtualFont, AND THE KEYS OF LayoutCache, WordCache AND WidthCache)
+ *     - THE STRINGS ARE STILL ACCEPTED BY THE API (IMPLICIT CONVERSION), BUT A Language CAN BE CREATED ONCE AND REUSED
+ *     - Measurement::shortLines(): LINES PER SECOND FOR processLine() AND createLineLayout() ON SHORT LINES
+ *
+ * 37) CONSTANT LANGUAGE-TABLES:
+ *     - LangHelper: THE TABLES OF SCRIPTS-PER-LANGUAGE AND SAMPLE-LANGUAGES ARE NOW constexpr (NOTHING IS INTERNED OR COPIED UPON CONSTRUCTION)
+ *     - LANGUAGES ARE LOOKED-UP VIA A PER-PROCESS HASH-TABLE, AND THE LANGUAGE OF EACH SCRIPT IS RESOLVED IN ADVANCE BY setDefaultLanguages()
+ *     - Measurement::languageDetection(): CONSTRUCTION-TIME AND COST OF detectLanguage(), WITH AND WITHOUT LANG-HINT
+ *
+ * 38) PARAGRAPHS:
+ *     - TextParagraph: ITEMIZED ONCE VIA TextItemizer::processParagraph() (SCRIPT-ITEMS AND PARAGRAPH-LEVEL BIDI)
+ *     - TextItemizer::processParagraphLine(): THE TextLine OF ANY RANGE (E.G. A WRAPPED LINE), REORDERED VIA ubidi_setLine(), WITHOUT LOSING THE BIDI-CONTEXT
+ *     - Measurement::paragraphWrapping(): CHECKING THE LINES OF THE RISHIDA EXAMPLES, AND RE-WRAPPING A 5K PARAGRAPH AT MANY WIDTHS
+ *
+ * 39) ITEMIZATION-CACHE:
+ *     - ItemizationCache: ITEMIZED LINES, SHARED BY ALL THE VirtualFont INSTANCES OF A FontManager (THREAD-SAFE LRU, WITH MEMORY-USAGE AND HIT/MISS COUNTERS)
+ *     - USED BY VirtualFont::createLineLayout() AND VirtualFont::measureLine(): THE SAME LINE IN DIFFERENT STYLES OR SIZES IS ITEMIZED ONCE
+ *     - Measurement::itemizationCaching(): A UI-SCREEN LAID-OUT WITH THREE FONTS, WITHOUT AND WITH THE ItemizationCache
  */
 
 /*
@@ -102,7 +242,7 @@
  * - PRESS T, M OR P TO SWITCH BETWEEN TOP, MIDDLE OR BOTTOM ALIGNMENTS
  * - PRESS U TO CALL FontManager::unload()
  * - PRESS K TO CALL FontManager::unload("sans-serif")
- * - PRESS X TO PRINT TEXTURE MEMORY USAGE
+ * - PRESS X TO PRINT TEXTURE MEMORY USAGE, OCCUPANCY AND TextureStore COUNTERS
  */
 
 /*
@@ -113,26 +253,13 @@
  *    - FIND-OUT HOW TO COPY FROM ASSETS TO "INTERNAL FOLDER" ON ANDROID
  *
  * 0) ADVANCED GLYPH RENDERING:
- *    - BATCHING ("TEXTURE BUCKET"):
- *      - USING A MAP, WITH AN ENTRY FOR EACH TEXTURE:
- *        - EACH ENTRY CONTAINING A VECTOR OF FLOATS FILLED-WITH:
- *          - INDICES
- *          - INTERLEAVED POSITIONS, TEXTURE-COORDS AND COLORS
  *    - TRANSFORMING VERTICES VIA FontMatrix LIKE IN XFont
- *    - "BEGIN / END" MODES:
- *      - "DIRECT"
- *      - "TEXTURE BUCKET"
  *
  * 0) TEXTURE-ATLASES:
- *    - SIMILAR TO THE SYSTEM USED IN XFont, BUT WITH N TEXTURES
- *    - WE NEED A SYSTEM FOR USERS TO DEFINE WHICH GLYPHS ARE CACHED
- *      - BECAUSE OF MIPMAPPING, WE CAN'T ADD GLYPHS ON-THE-FLY
- *      - THERE SHOULD BE A WAY TO ADD/REMOVE GROUPS OF GLYPHS, E.G. PER LANGUAGE
- *
- * 0) FontManager:
- *    - WE NEED A KIND OF "GLOBAL TEXTURE STORE" FOR STANDALONE-TEXTURES AND ATLASES:
- *      - LRU STRATEGY FOR STANDALONE-TEXTURES?
- *      - AUTOMATIC REMOVAL OF STANDALONE-TEXTURE WHENEVER AN ATLAS IS STORING THE ASSOCIATED GLYPH'S TEXTURE
+ *    - THERE SHOULD BE A WAY TO ADD/REMOVE GROUPS OF GLYPHS, E.G. PER LANGUAGE
+ *
+ * 0) TextureStore:
+ *    - AUTOMATIC REMOVAL OF STANDALONE-TEXTURE WHENEVER AN ATLAS IS STORING THE ASSOCIATED GLYPH'S TEXTURE
  */
 
 #pragma once
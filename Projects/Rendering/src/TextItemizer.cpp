@@ -17,6 +17,9 @@
  */
 
 #include "TextItemizer.h"
+#include "ShapingContext.h"
+#include "TextParagraph.h"
+#include "SimpleShaper.h"
 
 #include "scrptrun.h"
 
@@ -42,17 +45,109 @@ TextItemizer::TextItemizer(LangHelper &langHelper)
 langHelper(langHelper)
 {}
 
-TextLine TextItemizer::processLine(const string &input, const string &langHint, hb_direction_t overallDirection)
+TextLine TextItemizer::processLine(const string &input, const Language &langHint, hb_direction_t overallDirection, const FeatureList &features)
 {
-    TextLine line(input, langHint, overallDirection);
+    TextLine line;
+    line.assign(processLine(ShapingContext::getDefault(), input, langHint, overallDirection, features)); // NOT SHARING THE BUFFER OF context.line
+    
+    return line;
+}
+
+const TextLine& TextItemizer::processLine(ShapingContext &context, const string &input, const Language &langHint, hb_direction_t overallDirection, const FeatureList &features)
+{
+    context.line.reset(input, langHint, overallDirection, features);
+    return itemizeLine(context, langHint, overallDirection);
+}
+
+const TextLine& TextItemizer::processText(ShapingContext &context, const UnicodeString &text, const Language &langHint, hb_direction_t overallDirection, const FeatureList &features)
+{
+    resetLine(context, text, langHint, overallDirection, features);
+    return itemizeLine(context, langHint, overallDirection);
+}
 
-    vector<ScriptAndLanguageItem> scriptAndLanguageItems;
-    itemizeScriptAndLanguage(line.text, langHint, scriptAndLanguageItems);
+const TextLine& TextItemizer::processEditedText(ShapingContext &context, const UnicodeString &text, const Language &langHint, hb_direction_t overallDirection, const FeatureList &features, const vector<ScriptAndLanguageItem> &previousItems, const vector<int32_t> &previousSafeEnds, int32_t editStart, int32_t editEnd, int32_t editDelta)
+{
+    resetLine(context, text, langHint, overallDirection, features);
+    
+    auto &items = context.scriptAndLanguageItems;
+    auto &safeEnds = context.safeItemEnds;
     
-    vector<DirectionItem> directionItems;
-    itemizeDirection(line.text, overallDirection, directionItems);
+    items.clear();
+    safeEnds.clear();
+    
+    /*
+     * RESTARTING FROM THE LAST SAFE-END NOT AFFECTED BY THE EDIT
+     * (THE END OF A RUN IS DEPENDING ON THE 2 CODE-UNITS FOLLOWING IT, IN CASE OF SURROGATE-PAIR)
+     */
+    auto restart = upper_bound(previousSafeEnds.begin(), previousSafeEnds.end(), editStart - 2);
+    int32_t start = (restart == previousSafeEnds.begin()) ? 0 : *(restart - 1);
     
-    mergeItems(scriptAndLanguageItems, directionItems, line.runs);
+    safeEnds.assign(previousSafeEnds.begin(), restart);
+    
+    for (auto &item : previousItems)
+    {
+        if (item.end > start)
+        {
+            break;
+        }
+        
+        items.push_back(item);
+    }
+    
+    /*
+     * RESYNCHRONIZING AT THE FIRST SAFE-END FOLLOWING THE EDIT WHICH WAS ALSO A SAFE-END OF THE PREVIOUS TEXT:
+     * THE REMAINING ITEMS ARE THE PREVIOUS ONES, SHIFTED
+     */
+    int32_t stop = itemizeScriptAndLanguage(context.line.text, start, langHint, items, safeEnds, &previousSafeEnds, editEnd, editDelta);
+    
+    if (stop < context.line.text.length())
+    {
+        for (auto it = findItem(previousItems, stop - editDelta); it != previousItems.end(); ++it)
+        {
+            items.emplace_back(it->start + editDelta, it->end + editDelta, it->data);
+        }
+        
+        for (auto it = upper_bound(previousSafeEnds.begin(), previousSafeEnds.end(), stop - editDelta); it != previousSafeEnds.end(); ++it)
+        {
+            safeEnds.push_back(*it + editDelta);
+        }
+    }
+    
+    return resolveRuns(context, langHint, overallDirection);
+}
+
+uint32_t TextItemizer::getLanguageGeneration() const
+{
+    return langHelper.getGeneration();
+}
+
+void TextItemizer::resetLine(ShapingContext &context, const UnicodeString &text, const Language &langHint, hb_direction_t overallDirection, const FeatureList &features)
+{
+    auto &line = context.line;
+    line.text.setTo(text.getBuffer(), text.length()); // COPYING INTO THE MEMORY ALREADY ALLOCATED, IF ENOUGH (ASSIGNING WOULD SHARE THE BUFFER OF text)
+    line.langHint = langHint;
+    line.overallDirection = overallDirection;
+    line.features = features;
+    line.runs.clear();
+}
+
+const TextLine& TextItemizer::itemizeLine(ShapingContext &context, const Language &langHint, hb_direction_t overallDirection)
+{
+    context.scriptAndLanguageItems.clear();
+    context.safeItemEnds.clear();
+    itemizeScriptAndLanguage(context.line.text, 0, langHint, context.scriptAndLanguageItems, context.safeItemEnds);
+    
+    return resolveRuns(context, langHint, overallDirection);
+}
+
+const TextLine& TextItemizer::resolveRuns(ShapingContext &context, const Language &langHint, hb_direction_t overallDirection)
+{
+    auto &line = context.line;
+    
+    context.directionItems.clear();
+    itemizeDirection(line.text, overallDirection, context.bidi, context.directionItems);
+    
+    mergeItems(context.scriptAndLanguageItems, context.directionItems, line.runs);
     
     if (!line.runs.empty())
     {
@@ -70,9 +165,100 @@ TextLine TextItemizer::processLine(const string &input, const string &langHint,
     return line;
 }
 
-void TextItemizer::itemizeScriptAndLanguage(const UnicodeString &text, const string &langHint, vector<ScriptAndLanguageItem> &items)
+bool TextItemizer::processSimpleLine(ShapingContext &context, const string &input, const Language &langHint, hb_direction_t overallDirection)
+{
+    /*
+     * SIMPLE TEXT IS ONLY MADE OF LTR OR NEUTRAL CHARACTERS, WITH AT LEAST ONE (STRONG LTR) LATIN LETTER:
+     * THE WHOLE LINE IS LTR, UNLESS AN OVERALL RTL DIRECTION IS FORCED
+     *
+     * THE COMMON CHARACTERS (SPACES, DIGITS, PUNCTUATION, ETC.) ARE MERGED BY ScriptRun INTO THE LATIN RUN
+     */
+    if (((overallDirection == HB_DIRECTION_INVALID) || (overallDirection == HB_DIRECTION_LTR)) && SimpleShaper::decode(input, context.simpleCodes))
+    {
+        context.simpleLanguage = langHelper.detectLanguage(HB_SCRIPT_LATIN, langHint);
+        return true;
+    }
+    
+    return false;
+}
+
+void TextItemizer::processParagraph(TextParagraph &paragraph, const UnicodeString &text, const Language &langHint, hb_direction_t overallDirection, const FeatureList &features)
+{
+    paragraph.text = text;
+    paragraph.langHint = langHint;
+    paragraph.features = features;
+    
+    paragraph.scriptAndLanguageItems.clear();
+    paragraph.safeItemEnds.clear();
+    itemizeScriptAndLanguage(paragraph.text, 0, langHint, paragraph.scriptAndLanguageItems, paragraph.safeItemEnds);
+    
+    setParagraph(paragraph.text, overallDirection, paragraph.bidi);
+    
+    if (overallDirection == HB_DIRECTION_INVALID)
+    {
+        overallDirection = (ubidi_getParaLevel(paragraph.bidi) & 1) ? HB_DIRECTION_RTL : HB_DIRECTION_LTR;
+    }
+    
+    paragraph.overallDirection = overallDirection;
+}
+
+const TextLine& TextItemizer::processParagraphLine(ShapingContext &context, const TextParagraph &paragraph, int32_t start, int32_t end)
+{
+    if ((start < 0) || (end < start) || (end > paragraph.text.length()))
+    {
+        throw invalid_argument("INVALID PARAGRAPH-LINE: [" + to_string(start) + ", " + to_string(end) + ")");
+    }
+    
+    auto &line = context.line;
+    line.text.setTo(paragraph.text, start, end - start); // REUSING THE MEMORY ALREADY ALLOCATED, IF ENOUGH
+    line.langHint = paragraph.langHint;
+    line.overallDirection = paragraph.overallDirection;
+    line.features = paragraph.features;
+    line.runs.clear();
+    
+    context.scriptAndLanguageItems.clear();
+    context.directionItems.clear();
+    
+    if (start < end)
+    {
+        /*
+         * THE LINE-OBJECT IS ONLY VALID AS LONG AS paragraph IS NOT RE-PROCESSED
+         */
+        UErrorCode error = U_ZERO_ERROR;
+        ubidi_setLine(paragraph.bidi, start, end, context.lineBidi, &error);
+        
+        if (U_FAILURE(error))
+        {
+            throw invalid_argument("INVALID PARAGRAPH-LINE: [" + to_string(start) + ", " + to_string(end) + ") | " + u_errorName(error));
+        }
+        
+        addDirectionItems(context.lineBidi, end - start, context.directionItems, true);
+        
+        for (auto it = findItem(paragraph.scriptAndLanguageItems, start); (it != paragraph.scriptAndLanguageItems.end()) && (it->start < end); ++it)
+        {
+            context.scriptAndLanguageItems.emplace_back(std::max(it->start, start) - start, std::min(it->end, end) - start, it->data);
+        }
+        
+        mergeItems(context.scriptAndLanguageItems, context.directionItems, line.runs);
+        
+        if (paragraph.langHint.empty())
+        {
+            line.langHint = line.runs[0].language;
+        }
+    }
+    
+    return line;
+}
+
+/*
+ * STARTING AT start: 0, OR A SAFE-END (I.E. WITHOUT PENDING PAIRED-CHARACTERS, WHICH WOULD AFFECT THE SCRIPT OF THE FOLLOWING RUNS)
+ *
+ * RETURNS THE POSITION WHERE THE ITEMIZATION STOPPED: THE END OF text, OR (IF resyncEnds IS DEFINED)
+ * THE FIRST SAFE-END AFTER resyncStart WHICH IS ALSO IN resyncEnds, ONCE SHIFTED BY resyncDelta
+ */
+int32_t TextItemizer::itemizeScriptAndLanguage(const UnicodeString &text, int32_t start, const Language &langHint, vector<ScriptAndLanguageItem> &items, vector<int32_t> &safeEnds, const vector<int32_t> *resyncEnds, int32_t resyncStart, int32_t resyncDelta)
 {
-    ScriptRun scriptRun(text.getBuffer(), text.length());
+    ScriptRun scriptRun(text.getBuffer(), start, text.length() - start);
     
     while (scriptRun.next())
     {
@@ -84,10 +270,28 @@ void TextItemizer::itemizeScriptAndLanguage(const UnicodeString &text, const str
         auto language = langHelper.detectLanguage(script, langHint);
         
         items.emplace_back(start, end, make_pair(script, language));
+        
+        if (!scriptRun.hasOpenPairs())
+        {
+            safeEnds.push_back(end);
+            
+            if (resyncEnds && (end >= resyncStart) && binary_search(resyncEnds->begin(), resyncEnds->end(), end - resyncDelta))
+            {
+                return end;
+            }
+        }
     }
+    
+    return text.length();
+}
+
+void TextItemizer::itemizeDirection(const UnicodeString &text, hb_direction_t overallDirection, UBiDi *bidi, vector<DirectionItem> &items)
+{
+    setParagraph(text, overallDirection, bidi);
+    addDirectionItems(bidi, text.length(), items);
 }
 
-void TextItemizer::itemizeDirection(const UnicodeString &text, hb_direction_t overallDirection, vector<DirectionItem> &items)
+void TextItemizer::setParagraph(const UnicodeString &text, hb_direction_t overallDirection, UBiDi *bidi)
 {
     /*
      * IF overallDirection IS UNDEFINED: THE PARAGRAPH-LEVEL WILL BE DETERMINED FROM THE TEXT
@@ -95,12 +299,14 @@ void TextItemizer::itemizeDirection(const UnicodeString &text, hb_direction_t ov
      * SEE: http://www.icu-project.org/apiref/icu4c/ubidi_8h.html#abdfe9e113a19dd8521d3b7ac8220fe11
      */
     UBiDiLevel paraLevel = (overallDirection == HB_DIRECTION_INVALID) ? UBIDI_DEFAULT_LTR : ((overallDirection == HB_DIRECTION_RTL) ? 1 : 0);
-
-    auto length = text.length();
     UErrorCode error = U_ZERO_ERROR;
-    UBiDi *bidi = ubidi_openSized(length, 0, &error);
     
-    ubidi_setPara(bidi, text.getBuffer(), length, paraLevel, 0, &error);
+    ubidi_setPara(bidi, text.getBuffer(), text.length(), paraLevel, 0, &error);
+}
+
+void TextItemizer::addDirectionItems(UBiDi *bidi, int32_t length, vector<DirectionItem> &items, bool isLine)
+{
+    UErrorCode error = U_ZERO_ERROR;
     auto direction = ubidi_getDirection(bidi);
     
     if (direction != UBIDI_MIXED)
@@ -115,20 +321,40 @@ void TextItemizer::itemizeDirection(const UnicodeString &text, hb_direction_t ov
         {
             int32_t start, length;
             direction = ubidi_getVisualRun(bidi, i, &start, &length);
+            
+            /*
+             * FOR A LINE-OBJECT, THE RUN OF TRAILING WHITESPACES (AT THE PARAGRAPH-LEVEL, AS PER RULE L1) CAN BE RETURNED WITH THE WRONG DIRECTION
+             * E.G. "RTL" FOR THE SPACE FOLLOWING AN ARABIC WORD, AT THE END OF A LINE OF AN LTR PARAGRAPH
+             */
+            if (isLine)
+            {
+                direction = (ubidi_getLevelAt(bidi, start) & 1) ? UBIDI_RTL : UBIDI_LTR;
+            }
+            
             items.emplace_back(start, start + length, icuDirectionToHB(direction));
         }
     }
-    
-    ubidi_close(bidi);
 }
 
+/*
+ * THE DIRECTION-ITEMS ARE IN VISUAL ORDER: THE FIRST SCRIPT-ITEM OF EACH ONE IS FOUND BY BINARY-SEARCH,
+ * THEN THE SCRIPT-ITEMS ARE WALKED IN PARALLEL, WITHOUT GOING BACK
+ *
+ * THE RUNS OF AN RTL DIRECTION-ITEM ARE APPENDED IN LOGICAL ORDER, THEN REVERSED AS A BLOCK
+ * (INSTEAD OF BEING INSERTED ONE BY ONE BEFORE THE PREVIOUS ONES)
+ */
 void TextItemizer::mergeItems(const vector<ScriptAndLanguageItem> &scriptAndLanguageItems, const vector<DirectionItem> &directionItems, vector<TextRun> &runs)
 {
+    /*
+     * EACH DIRECTION-ITEM IS SPLITTING AT MOST ONE ADDITIONAL SCRIPT-ITEM
+     */
+    runs.reserve(scriptAndLanguageItems.size() + directionItems.size());
+    
     for (auto &directionItem : directionItems)
     {
         auto position = directionItem.start;
         auto end = directionItem.end;
-        auto rtlInsertionPoint = runs.end();
+        auto blockStart = runs.size();
         
         auto scriptAndLanguageIterator = findItem(scriptAndLanguageItems, position);
         
@@ -141,14 +367,7 @@ void TextItemizer::mergeItems(const vector<ScriptAndLanguageItem> &scriptAndLang
             run.language = scriptAndLanguageIterator->data.second;
             run.direction = directionItem.data;
             
-            if (directionItem.data == HB_DIRECTION_LTR)
-            {
-                runs.push_back(run);
-            }
-            else
-            {
-                rtlInsertionPoint = runs.insert(rtlInsertionPoint, run);
-            }
+            runs.push_back(run);
             
             position = run.end;
             
@@ -157,18 +376,25 @@ void TextItemizer::mergeItems(const vector<ScriptAndLanguageItem> &scriptAndLang
                 ++scriptAndLanguageIterator;
             }
         }
+        
+        if (directionItem.data != HB_DIRECTION_LTR)
+        {
+            std::reverse(runs.begin() + blockStart, runs.end());
+        }
     }
 }
 
+/*
+ * THE ITEMS ARE SORTED AND CONTIGUOUS
+ */
 template <typename T>
 typename T::const_iterator TextItemizer::findItem(const T &items, int32_t position)
 {
-    for (auto it = items.begin(); it != items.end(); ++it)
+    auto it = std::upper_bound(items.begin(), items.end(), position, [](int32_t position, const typename T::value_type &item) { return position < item.start; });
+    
+    if ((it != items.begin()) && ((it - 1)->end > position))
     {
-        if ((it->start <= position) && (it->end > position))
-        {
-            return it;
-        }
+        return it - 1;
     }
     
     return items.end();
@@ -43,18 +43,15 @@
 #include "unicode/uscript.h"
 #include "unicode/ubidi.h"
 
+class ShapingContext;
+class TextParagraph;
+
 class TextItemizer
 {
 public:
     static hb_script_t icuScriptToHB(UScriptCode script);
     static hb_direction_t icuDirectionToHB(UBiDiDirection direction);
     
-    TextItemizer(LangHelper &langHelper);
-    TextLine processLine(const std::string &input, const std::string &langHint = "", hb_direction_t overallDirection = HB_DIRECTION_INVALID);
-    
-protected:
-    LangHelper &langHelper;
-    
     template<typename T> struct Item
     {
         int32_t start;
@@ -69,11 +66,72 @@ protected:
         {}
     };
 
-    typedef Item<std::pair<hb_script_t, std::string>> ScriptAndLanguageItem;
+    typedef Item<std::pair<hb_script_t, Language>> ScriptAndLanguageItem;
     typedef Item<hb_direction_t> DirectionItem;
+    
+    TextItemizer(LangHelper &langHelper);
+    
+    /*
+     * USING THE ShapingContext OF THE CURRENT THREAD, AND RETURNING A COPY OF ITS TextLine
+     */
+    TextLine processLine(const std::string &input, const Language &langHint = Language(), hb_direction_t overallDirection = HB_DIRECTION_INVALID, const FeatureList &features = FeatureList());
+    
+    /*
+     * THE RETURNED REFERENCE IS context.line, I.E. IT REMAINS VALID UNTIL THE NEXT USE OF context
+     */
+    const TextLine& processLine(ShapingContext &context, const std::string &input, const Language &langHint = Language(), hb_direction_t overallDirection = HB_DIRECTION_INVALID, const FeatureList &features = FeatureList());
+    
+    /*
+     * SAME AS ABOVE, FOR A TEXT ALREADY IN UTF-16 (E.G. RESULTING FROM AN EDIT)
+     */
+    const TextLine& processText(ShapingContext &context, const UnicodeString &text, const Language &langHint = Language(), hb_direction_t overallDirection = HB_DIRECTION_INVALID, const FeatureList &features = FeatureList());
+    
+    /*
+     * SAME AS ABOVE, FOR A TEXT RESULTING FROM THE EDIT OF A PREVIOUS TEXT (SEE VirtualFont::editLineLayout):
+     * ONLY THE SCRIPT-ITEMS AFFECTED BY THE EDIT ARE RE-DETECTED, THE OTHER ONES ARE TAKEN FROM previousItems
+     *
+     * - previousItems AND previousSafeEnds: AS LEFT IN context.scriptAndLanguageItems AND context.safeItemEnds BY THE PREVIOUS PROCESSING
+     * - [editStart, editEnd): THE INSERTED RANGE IN text, editDelta: THE DIFFERENCE OF LENGTH WITH THE PREVIOUS TEXT
+     * - THE BIDI RESOLUTION IS NOT INCREMENTAL: IT IS DEPENDING ON THE WHOLE PARAGRAPH
+     */
+    const TextLine& processEditedText(ShapingContext &context, const UnicodeString &text, const Language &langHint, hb_direction_t overallDirection, const FeatureList &features, const std::vector<ScriptAndLanguageItem> &previousItems, const std::vector<int32_t> &previousSafeEnds, int32_t editStart, int32_t editEnd, int32_t editDelta);
+    
+    /*
+     * FAST-PATH: RETURNS TRUE IF processLine() WOULD TURN input INTO A SINGLE LTR LATIN RUN OF "SIMPLE TEXT" (SEE SimpleShaper)
+     * IN WHICH CASE context.simpleCodes AND context.simpleLanguage ARE DEFINED (WITHOUT INVOLVING ICU, NOR context.line)
+     */
+    bool processSimpleLine(ShapingContext &context, const std::string &input, const Language &langHint = Language(), hb_direction_t overallDirection = HB_DIRECTION_INVALID);
+    
+    /*
+     * ITEMIZING A WHOLE PARAGRAPH ONCE (SEE TextParagraph): SCRIPT-ITEMS AND PARAGRAPH-LEVEL BIDI
+     */
+    void processParagraph(TextParagraph &paragraph, const UnicodeString &text, const Language &langHint = Language(), hb_direction_t overallDirection = HB_DIRECTION_INVALID, const FeatureList &features = FeatureList());
+    
+    /*
+     * THE TextLine OF [start, end) IN paragraph.text (E.G. A WRAPPED LINE), WITH THE RUNS IN VISUAL ORDER FOR THIS RANGE
+     * AND THE OVERALL-DIRECTION OF THE PARAGRAPH
+     *
+     * - THE RETURNED REFERENCE IS context.line, WHOSE text IS THE SUB-STRING (I.E. THE RUNS ARE RELATIVE TO start)
+     * - SAME RUNS AS processText() FOR THE WHOLE RANGE OF A PARAGRAPH
+     * - THROWS invalid_argument IF THE RANGE IS OUT OF BOUNDS, OR CROSSING A PARAGRAPH-SEPARATOR
+     */
+    const TextLine& processParagraphLine(ShapingContext &context, const TextParagraph &paragraph, int32_t start, int32_t end);
+    
+    /*
+     * SEE LangHelper::getGeneration()
+     */
+    uint32_t getLanguageGeneration() const;
+    
+protected:
+    LangHelper &langHelper;
 
-    void itemizeScriptAndLanguage(const UnicodeString &text, const std::string &langHint, std::vector<ScriptAndLanguageItem> &items);
-    void itemizeDirection(const UnicodeString &text, hb_direction_t overallDirection, std::vector<DirectionItem> &items);
+    void resetLine(ShapingContext &context, const UnicodeString &text, const Language &langHint, hb_direction_t overallDirection, const FeatureList &features);
+    const TextLine& itemizeLine(ShapingContext &context, const Language &langHint, hb_direction_t overallDirection); // ITEMIZING context.line
+    const TextLine& resolveRuns(ShapingContext &context, const Language &langHint, hb_direction_t overallDirection); // ONCE context.scriptAndLanguageItems ARE DEFINED
+    int32_t itemizeScriptAndLanguage(const UnicodeString &text, int32_t start, const Language &langHint, std::vector<ScriptAndLanguageItem> &items, std::vector<int32_t> &safeEnds, const std::vector<int32_t> *resyncEnds = NULL, int32_t resyncStart = 0, int32_t resyncDelta = 0);
+    void itemizeDirection(const UnicodeString &text, hb_direction_t overallDirection, UBiDi *bidi, std::vector<DirectionItem> &items);
+    void setParagraph(const UnicodeString &text, hb_direction_t overallDirection, UBiDi *bidi);
+    void addDirectionItems(UBiDi *bidi, int32_t length, std::vector<DirectionItem> &items, bool isLine = false); // ONCE ubidi_setPara() OR ubidi_setLine() IS INVOKED
     void mergeItems(const std::vector<ScriptAndLanguageItem> &scriptAndLanguageItems, const std::vector<DirectionItem> &directionItems, std::vector<TextRun> &runs);
     
     template<typename T> typename T::const_iterator findItem(const T &items, int32_t position);
@@ -9,25 +9,71 @@
 #pragma once
 
 #include "TextRun.h"
+#include "FeatureList.h"
+
+#include "unicode/ustring.h"
 
 #include <vector>
+#include <algorithm>
 
 struct TextLine
 {
     UnicodeString text;
-    std::string langHint;
+    Language langHint;
     hb_direction_t overallDirection;
+    FeatureList features;
     std::vector<TextRun> runs;
     
-    TextLine(const std::string &input, const std::string &langHint, hb_direction_t overallDirection = HB_DIRECTION_INVALID)
+    TextLine()
+    :
+    overallDirection(HB_DIRECTION_INVALID)
+    {}
+    
+    TextLine(const std::string &input, const Language &langHint, hb_direction_t overallDirection = HB_DIRECTION_INVALID, const FeatureList &features = FeatureList())
     :
     langHint(langHint),
-    overallDirection(overallDirection)
+    overallDirection(overallDirection),
+    features(features)
     {
         text = UnicodeString::fromUTF8(input);
     }
     
-    void addRun(int32_t start, int32_t end, hb_script_t script, const std::string &lang, hb_direction_t direction)
+    /*
+     * SAME AS CONSTRUCTING A NEW TextLine, BUT REUSING THE MEMORY ALREADY ALLOCATED FOR text AND runs
+     */
+    void reset(const std::string &input, const Language &langHint, hb_direction_t overallDirection = HB_DIRECTION_INVALID, const FeatureList &features = FeatureList())
+    {
+        this->langHint = langHint;
+        this->overallDirection = overallDirection;
+        this->features = features;
+        runs.clear();
+        
+        /*
+         * THE UTF-16 LENGTH CAN'T EXCEED THE UTF-8 LENGTH
+         * INVALID SEQUENCES ARE REPLACED BY U+FFFD, AS WITH UnicodeString::fromUTF8()
+         */
+        int32_t length = 0;
+        UErrorCode error = U_ZERO_ERROR;
+        
+        auto buffer = text.getBuffer(std::max<int32_t>(1, input.size()));
+        u_strFromUTF8WithSub(buffer, text.getCapacity(), &length, input.data(), input.size(), 0xfffd, NULL, &error);
+        text.releaseBuffer(U_SUCCESS(error) ? length : 0);
+    }
+    
+    /*
+     * SAME AS ASSIGNING other, BUT COPYING ITS TEXT INTO THE MEMORY ALREADY ALLOCATED:
+     * ASSIGNING A UnicodeString IS SHARING ITS (REFERENCE-COUNTED) BUFFER, WHICH reset() WOULD THEN HAVE TO CLONE
+     */
+    void assign(const TextLine &other)
+    {
+        text.setTo(other.text.getBuffer(), other.text.length());
+        langHint = other.langHint;
+        overallDirection = other.overallDirection;
+        features = other.features;
+        runs.assign(other.runs.begin(), other.runs.end());
+    }
+    
+    void addRun(int32_t start, int32_t end, hb_script_t script, const Language &lang, hb_direction_t direction)
     {
         runs.emplace_back(start, end, script, lang, direction);
     }
@@ -0,0 +1,50 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+/*
+ * A PARAGRAPH ITEMIZED ONCE (SEE TextItemizer::processParagraph), FROM WHICH THE TextLine OF ANY RANGE CAN BE DERIVED
+ * (SEE TextItemizer::processParagraphLine), E.G. WHEN WRAPPING A LONG TEXT AT DIFFERENT WIDTHS
+ *
+ * - THE BIDI-LEVELS ARE RESOLVED ONCE FOR THE WHOLE PARAGRAPH (ubidi_setPara), AND EACH LINE IS REORDERED VIA ubidi_setLine:
+ *   A LINE IS NOT LOSING ITS BIDI-CONTEXT (E.G. AN ENGLISH LINE INSIDE AN HEBREW PARAGRAPH REMAINS RIGHT-TO-LEFT)
+ * - THE SCRIPT-ITEMS ARE ALSO DETECTED ONCE, AND CLIPPED TO THE RANGE OF EACH LINE
+ *
+ * NOT COPYABLE: bidi IS POINTING TO THE BUFFER OF text
+ */
+
+#pragma once
+
+#include "TextItemizer.h"
+
+class TextParagraph
+{
+public:
+    UnicodeString text;
+    Language langHint; // AS PASSED TO processParagraph()
+    hb_direction_t overallDirection; // THE ONE OF THE PARAGRAPH, AS RESOLVED BY ICU (UNLESS FORCED VIA processParagraph)
+    FeatureList features;
+
+    std::vector<TextItemizer::ScriptAndLanguageItem> scriptAndLanguageItems;
+    std::vector<int32_t> safeItemEnds;
+    UBiDi *bidi;
+
+    TextParagraph()
+    :
+    overallDirection(HB_DIRECTION_INVALID)
+    {
+        bidi = ubidi_open();
+    }
+
+    ~TextParagraph()
+    {
+        ubidi_close(bidi);
+    }
+
+    TextParagraph(const TextParagraph &other) = delete;
+    TextParagraph& operator=(const TextParagraph &other) = delete;
+};
@@ -8,25 +8,23 @@
 
 #pragma once
 
-#include "hb.h"
+#include "Language.h"
 
 #include "unicode/unistr.h"
 
-#include <string>
-
 struct TextRun
 {
     int32_t start;
     int32_t end;
     
     hb_script_t script;
-    std::string language;
+    Language language;
     hb_direction_t direction;
     
     TextRun()
     {}
     
-    TextRun(int32_t start, int32_t end, hb_script_t script, const std::string &language, hb_direction_t direction)
+    TextRun(int32_t start, int32_t end, hb_script_t script, const Language &language, hb_direction_t direction)
     :
     start(start),
     end(end),
@@ -44,7 +42,7 @@ struct TextRun
         
         if (!language.empty())
         {
-            hb_buffer_set_language(buffer, hb_language_from_string(language.data(), -1));
+            hb_buffer_set_language(buffer, language.get());
         }
         
         hb_buffer_add_utf16(buffer, text.getBuffer(), text.length(), start, end - start);
@@ -0,0 +1,90 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+#include "TextureStore.h"
+
+#include <algorithm>
+
+using namespace std;
+
+TextureStore::TextureStore()
+:
+budget(0),
+frame(1)
+{
+    resetCounters();
+}
+
+void TextureStore::setBudget(size_t budget)
+{
+    this->budget = budget;
+}
+
+size_t TextureStore::getBudget() const
+{
+    return budget;
+}
+
+void TextureStore::update(const vector<ReloadableTexture*> &textures)
+{
+    if (budget > 0)
+    {
+        size_t total = 0;
+        vector<ReloadableTexture*> candidates;
+        
+        for (auto texture : textures)
+        {
+            if (texture->isLoaded())
+            {
+                total += texture->getMemoryUsage();
+                candidates.push_back(texture);
+            }
+        }
+        
+        if (total > budget)
+        {
+            sort(candidates.begin(), candidates.end(), [](ReloadableTexture *lhs, ReloadableTexture *rhs) { return lhs->lastUse < rhs->lastUse; });
+            
+            for (auto texture : candidates)
+            {
+                if ((total <= budget) || (texture->lastUse >= frame))
+                {
+                    break;
+                }
+                
+                total -= texture->getMemoryUsage();
+                texture->unload();
+                evictionCount++;
+            }
+        }
+    }
+    
+    frame++;
+}
+
+uint64_t TextureStore::getHitCount() const
+{
+    return hitCount;
+}
+
+uint64_t TextureStore::getMissCount() const
+{
+    return missCount;
+}
+
+uint64_t TextureStore::getEvictionCount() const
+{
+    return evictionCount;
+}
+
+void TextureStore::resetCounters()
+{
+    hitCount = 0;
+    missCount = 0;
+    evictionCount = 0;
+}
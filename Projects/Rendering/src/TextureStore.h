@@ -0,0 +1,70 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+/*
+ * ENFORCING A BUDGET (IN BYTES) FOR THE GLYPH TEXTURES OF ALL THE ActualFont INSTANCES
+ *
+ * - EACH TEXTURE IS STAMPED WITH THE LAST FRAME DURING WHICH IT WAS DRAWN
+ * - UPON update(): THE LEAST-RECENTLY-DRAWN TEXTURES ARE DISCARDED UNTIL THE BUDGET IS MET
+ *   (THE UNIT OF EVICTION IS AN ATLAS PAGE OR A STANDALONE TEXTURE)
+ * - THE ReloadableTexture INSTANCES ARE NOT DESTROYED, I.E. THE POINTERS INSIDE ActualFont::Glyph REMAIN VALID,
+ *   AND THE TEXTURES WILL BE RECREATED WHEN NECESSARY (LIKE AFTER FontManager::discardTextures())
+ * - THE TEXTURES DRAWN DURING THE LAST FRAME ARE NEVER DISCARDED (OTHERWISE THEY WOULD BE RECREATED IN THE NEXT FRAME),
+ *   I.E. THE BUDGET IS EXCEEDED WHENEVER A SINGLE FRAME REQUIRES MORE
+ */
+
+#pragma once
+
+#include "ReloadableTexture.h"
+
+#include <vector>
+
+class TextureStore
+{
+public:
+    TextureStore();
+    
+    void setBudget(size_t budget); // 0 MEANS "UNLIMITED" (THE DEFAULT)
+    size_t getBudget() const;
+    
+    /*
+     * hit: TRUE IF THE TEXTURE WAS ALREADY LOADED (I.E. NOT CREATED OR RECREATED FOR THE SAKE OF THIS DRAW)
+     */
+    inline void touch(ReloadableTexture *texture, bool hit)
+    {
+        texture->lastUse = frame;
+        
+        if (hit)
+        {
+            hitCount++;
+        }
+        else
+        {
+            missCount++;
+        }
+    }
+    
+    /*
+     * MUST BE INVOKED ON THE RENDER-THREAD, BEFORE DRAWING A NEW FRAME
+     * textures: ALL THE TEXTURES CURRENTLY DEFINED (LOADED OR NOT)
+     */
+    void update(const std::vector<ReloadableTexture*> &textures);
+    
+    uint64_t getHitCount() const;
+    uint64_t getMissCount() const;
+    uint64_t getEvictionCount() const;
+    void resetCounters();
+    
+protected:
+    size_t budget;
+    int frame;
+    
+    uint64_t hitCount;
+    uint64_t missCount;
+    uint64_t evictionCount;
+};
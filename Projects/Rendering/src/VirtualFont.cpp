@@ -8,16 +8,34 @@
 
 #include "VirtualFont.h"
 
+#include <algorithm>
+
 using namespace std;
 using namespace ci;
 
 const int stride = sizeof(Vec2f) * 2;
+const int bucketStride = sizeof(float) * 8;
+
+/*
+ * INDICES ARE OF TYPE GLushort, I.E. A MAXIMUM OF 65536 VERTICES PER DRAW-CALL
+ */
+const size_t MAX_QUADS_PER_BUCKET = 65536 / 4;
 
-VirtualFont::VirtualFont(LayoutCache &layoutCache, TextItemizer &itemizer, float baseSize)
+VirtualFont::VirtualFont(LayoutCache &layoutCache, WordCache &wordCache, ItemizationCache &itemizationCache, TextItemizer &itemizer, WorkerPool &workerPool, float baseSize)
 :
 layoutCache(layoutCache),
+wordCache(wordCache),
+itemizationCache(itemizationCache),
 itemizer(itemizer),
-baseSize(baseSize)
+workerPool(workerPool),
+baseSize(baseSize),
+useDistanceField(false),
+useSimpleText(true),
+mode(MODE_DIRECT),
+drawCallCount(0),
+shapeCallCount(0),
+shapedCodeUnitCount(0),
+simpleLineCount(0)
 {
     vertices.reserve(4 * 2);
     colors.reserve(4);
@@ -26,7 +44,7 @@ baseSize(baseSize)
     setColor(ColorA(0, 0, 0, 1));
 }
 
-bool VirtualFont::addActualFont(const string &lang, ActualFont *font)
+bool VirtualFont::addActualFont(const Language &lang, ActualFont *font)
 {
     if (font)
     {
@@ -50,13 +68,13 @@ bool VirtualFont::addActualFont(const string &lang, ActualFont *font)
     return false;
 }
 
-const FontSet& VirtualFont::getFontSet(const string &lang) const
+const FontSet& VirtualFont::getFontSet(const Language &lang) const
 {
     auto it = fontSetMap.find(lang);
     
     if (it == fontSetMap.end())
     {
-        it = fontSetMap.find("");
+        it = fontSetMap.find(Language());
         
         if (it == fontSetMap.end())
         {
@@ -67,12 +85,12 @@ const FontSet& VirtualFont::getFontSet(const string &lang) const
     return it->second;
 }
 
-ActualFont::Metrics VirtualFont::getMetrics(const Cluster &cluster) const
+ActualFont::Metrics VirtualFont::getMetrics(const LineLayout &layout, const Cluster &cluster) const
 {
-    return cluster.font->metrics * sizeRatio;
+    return layout.getFont(cluster)->metrics * sizeRatio;
 }
 
-ActualFont::Metrics VirtualFont::getMetrics(const string &lang) const
+ActualFont::Metrics VirtualFont::getMetrics(const Language &lang) const
 {
     auto &fontSet = getFontSet(lang);
     
@@ -82,6 +100,7 @@ ActualFont::Metrics VirtualFont::getMetrics(const string &lang) const
     }
     else
     {
+        fontSet.front()->reload(); // IN CASE LOADING WAS DEFERRED (SEE FontIndex)
         return fontSet.front()->metrics * sizeRatio;
     }
 }
@@ -149,106 +168,877 @@ float VirtualFont::getAscent(const LineLayout &layout) const
     return layout.maxAscent * sizeRatio;
 }
 
-LineLayout* VirtualFont::createLineLayout(const string &text, const string &langHint, hb_direction_t overallDirection)
+LineLayout* VirtualFont::createLineLayout(const string &text, const Language &langHint, hb_direction_t overallDirection, const FeatureList &features)
 {
-    return createLineLayout(itemizer.processLine(text, langHint, overallDirection));
+    return createLineLayout(ShapingContext::getDefault(), text, langHint, overallDirection, features);
 }
 
 LineLayout* VirtualFont::createLineLayout(const TextLine &line)
 {
+    return createLineLayout(ShapingContext::getDefault(), line);
+}
+
+LineLayout* VirtualFont::createLineLayout(ShapingContext &context, const string &text, const Language &langHint, hb_direction_t overallDirection, const FeatureList &features)
+{
+    if (useSimpleText && features.empty() && itemizer.processSimpleLine(context, text, langHint, overallDirection))
+    {
+        auto layout = createSimpleLineLayout(context, langHint, overallDirection);
+        
+        if (layout)
+        {
+            return layout;
+        }
+    }
+    
+    return createLineLayout(context, itemizeLine(context, text, langHint, overallDirection, features));
+}
+
+vector<LineLayout*> VirtualFont::createLineLayouts(const vector<string> &lines, const Language &langHint, hb_direction_t overallDirection, const FeatureList &features)
+{
+    vector<LineLayout*> layouts(lines.size(), NULL);
+    
+    try
+    {
+        workerPool.run(lines.size(), [&](size_t index)
+        {
+            layouts[index] = createLineLayout(lines[index], langHint, overallDirection, features);
+        });
+    }
+    catch (...)
+    {
+        for (auto layout : layouts)
+        {
+            delete layout;
+        }
+        
+        throw;
+    }
+    
+    return layouts;
+}
+
+/*
+ * SPLITTING AFTER EACH SEQUENCE OF SPACES, E.G. "HELLO  WORLD" IS SPLIT INTO "HELLO  " AND "WORLD"
+ * RETURNS THE END OF THE WORD STARTING AT start (BOUNDED BY end)
+ */
+static int32_t findWordEnd(const UChar *text, int32_t start, int32_t end)
+{
+    while ((start < end) && (text[start] != ' '))
+    {
+        start++;
+    }
+    
+    while ((start < end) && (text[start] == ' '))
+    {
+        start++;
+    }
+    
+    return start;
+}
+
+/*
+ * A WORD IS SHAPED WITH THE REST OF THE LINE AS CONTEXT (SEE TextRun::apply), BUT CACHED BY ITS TEXT ONLY:
+ * ONLY THE WORDS BOUNDED BY SPACES (OR BY THE EDGES OF THE LINE) ON BOTH SIDES ARE INDEPENDENT FROM THEIR CONTEXT
+ *
+ * E.G. IN "ببܒܒ", THE ARABIC RUN IS JOINING THE FOLLOWING SYRIAC RUN: ITS WORD IS SHAPED, BUT NOT CACHED
+ */
+static bool isCacheableWord(const UnicodeString &text, int32_t start, int32_t end)
+{
+    auto buffer = text.getBuffer();
+    return ((start == 0) || (buffer[start - 1] == ' ')) && ((end == text.length()) || (buffer[end - 1] == ' '));
+}
+
+/*
+ * THE SPACES OF A RUN ARE SHAPED BY THE FIRST FONT OF THE SET COVERING U+0020: IF THIS FONT IS KERNING THE SPACE-GLYPH,
+ * SPLITTING THE RUN INTO WORDS WOULD CHANGE THE OUTPUT (SEE OpenTypeTables::isKerningSpace), I.E. THE RUN MUST BE SHAPED AS A WHOLE
+ */
+bool VirtualFont::canSplitIntoWords(const FontSet &fontSet)
+{
+    for (auto font : fontSet)
+    {
+        if (font->indexEntry && !font->indexEntry->covers(' '))
+        {
+            continue;
+        }
+        
+        font->reload();
+        
+        if (font->loaded && font->face->getOpenTypeTables()->coversSpace())
+        {
+            return !font->face->getOpenTypeTables()->isKerningSpace();
+        }
+    }
+    
+    return true;
+}
+
+/*
+ * APPENDING THE ELEMENTS OF newFonts NOT ALREADY IN fonts
+ */
+static void mergeFonts(vector<ActualFont*> &fonts, const vector<ActualFont*> &newFonts)
+{
+    for (auto font : newFonts)
+    {
+        if (find(fonts.begin(), fonts.end(), font) == fonts.end())
+        {
+            fonts.push_back(font);
+        }
+    }
+}
+
+/*
+ * APPENDING THE CLUSTERS OF word TO layout, WHOSE fonts MUST ALREADY CONTAIN THOSE OF word
+ */
+static void addWord(LineLayout &layout, const WordCache::Word &word, bool reverse, vector<uint16_t> &fontIndices)
+{
+    fontIndices.clear();
+    
+    for (auto font : word.fonts)
+    {
+        fontIndices.push_back(find(layout.fonts.begin(), layout.fonts.end(), font) - layout.fonts.begin());
+    }
+    
+    if (reverse)
+    {
+        for (auto it = word.clusters.rbegin(); it != word.clusters.rend(); ++it)
+        {
+            layout.addCluster(fontIndices[it->fontIndex], word.shapes.data() + it->shapeIndex, it->shapeCount, it->combinedAdvance);
+        }
+    }
+    else
+    {
+        for (auto &cluster : word.clusters)
+        {
+            layout.addCluster(fontIndices[cluster.fontIndex], word.shapes.data() + cluster.shapeIndex, cluster.shapeCount, cluster.combinedAdvance);
+        }
+    }
+}
+
+/*
+ * THE CACHED LINE IS COPIED INTO THE MEMORY ALREADY ALLOCATED BY context.line (SEE TextLine::assign)
+ * UPON MISS, THE CACHED COPY IS NOT SHARING THE BUFFER OF context.line EITHER: OTHERWISE, THE NEXT reset() WOULD HAVE TO CLONE IT
+ */
+const TextLine& VirtualFont::itemizeLine(ShapingContext &context, const string &text, const Language &langHint, hb_direction_t overallDirection, const FeatureList &features)
+{
+    if (!itemizationCache.isEnabled())
+    {
+        return itemizer.processLine(context, text, langHint, overallDirection, features);
+    }
+    
+    context.itemizationKey.set(text, langHint, overallDirection, itemizer.getLanguageGeneration());
+    auto cached = itemizationCache.get(context.itemizationKey);
+    
+    if (cached)
+    {
+        context.line.assign(*cached);
+        context.line.features = features;
+    }
+    else
+    {
+        auto line = make_shared<TextLine>();
+        line->assign(itemizer.processLine(context, text, langHint, overallDirection));
+        itemizationCache.add(context.itemizationKey, line);
+        
+        context.line.features = features;
+    }
+    
+    return context.line;
+}
+
+LineLayout* VirtualFont::createLineLayout(ShapingContext &context, const TextLine &line)
+{
+    context.words.clear();
+    context.runEnds.clear();
+    
+    /*
+     * WITH THE WordCache: UP TO 2 WORDS PER RUN ARE NOT CACHEABLE (THE FIRST AND THE LAST, SEE isCacheableWord)
+     */
+    if (context.runWords.size() < 2 * line.runs.size())
+    {
+        context.runWords.resize(2 * line.runs.size()); // ALLOWING TO KEEP POINTERS TO THE ELEMENTS
+    }
+    
+    size_t runIndex = 0;
+    
+    for (auto &run : line.runs)
+    {
+        auto &fontSet = getFontSet(run.language);
+        
+        if (wordCache.isEnabled() && canSplitIntoWords(fontSet))
+        {
+            auto text = line.text.getBuffer();
+            int32_t start = run.start;
+            
+            while (start < run.end)
+            {
+                int32_t end = findWordEnd(text, start, run.end);
+                
+                if (!isCacheableWord(line.text, start, end))
+                {
+                    auto &word = context.runWords[2 * runIndex + ((start == run.start) ? 0 : 1)];
+                    word.clear();
+                    
+                    shapeRange(context, line.text, run, start, end, fontSet, line.features, word);
+                    context.words.push_back(&word);
+                    
+                    start = end;
+                    continue;
+                }
+                
+                context.wordKey.set(fontSet, run.script, run.language, run.direction, line.features, line.text, start, end - start);
+                auto word = wordCache.get(context.wordKey);
+                
+                if (!word)
+                {
+                    word = make_shared<WordCache::Word>();
+                    shapeRange(context, line.text, run, start, end, fontSet, line.features, *word);
+                    wordCache.add(context.wordKey, word);
+                }
+                
+                context.cachedWords.push_back(word); // THE WORD COULD BE EVICTED BEFORE THE END OF THE ASSEMBLY
+                context.words.push_back(word.get());
+                
+                start = end;
+            }
+        }
+        else
+        {
+            auto &word = context.runWords[2 * runIndex];
+            word.clear();
+            
+            shapeRange(context, line.text, run, run.start, run.end, fontSet, line.features, word);
+            context.words.push_back(&word);
+        }
+        
+        context.runEnds.emplace_back(context.words.size(), HB_DIRECTION_IS_BACKWARD(run.direction));
+        runIndex++;
+    }
+    
+    return assembleLineLayout(context, line);
+}
+
+LineLayout* VirtualFont::createEditableLineLayout(const string &text, const Language &langHint, hb_direction_t overallDirection, const FeatureList &features)
+{
+    auto &context = ShapingContext::getDefault();
+    return createEditableLineLayout(context, itemizer.processLine(context, text, langHint, overallDirection, features), langHint, overallDirection, NULL, 0, 0, 0);
+}
+
+LineLayout* VirtualFont::editLineLayout(const LineLayout &previous, int32_t offset, int32_t removedLength, const string &insertedText)
+{
+    auto source = previous.source.get();
+    
+    if (!source || (previous.font != this))
+    {
+        throw invalid_argument("LineLayout IS NOT EDITABLE");
+    }
+    
+    auto &text = source->line.text;
+    
+    if ((offset < 0) || (removedLength < 0) || (offset > text.length() - removedLength))
+    {
+        throw out_of_range("INVALID EDIT");
+    }
+    
+    auto inserted = UnicodeString::fromUTF8(insertedText);
+    
+    UnicodeString editedText(text);
+    editedText.replace(offset, removedLength, inserted);
+    
+    auto editEnd = offset + inserted.length();
+    auto editDelta = inserted.length() - removedLength;
+    
+    auto &context = ShapingContext::getDefault();
+    auto &line = itemizer.processEditedText(context, editedText, source->langHint, source->overallDirection, source->line.features, source->scriptItems, source->safeItemEnds, offset, editEnd, editDelta);
+    
+    return createEditableLineLayout(context, line, source->langHint, source->overallDirection, source, offset, editEnd, editDelta);
+}
+
+/*
+ * HARFBUZZ IS USING UP TO 5 CHARACTERS OF CONTEXT ON EACH SIDE OF THE SHAPED RANGE (HB_BUFFER_CONTEXT_LENGTH), I.E. AT MOST 10 UTF-16 CODE-UNITS
+ */
+static const int32_t SHAPING_CONTEXT_LENGTH = 10;
+
+static bool sameProperties(const TextRun &run1, const TextRun &run2)
+{
+    return (run1.script == run2.script) && (run1.direction == run2.direction) && (run1.language == run2.language);
+}
+
+/*
+ * SAME WORDS AS createLineLayout(), EXCEPT THAT THE ONES OF previous WHICH ARE NOT AFFECTED BY THE EDIT
+ * ARE REUSED AS IS (I.E. NEITHER SHAPED AGAIN, NOR LOOKED-UP IN THE WordCache)
+ *
+ * [editStart, editEnd): THE INSERTED RANGE IN line.text
+ * editDelta: THE DIFFERENCE BETWEEN THE LENGTHS OF line.text AND OF THE PREVIOUS TEXT
+ */
+LineLayout* VirtualFont::createEditableLineLayout(ShapingContext &context, const TextLine &line, const Language &langHint, hb_direction_t overallDirection, const LineSource *previous, int32_t editStart, int32_t editEnd, int32_t editDelta)
+{
+    bool splitIntoWords = wordCache.isEnabled();
+    auto source = make_shared<LineSource>(line, langHint, overallDirection, splitIntoWords);
+    source->scriptItems = context.scriptAndLanguageItems;
+    source->safeItemEnds = context.safeItemEnds;
+    
+    if (previous && (previous->splitIntoWords != splitIntoWords))
+    {
+        previous = NULL; // THE ENTRIES ARE NOT COMPARABLE
+    }
+    
+    context.words.clear();
+    context.runEnds.clear();
+    
+    auto text = line.text.getBuffer();
+    
+    for (size_t runIndex = 0; runIndex < line.runs.size(); runIndex++)
+    {
+        auto &run = line.runs[runIndex];
+        auto &fontSet = getFontSet(run.language);
+        bool splitRun = splitIntoWords && canSplitIntoWords(fontSet);
+        int32_t start = run.start;
+        
+        while (start < run.end)
+        {
+            int32_t end = splitRun ? findWordEnd(text, start, run.end) : run.end;
+            bool cacheable = splitRun && isCacheableWord(line.text, start, end);
+            shared_ptr<WordCache::Word> word;
+            
+            if (previous)
+            {
+                /*
+                 * THE CACHEABLE WORDS ARE INDEPENDENT FROM THEIR CONTEXT (SEE isCacheableWord)
+                 * THE OTHER WORDS (OR THE WHOLE RUNS, WHEN NOT SPLIT) ARE SHAPED WITH THEIR CONTEXT, WHICH MUST NOT BE AFFECTED BY THE EDIT EITHER
+                 */
+                int32_t margin = cacheable ? 0 : SHAPING_CONTEXT_LENGTH;
+                const LineSource::Entry *entry = NULL;
+                
+                if (end + margin <= editStart)
+                {
+                    entry = previous->findEntry(start, end);
+                }
+                else if (start - margin >= editEnd)
+                {
+                    entry = previous->findEntry(start - editDelta, end - editDelta);
+                }
+                
+                /*
+                 * A CACHEABLE WORD CAN'T BE REUSED IF IT WAS SHAPED WITH ITS PREVIOUS CONTEXT (E.G. A SPACE INSERTED BEFORE IT)
+                 */
+                if (entry && sameProperties(previous->getRun(*entry), run) && (!cacheable || isCacheableWord(previous->line.text, entry->start, entry->end)))
+                {
+                    word = entry->word;
+                }
+            }
+            
+            if (!word)
+            {
+                if (cacheable)
+                {
+                    context.wordKey.set(fontSet, run.script, run.language, run.direction, line.features, line.text, start, end - start);
+                    word = wordCache.get(context.wordKey);
+                    
+                    if (!word)
+                    {
+                        word = make_shared<WordCache::Word>();
+                        shapeRange(context, line.text, run, start, end, fontSet, line.features, *word);
+                        wordCache.add(context.wordKey, word);
+                    }
+                }
+                else
+                {
+                    word = make_shared<WordCache::Word>();
+                    shapeRange(context, line.text, run, start, end, fontSet, line.features, *word);
+                }
+            }
+            
+            source->entries.emplace_back(start, end, runIndex, word);
+            context.words.push_back(word.get());
+            
+            start = end;
+        }
+        
+        context.runEnds.emplace_back(context.words.size(), HB_DIRECTION_IS_BACKWARD(run.direction));
+    }
+    
+    source->sortEntries();
+    
+    auto layout = assembleLineLayout(context, line);
+    layout->source = source;
+    
+    return layout;
+}
+
+/*
+ * ASSEMBLING THE WORDS OF context.words, PER RUN (SEE context.runEnds), IN VISUAL ORDER
+ */
+LineLayout* VirtualFont::assembleLineLayout(ShapingContext &context, const TextLine &line)
+{
+    /*
+     * THE SIZE OF EACH ARRAY IS KNOWN BEFORE ASSEMBLING, I.E. ONE ALLOCATION PER ARRAY
+     */
     auto layout = new LineLayout(this, line.langHint, line.overallDirection);
     
-    map<uint32_t, Cluster> clusterMap;
-    auto buffer = hb_buffer_create();
+    size_t clusterCount = 0;
+    size_t shapeCount = 0;
+    context.fonts.clear();
+    
+    for (auto word : context.words)
+    {
+        clusterCount += word->clusters.size();
+        shapeCount += word->shapes.size();
+        
+        mergeFonts(context.fonts, word->fonts);
+    }
+    
+    layout->fonts.assign(context.fonts.begin(), context.fonts.end());
+    layout->clusters.reserve(clusterCount);
+    layout->shapes.reserve(shapeCount);
+    
+    /*
+     * THE WORDS OF A BACKWARD RUN ARE ADDED IN REVERSE ORDER (AND THEIR CLUSTERS TOO)
+     */
+    size_t wordIndex = 0;
+    
+    for (auto &runEnd : context.runEnds)
+    {
+        if (runEnd.second)
+        {
+            for (size_t i = runEnd.first; i > wordIndex; i--)
+            {
+                addWord(*layout, *context.words[i - 1], true, context.fontIndices);
+            }
+        }
+        else
+        {
+            for (size_t i = wordIndex; i < runEnd.first; i++)
+            {
+                addWord(*layout, *context.words[i], false, context.fontIndices);
+            }
+        }
+        
+        wordIndex = runEnd.first;
+    }
+    
+    context.cachedWords.clear();
+    
+    for (auto &font : layout->fonts)
+    {
+        layout->maxHeight = std::max(layout->maxHeight, font->metrics.height);
+        layout->maxAscent = std::max(layout->maxAscent, font->metrics.ascent);
+        layout->maxDescent = std::max(layout->maxDescent, font->metrics.descent);
+    }
+    
+    return layout;
+}
+
+LineMetrics VirtualFont::measureLine(const string &text, const Language &langHint, hb_direction_t overallDirection, const FeatureList &features)
+{
+    LineMetrics metrics;
+    auto languageGeneration = itemizer.getLanguageGeneration();
+    bool splitIntoWords = wordCache.isEnabled();
+    
+    auto cached = widthCache.get(text, langHint, overallDirection, features, languageGeneration, splitIntoWords);
+    
+    if (cached)
+    {
+        metrics = *cached;
+    }
+    else
+    {
+        auto &context = ShapingContext::getDefault();
+        
+        if (!useSimpleText || !features.empty() || !itemizer.processSimpleLine(context, text, langHint, overallDirection) || !measureSimpleLine(context, metrics))
+        {
+            metrics = computeLineMetrics(context, itemizeLine(context, text, langHint, overallDirection, features));
+        }
+        
+        widthCache.add(text, langHint, overallDirection, features, languageGeneration, splitIntoWords, metrics);
+    }
+    
+    metrics.advance *= sizeRatio;
+    metrics.maxHeight *= sizeRatio;
+    metrics.maxAscent *= sizeRatio;
+    metrics.maxDescent *= sizeRatio;
+    
+    return metrics;
+}
+
+/*
+ * FOLLOWING createLineLayout(): THE SAME WORDS ARE USED (THE CACHED ONES ARE NOT SHAPED AGAIN),
+ * BUT THE MISSING WORDS ARE NOT ADDED TO THE WordCache
+ */
+LineMetrics VirtualFont::computeLineMetrics(ShapingContext &context, const TextLine &line)
+{
+    LineMetrics metrics;
+    context.fonts.clear();
     
     for (auto &run : line.runs)
     {
-        clusterMap.clear();
+        auto &fontSet = getFontSet(run.language);
         
-        for (auto &font : getFontSet(run.language))
+        if (wordCache.isEnabled() && canSplitIntoWords(fontSet))
         {
-            font->reload();
+            auto text = line.text.getBuffer();
+            int32_t start = run.start;
             
-            if (font->loaded)
+            while (start < run.end)
             {
-                layout->maxHeight = std::max(layout->maxHeight, font->metrics.height);
-                layout->maxAscent = std::max(layout->maxAscent, font->metrics.ascent);
-                layout->maxDescent = std::max(layout->maxDescent, font->metrics.descent);
+                int32_t end = findWordEnd(text, start, run.end);
+                shared_ptr<WordCache::Word> word;
                 
-                run.apply(line.text, buffer);
-                hb_shape(font->hbFont, buffer, NULL, 0);
+                if (isCacheableWord(line.text, start, end))
+                {
+                    context.wordKey.set(fontSet, run.script, run.language, run.direction, line.features, line.text, start, end - start);
+                    word = wordCache.get(context.wordKey);
+                }
+                
+                if (word)
+                {
+                    for (auto &cluster : word->clusters)
+                    {
+                        metrics.advance += cluster.combinedAdvance;
+                    }
+                    
+                    mergeFonts(context.fonts, word->fonts);
+                }
+                else
+                {
+                    measureRange(context, line.text, run, start, end, fontSet, line.features, metrics);
+                }
+                
+                start = end;
+            }
+        }
+        else
+        {
+            measureRange(context, line.text, run, run.start, run.end, fontSet, line.features, metrics);
+        }
+    }
+    
+    for (auto &font : context.fonts)
+    {
+        metrics.maxHeight = std::max(metrics.maxHeight, font->metrics.height);
+        metrics.maxAscent = std::max(metrics.maxAscent, font->metrics.ascent);
+        metrics.maxDescent = std::max(metrics.maxDescent, font->metrics.descent);
+    }
+    
+    return metrics;
+}
+
+/*
+ * THE FAST-PATH IS TAKEN WHEN THE FIRST FONT OF THE SET IS COVERING ALL THE CHARACTERS:
+ * THE REGULAR PATH WOULD THEN SHAPE THE WHOLE LINE WITH THIS FONT ONLY
+ */
+const SimpleShaper* VirtualFont::getSimpleShaper(ShapingContext &context, ActualFont *&font)
+{
+    auto &fontSet = getFontSet(context.simpleLanguage);
+    
+    if (!fontSet.empty())
+    {
+        font = fontSet.front();
+        font->reload();
+        
+        if (font->loaded)
+        {
+            auto shaper = font->getSimpleShaper(context.simpleLanguage.get());
+            
+            if (shaper && shaper->covers(context.simpleCodes))
+            {
+                return shaper;
+            }
+        }
+    }
+    
+    return NULL;
+}
+
+/*
+ * THE SAME CLUSTERS (ONE PER CHARACTER) AND SHAPES AS THE REGULAR PATH, USING THE SAME FLOATING-POINT OPERATIONS
+ *
+ * WHEN THE WordCache IS ENABLED: THE REGULAR PATH IS SHAPING EACH WORD SEPARATELY (SEE findWordEnd),
+ * I.E. THERE IS NO KERNING BETWEEN A SPACE AND THE FOLLOWING WORD (UNLESS THE FONT IS KERNING THE SPACE-GLYPH, SEE canSplitIntoWords)
+ */
+LineLayout* VirtualFont::createSimpleLineLayout(ShapingContext &context, const Language &langHint, hb_direction_t overallDirection)
+{
+    ActualFont *font;
+    auto shaper = getSimpleShaper(context, font);
+    
+    if (!shaper)
+    {
+        return NULL;
+    }
+    
+    auto layout = new LineLayout(this, langHint.empty() ? context.simpleLanguage : langHint, HB_DIRECTION_LTR);
+    
+    auto &codes = context.simpleCodes;
+    size_t count = codes.size();
+    bool splitWords = wordCache.isEnabled() && !font->face->getOpenTypeTables()->isKerningSpace();
+    
+    layout->fonts.assign(1, font);
+    layout->clusters.reserve(count);
+    layout->shapes.reserve(count);
+    
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t code = codes[i];
+        uint8_t nextCode = (i + 1 < count) ? codes[i + 1] : 0;
+        
+        if (splitWords && (code == ' ') && (nextCode != ' '))
+        {
+            nextCode = 0;
+        }
+        
+        Shape shape(shaper->getGlyph(code), Vec2f(0, 0));
+        layout->addCluster(0, &shape, 1, shaper->getAdvance(code, nextCode) * font->scale.x);
+    }
+    
+    layout->maxHeight = std::max(layout->maxHeight, font->metrics.height);
+    layout->maxAscent = std::max(layout->maxAscent, font->metrics.ascent);
+    layout->maxDescent = std::max(layout->maxDescent, font->metrics.descent);
+    
+    simpleLineCount.fetch_add(1, memory_order_relaxed);
+    return layout;
+}
+
+/*
+ * SAME AS createSimpleLineLayout(), BUT ONLY ACCUMULATING THE ADVANCE
+ */
+bool VirtualFont::measureSimpleLine(ShapingContext &context, LineMetrics &metrics)
+{
+    ActualFont *font;
+    auto shaper = getSimpleShaper(context, font);
+    
+    if (!shaper)
+    {
+        return false;
+    }
+    
+    auto &codes = context.simpleCodes;
+    size_t count = codes.size();
+    bool splitWords = wordCache.isEnabled() && !font->face->getOpenTypeTables()->isKerningSpace();
+    
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t code = codes[i];
+        uint8_t nextCode = (i + 1 < count) ? codes[i + 1] : 0;
+        
+        if (splitWords && (code == ' ') && (nextCode != ' '))
+        {
+            nextCode = 0;
+        }
+        
+        metrics.advance += shaper->getAdvance(code, nextCode) * font->scale.x;
+    }
+    
+    metrics.maxHeight = std::max(metrics.maxHeight, font->metrics.height);
+    metrics.maxAscent = std::max(metrics.maxAscent, font->metrics.ascent);
+    metrics.maxDescent = std::max(metrics.maxDescent, font->metrics.descent);
+    
+    simpleLineCount.fetch_add(1, memory_order_relaxed);
+    return true;
+}
+
+/*
+ * SHAPING THE [start, end) RANGE OF run INTO word, WHICH MUST BE EMPTY
+ * THE RESULTING CLUSTERS ARE IN LOGICAL ORDER
+ */
+void VirtualFont::shapeRange(ShapingContext &context, const UnicodeString &text, const TextRun &run, int32_t start, int32_t end, const FontSet &fontSet, const FeatureList &features, WordCache::Word &word)
+{
+    resolveClusters(context, text, run, start, end, fontSet, features, word.fonts, true);
+    
+    auto &entries = context.entries;
+    auto &shapes = context.shapes;
+    
+    word.clusters.reserve(entries.size());
+    word.shapes.reserve(shapes.size());
+    
+    for (auto &entry : entries)
+    {
+        word.clusters.emplace_back(word.shapes.size(), entry.shapeCount, entry.fontIndex, entry.combinedAdvance);
+        word.shapes.insert(word.shapes.end(), shapes.begin() + entry.shapeIndex, shapes.begin() + entry.shapeIndex + entry.shapeCount);
+    }
+}
+
+/*
+ * SAME AS shapeRange(), BUT ONLY ACCUMULATING THE ADVANCE AND THE FONTS USED (NO CLUSTER OR SHAPE IS CREATED)
+ */
+void VirtualFont::measureRange(ShapingContext &context, const UnicodeString &text, const TextRun &run, int32_t start, int32_t end, const FontSet &fontSet, const FeatureList &features, LineMetrics &metrics)
+{
+    context.rangeFonts.clear();
+    resolveClusters(context, text, run, start, end, fontSet, features, context.rangeFonts, false);
+    
+    for (auto &entry : context.entries)
+    {
+        metrics.advance += entry.combinedAdvance;
+    }
+    
+    mergeFonts(context.fonts, context.rangeFonts);
+}
+
+/*
+ * RESOLVING THE CLUSTERS OF THE [start, end) RANGE OF run (THE REST OF text IS USED AS CONTEXT)
+ * INTO context.entries (IN LOGICAL ORDER) AND context.shapes (ONLY withShapes)
+ * THE FONTS TRIED ARE APPENDED TO fonts, AND ClusterEntry::fontIndex IS RELATIVE TO IT
+ *
+ * FONTS ARE TRIED IN THE ORDER OF fontSet: EACH FALLBACK-FONT IS ONLY SHAPING
+ * THE SUB-RANGES THAT ARE STILL MISSING (THE CLUSTERS ALREADY RESOLVED ARE KEPT)
+ *
+ * LINEAR-TIME ASSEMBLY: THE GLYPHS OF A CLUSTER ARE CONSECUTIVE IN THE HARFBUZZ BUFFER,
+ * AND THE CLUSTER VALUES ARE MONOTONIC (INCREASING, OR DECREASING FOR BACKWARD DIRECTIONS)
+ */
+void VirtualFont::resolveClusters(ShapingContext &context, const UnicodeString &text, const TextRun &run, int32_t start, int32_t end, const FontSet &fontSet, const FeatureList &features, vector<ActualFont*> &fonts, bool withShapes)
+{
+    auto buffer = context.buffer;
+    auto &entries = context.entries;
+    auto &shapes = context.shapes;
+    auto &missingRanges = context.missingRanges;
+    auto &nextMissingRanges = context.nextMissingRanges;
+    
+    entries.clear();
+    shapes.clear();
+    missingRanges.assign(1, make_pair(start, end));
+    
+    TextRun range(run);
+    bool backward = HB_DIRECTION_IS_BACKWARD(run.direction);
+    
+    uint64_t callCount = 0;
+    uint64_t codeUnitCount = 0;
+    
+    for (auto &font : fontSet)
+    {
+        /*
+         * WHEN A FontIndex IS USED: A FONT NOT COVERING ANY CHARACTER OF THE MISSING RANGES IS NOT LOADED
+         * IT IS STILL TAKING PART IN THE LINE'S METRICS, AS WITHOUT A FontIndex (ITS METRICS ARE EXACT, SEE ActualFont)
+         */
+        if (font->indexEntry)
+        {
+            bool covered = false;
+            
+            for (auto &missing : missingRanges)
+            {
+                if (font->indexEntry->coversAny(text, missing.first, missing.second))
+                {
+                    covered = true;
+                    break;
+                }
+            }
+            
+            if (!covered)
+            {
+                fonts.push_back(font);
+                continue;
+            }
+        }
+        
+        font->reload();
+        
+        if (font->loaded)
+        {
+            uint16_t fontIndex = fonts.size();
+            fonts.push_back(font);
+            
+            size_t passStart = entries.size();
+            nextMissingRanges.clear();
+            
+            for (auto &missing : missingRanges)
+            {
+                range.start = missing.first;
+                range.end = missing.second;
+                range.apply(text, buffer);
+                
+                hb_shape(font->hbFont, buffer, features.data(), features.size()); // THE FT_Face IS LOCKED BY font->hbFont, ONLY DURING THE GLYPH-QUERIES
+                
+                callCount++;
+                codeUnitCount += range.end - range.start;
                 
                 auto glyphCount = hb_buffer_get_length(buffer);
                 auto glyphInfos = hb_buffer_get_glyph_infos(buffer, NULL);
                 auto glyphPositions = hb_buffer_get_glyph_positions(buffer, NULL);
-
-                bool hasMissingGlyphs = false;
                 
-                for (int i = 0; i < glyphCount; i++)
+                /*
+                 * ONE ENTRY PER CLUSTER, INCLUDING THE UNRESOLVED ONES (WITHOUT SHAPES)
+                 */
+                size_t rangeStart = entries.size();
+                
+                for (unsigned int i = 0; i < glyphCount; i++)
                 {
                     auto codepoint = glyphInfos[i].codepoint;
                     auto cluster = glyphInfos[i].cluster;
                     
-                    auto it = clusterMap.find(cluster);
-                    bool clusterFound = (it != clusterMap.end());
+                    if ((i == 0) || (cluster != glyphInfos[i - 1].cluster))
+                    {
+                        entries.emplace_back(cluster, shapes.size(), fontIndex);
+                    }
                     
                     if (codepoint)
                     {
-                        if (clusterFound && (it->second.font != font))
-                        {
-                            continue; // CLUSTER FOUND, WITH ANOTHER FONT (E.G. SPACE)
-                        }
-                        else
+                        auto &entry = entries.back();
+                        
+                        if (withShapes)
                         {
                             auto offset = Vec2f(glyphPositions[i].x_offset, -glyphPositions[i].y_offset) * font->scale;
-                            float advance = glyphPositions[i].x_advance * font->scale.x;
-                            
-                            if (clusterFound)
-                            {
-                                it->second.addShape(codepoint, offset, advance);
-                            }
-                            else
-                            {
-                                clusterMap.insert(make_pair(cluster, Cluster(font, codepoint, offset, advance)));
-                            }
+                            shapes.emplace_back(codepoint, Vec2f(entry.combinedAdvance, 0) + offset);
                         }
-                    }
-                    else if (!clusterFound)
-                    {
-                        hasMissingGlyphs = true;
+                        
+                        entry.shapeCount++;
+                        entry.combinedAdvance += glyphPositions[i].x_advance * font->scale.x;
                     }
                 }
                 
-                if (!hasMissingGlyphs)
+                if (backward)
                 {
-                    break; // NO NEED TO PROCEED TO THE NEXT FONT IN THE LIST
+                    reverse(entries.begin() + rangeStart, entries.end());
                 }
+                
+                /*
+                 * A CLUSTER IS SPANNING FROM ITS START TO THE START OF THE NEXT CLUSTER (IN LOGICAL ORDER)
+                 * UNRESOLVED CLUSTERS ARE REMOVED, AND THEIR SPANS ARE MERGED INTO THE MISSING RANGES OF THE NEXT FONT
+                 */
+                size_t entryCount = rangeStart;
+                
+                for (size_t i = rangeStart; i < entries.size(); i++)
+                {
+                    if (entries[i].shapeCount)
+                    {
+                        entries[entryCount++] = entries[i];
+                    }
+                    else
+                    {
+                        int32_t clusterStart = entries[i].cluster;
+                        int32_t clusterEnd = (i + 1 < entries.size()) ? entries[i + 1].cluster : range.end;
+                        
+                        if (!nextMissingRanges.empty() && (nextMissingRanges.back().second == clusterStart))
+                        {
+                            nextMissingRanges.back().second = clusterEnd;
+                        }
+                        else
+                        {
+                            nextMissingRanges.emplace_back(clusterStart, clusterEnd);
+                        }
+                    }
+                }
+                
+                entries.erase(entries.begin() + entryCount, entries.end());
             }
-        }
-        
-        if (run.direction == HB_DIRECTION_RTL)
-        {
-            for (auto it = clusterMap.rbegin(); it != clusterMap.rend(); ++it)
-            {
-                layout->addCluster(it->second);
-            }
-        }
-        else
-        {
-            for (auto it = clusterMap.begin(); it != clusterMap.end(); ++it)
+            
+            /*
+             * THE ENTRIES OF THIS PASS ARE FILLING THE HOLES LEFT BY THE PREVIOUS PASSES
+             */
+            inplace_merge(entries.begin(), entries.begin() + passStart, entries.end());
+            
+            missingRanges.swap(nextMissingRanges);
+            
+            if (missingRanges.empty())
             {
-                layout->addCluster(it->second);
+                break; // NO NEED TO PROCEED TO THE NEXT FONT IN THE LIST
             }
         }
     }
     
-    hb_buffer_destroy(buffer);
-    return layout;
+    shapeCallCount.fetch_add(callCount, memory_order_relaxed);
+    shapedCodeUnitCount.fetch_add(codeUnitCount, memory_order_relaxed);
 }
 
-shared_ptr<LineLayout> VirtualFont::getCachedLineLayout(const string &text, const string &langHint, hb_direction_t overallDirection)
+shared_ptr<LineLayout> VirtualFont::getCachedLineLayout(const string &text, const Language &langHint, hb_direction_t overallDirection, const FeatureList &features)
 {
-    return layoutCache.getLineLayout(this, text, langHint, overallDirection);
+    return layoutCache.getLineLayout(this, text, langHint, overallDirection, features);
 }
 
 void VirtualFont::setSize(float newSize)
@@ -266,20 +1056,64 @@ void VirtualFont::setColor(const ColorA &color)
     colors.emplace_back(color);
 }
 
-void VirtualFont::begin()
+void VirtualFont::begin(Mode mode)
 {
+    this->mode = mode;
+    drawCallCount = 0;
+    
     glEnable(GL_TEXTURE_2D);
     glEnableClientState(GL_VERTEX_ARRAY);
     glEnableClientState(GL_TEXTURE_COORD_ARRAY);
     glEnableClientState(GL_COLOR_ARRAY);
 
-    glVertexPointer(2, GL_FLOAT, stride, vertices.data());
-    glTexCoordPointer(2, GL_FLOAT, stride, vertices.data() + 1);
-    glColorPointer(4, GL_FLOAT, 0, colors.data());
+    if (mode == MODE_DIRECT)
+    {
+        glVertexPointer(2, GL_FLOAT, stride, vertices.data());
+        glTexCoordPointer(2, GL_FLOAT, stride, vertices.data() + 1);
+        glColorPointer(4, GL_FLOAT, 0, colors.data());
+    }
+    
+    if (useDistanceField)
+    {
+        /*
+         * THE EDGE OF A DISTANCE-FIELD IS AT 0.5, BUT THE TEXTURE'S ALPHA
+         * IS MODULATED BY THE ALPHA OF THE CURRENT COLOR (GL_MODULATE)
+         *
+         * NOTE: ALPHA-TESTING IS THE ONLY OPTION WITH THE FIXED-FUNCTION PIPELINE
+         * (SMOOTHSTEP-BASED ANTI-ALIASING WOULD REQUIRE A FRAGMENT-SHADER)
+         */
+        glEnable(GL_ALPHA_TEST);
+        glAlphaFunc(GL_GREATER, 0.5f * colors.front().a);
+    }
 }
 
 void VirtualFont::end()
 {
+    if (mode == MODE_TEXTURE_BUCKET)
+    {
+        for (auto it = buckets.begin(); it != buckets.end();)
+        {
+            if (it->second.indices.empty())
+            {
+                /*
+                 * A BUCKET WHICH WAS NOT USED SINCE THE LAST begin() IS REMOVED,
+                 * SINCE THE ASSOCIATED TEXTURE MAY NOT EXIST ANYMORE
+                 */
+                it = buckets.erase(it);
+            }
+            else
+            {
+                flush(it->first, it->second);
+                ++it;
+            }
+        }
+    }
+    
+    if (useDistanceField)
+    {
+        glDisable(GL_ALPHA_TEST);
+    }
+    
     glBindTexture(GL_TEXTURE_2D, 0);
     
     glDisable(GL_TEXTURE_2D);
@@ -288,34 +1122,121 @@ void VirtualFont::end()
     glDisableClientState(GL_COLOR_ARRAY);
 }
 
-void VirtualFont::drawCluster(const Cluster &cluster, const Vec2f &position)
+void VirtualFont::drawCluster(const LineLayout &layout, const Cluster &cluster, const Vec2f &position)
 {
-    for (auto &shape : cluster.shapes)
+    auto font = layout.getFont(cluster);
+    auto shapes = layout.getShapes(cluster);
+    
+    for (int i = 0; i < cluster.shapeCount; i++)
     {
-        auto glyph = cluster.font->getGlyph(shape.codepoint);
+        auto &shape = shapes[i];
+        auto glyph = font->getGlyph(shape.codepoint);
         
         if (glyph && glyph->texture)
         {
             auto ul = position + (shape.position + glyph->offset) * sizeRatio;
             auto lr = ul + glyph->size * sizeRatio;
             
-            vertices.clear();
-            
-            vertices.emplace_back(ul);
-            vertices.emplace_back(glyph->u1, glyph->v1);
+            if (mode == MODE_TEXTURE_BUCKET)
+            {
+                auto &bucket = buckets[glyph->texture];
+                addQuad(bucket, ul, lr, *glyph);
+                
+                if (bucket.getQuadCount() == MAX_QUADS_PER_BUCKET)
+                {
+                    flush(glyph->texture, bucket);
+                }
+            }
+            else
+            {
+                vertices.clear();
+                
+                vertices.emplace_back(ul);
+                vertices.emplace_back(glyph->u1, glyph->v1);
+                
+                vertices.emplace_back(lr.x, ul.y);
+                vertices.emplace_back(glyph->u2, glyph->v1);
+                
+                vertices.emplace_back(lr);
+                vertices.emplace_back(glyph->u2, glyph->v2);
+                
+                vertices.emplace_back(ul.x, lr.y);
+                vertices.emplace_back(glyph->u1, glyph->v2);
+                
+                glyph->texture->bind();
+                glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+                drawCallCount++;
+            }
+        }
+    }
+}
 
-            vertices.emplace_back(lr.x, ul.y);
-            vertices.emplace_back(glyph->u2, glyph->v1);
+int VirtualFont::getDrawCallCount() const
+{
+    return drawCallCount;
+}
 
-            vertices.emplace_back(lr);
-            vertices.emplace_back(glyph->u2, glyph->v2);
+uint64_t VirtualFont::getShapeCallCount() const
+{
+    return shapeCallCount;
+}
 
-            vertices.emplace_back(ul.x, lr.y);
-            vertices.emplace_back(glyph->u1, glyph->v2);
-            
-            glyph->texture->bind();
-            glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-        }
+uint64_t VirtualFont::getShapedCodeUnitCount() const
+{
+    return shapedCodeUnitCount;
+}
+
+uint64_t VirtualFont::getSimpleLineCount() const
+{
+    return simpleLineCount;
+}
+
+void VirtualFont::resetShapingCounters()
+{
+    shapeCallCount = 0;
+    shapedCodeUnitCount = 0;
+    simpleLineCount = 0;
+}
+
+void VirtualFont::addQuad(TextureBucket &bucket, const Vec2f &ul, const Vec2f &lr, const ActualFont::Glyph &glyph)
+{
+    auto &color = colors.front();
+    auto base = GLushort(bucket.vertices.size() / 8);
+    
+    const float quad[] =
+    {
+        ul.x, ul.y, glyph.u1, glyph.v1, color.r, color.g, color.b, color.a,
+        lr.x, ul.y, glyph.u2, glyph.v1, color.r, color.g, color.b, color.a,
+        lr.x, lr.y, glyph.u2, glyph.v2, color.r, color.g, color.b, color.a,
+        ul.x, lr.y, glyph.u1, glyph.v2, color.r, color.g, color.b, color.a
+    };
+    
+    bucket.vertices.insert(bucket.vertices.end(), quad, quad + 32);
+    
+    const GLushort indices[] =
+    {
+        GLushort(base), GLushort(base + 1), GLushort(base + 2),
+        GLushort(base + 2), GLushort(base + 3), GLushort(base)
+    };
+    
+    bucket.indices.insert(bucket.indices.end(), indices, indices + 6);
+}
+
+void VirtualFont::flush(ReloadableTexture *texture, TextureBucket &bucket)
+{
+    if (!bucket.indices.empty())
+    {
+        auto data = bucket.vertices.data();
+        
+        glVertexPointer(2, GL_FLOAT, bucketStride, data);
+        glTexCoordPointer(2, GL_FLOAT, bucketStride, data + 2);
+        glColorPointer(4, GL_FLOAT, bucketStride, data + 4);
+        
+        texture->bind();
+        glDrawElements(GL_TRIANGLES, bucket.indices.size(), GL_UNSIGNED_SHORT, bucket.indices.data());
+        drawCallCount++;
+        
+        bucket.clear();
     }
 }
 
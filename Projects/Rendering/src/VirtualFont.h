@@ -10,7 +10,13 @@
 
 #include "ActualFont.h"
 #include "LayoutCache.h"
+#include "LineSource.h"
+#include "WordCache.h"
+#include "WidthCache.h"
+#include "ItemizationCache.h"
 #include "TextItemizer.h"
+#include "ShapingContext.h"
+#include "WorkerPool.h"
 
 #include <set>
 #include <map>
@@ -29,6 +35,13 @@ public:
     }
     Style;
     
+    typedef enum
+    {
+        MODE_DIRECT, // ONE DRAW-CALL PER GLYPH, FOR DEBUGGING
+        MODE_TEXTURE_BUCKET // GLYPHS ARE GROUPED PER TEXTURE AND DRAWN UPON end()
+    }
+    Mode;
+    
     typedef enum
     {
         ALIGN_MIDDLE,
@@ -60,11 +73,17 @@ public:
     };
     
     LayoutCache &layoutCache;
+    WordCache &wordCache;
+    ItemizationCache &itemizationCache;
     TextItemizer &itemizer;
+    WorkerPool &workerPool;
     float baseSize;
+    bool useDistanceField; // DEFINED VIA THE distance-field ATTRIBUTE OF THE XML-DEFINITION
+    bool useSimpleText; // FAST-PATH FOR LATIN-1 TEXT, BYPASSING ICU AND HARFBUZZ (SEE SimpleShaper), ENABLED BY DEFAULT
+    WidthCache widthCache; // USED BY measureLine()
 
-    ActualFont::Metrics getMetrics(const Cluster &cluster) const; // RETURNS THE SIZED METRICS OF THE ActualFont USED BY cluster
-    ActualFont::Metrics getMetrics(const std::string &lang = "") const; // RETURNS THE SIZED METRICS OF THE FIRST ActualFont IN THE SET USED FOR lang
+    ActualFont::Metrics getMetrics(const LineLayout &layout, const Cluster &cluster) const; // RETURNS THE SIZED METRICS OF THE ActualFont USED BY cluster
+    ActualFont::Metrics getMetrics(const Language &lang = Language()) const; // RETURNS THE SIZED METRICS OF THE FIRST ActualFont IN THE SET USED FOR lang
     
     float getHeight(const LineLayout &layout) const;
     float getAscent(const LineLayout &layout) const;
@@ -80,18 +99,72 @@ public:
 
     /*
      * THE RETURNED INSTANCES ARE NOT MANAGED AND SHOULD BE DELETED BY THE CALLER
+     * THE OVERLOADS NOT TAKING A ShapingContext ARE USING THE ONE OF THE CURRENT THREAD
+     *
+     * THE OVERLOADS TAKING A string ARE TRYING THE "SIMPLE TEXT" FAST-PATH FIRST (SEE useSimpleText), UNLESS features IS NOT EMPTY
+     *
+     * features: THE OPENTYPE-FEATURES APPLIED TO THE WHOLE LINE (SEE FeatureList), PART OF THE KEYS OF THE CACHES
      */
-    LineLayout* createLineLayout(const std::string &text, const std::string &langHint = "", hb_direction_t overallDirection = HB_DIRECTION_INVALID);
+    LineLayout* createLineLayout(const std::string &text, const Language &langHint = Language(), hb_direction_t overallDirection = HB_DIRECTION_INVALID, const FeatureList &features = FeatureList());
     LineLayout* createLineLayout(const TextLine &line);
+    LineLayout* createLineLayout(ShapingContext &context, const std::string &text, const Language &langHint = Language(), hb_direction_t overallDirection = HB_DIRECTION_INVALID, const FeatureList &features = FeatureList());
+    LineLayout* createLineLayout(ShapingContext &context, const TextLine &line);
+    
+    /*
+     * THE LINES ARE SHAPED IN PARALLEL VIA workerPool (EACH THREAD WITH ITS OWN ShapingContext)
+     * THE RESULTS ARE IN THE ORDER OF lines, AND IDENTICAL TO THOSE OF createLineLayout()
+     *
+     * THE ActualFont INSTANCES MUST NOT BE UNLOADED (E.G. VIA FontManager::unload) WHILE THE BATCH IS RUNNING
+     * THE RETURNED INSTANCES ARE NOT MANAGED AND SHOULD BE DELETED BY THE CALLER
+     */
+    std::vector<LineLayout*> createLineLayouts(const std::vector<std::string> &lines, const Language &langHint = Language(), hb_direction_t overallDirection = HB_DIRECTION_INVALID, const FeatureList &features = FeatureList());
+    
+    /*
+     * EDITABLE LAYOUTS (E.G. FOR TEXT-FIELDS): KEEPING THEIR LineSource, I.E. THEIR TEXT, RUNS AND SHAPED WORDS
+     *
+     * editLineLayout(): THE LAYOUT OF THE TEXT OF previous, WHERE removedLength UTF-16 CODE-UNITS AT offset ARE REPLACED BY insertedText
+     * - ONLY THE SCRIPT-ITEMS AFFECTED BY THE EDIT ARE DETECTED AGAIN (THE BIDI-LEVELS ARE STILL RESOLVED FOR THE WHOLE PARAGRAPH)
+     * - ONLY THE WORDS AFFECTED BY THE EDIT ARE SHAPED AGAIN (OR THE RUNS, WHEN THE WordCache IS DISABLED OR CAN NOT BE USED, SEE canSplitIntoWords)
+     * - THE SAME RESULTS AS createLineLayout() FOR THE EDITED TEXT
+     * - THROWS invalid_argument IF previous IS NOT AN EDITABLE LAYOUT OF THIS VirtualFont, AND out_of_range IF THE EDIT IS NOT WITHIN THE TEXT
+     *
+     * USING THE ShapingContext OF THE CURRENT THREAD
+     * THE RETURNED INSTANCES ARE NOT MANAGED AND SHOULD BE DELETED BY THE CALLER (previous CAN BE DELETED AFTER editLineLayout)
+     */
+    LineLayout* createEditableLineLayout(const std::string &text, const Language &langHint = Language(), hb_direction_t overallDirection = HB_DIRECTION_INVALID, const FeatureList &features = FeatureList());
+    LineLayout* editLineLayout(const LineLayout &previous, int32_t offset, int32_t removedLength, const std::string &insertedText);
+    
+    /*
+     * THE SAME VALUES AS getAdvance(), getHeight(), getAscent() AND getDescent() FOR THE LineLayout OF text,
+     * BUT WITHOUT CREATING ITS CLUSTERS AND SHAPES (THE SAME ITEMIZATION, SHAPING AND FALLBACK-LOGIC ARE USED)
+     *
+     * SIZED, AND CACHED (UNSIZED) VIA widthCache
+     * NOTE: THE ADVANCE CAN DIFFER FROM THE ONE OF THE LineLayout IN THE LAST BITS (THE ADDITIONS ARE NOT PERFORMED IN VISUAL ORDER)
+     */
+    LineMetrics measureLine(const std::string &text, const Language &langHint = Language(), hb_direction_t overallDirection = HB_DIRECTION_INVALID, const FeatureList &features = FeatureList());
     
-    std::shared_ptr<LineLayout> getCachedLineLayout(const std::string &text, const std::string &langHint = "", hb_direction_t overallDirection = HB_DIRECTION_INVALID);
+    std::shared_ptr<LineLayout> getCachedLineLayout(const std::string &text, const Language &langHint = Language(), hb_direction_t overallDirection = HB_DIRECTION_INVALID, const FeatureList &features = FeatureList());
     
     void setSize(float size);
     void setColor(const ci::ColorA &color);
     
-    void begin();
+    /*
+     * IN CASE OF A DISTANCE-FIELD: setColor() MUST BE INVOKED BEFORE begin()
+     */
+    void begin(Mode mode = MODE_TEXTURE_BUCKET);
     void end();
-    void drawCluster(const Cluster &cluster, const ci::Vec2f &position);
+    void drawCluster(const LineLayout &layout, const Cluster &cluster, const ci::Vec2f &position);
+    
+    int getDrawCallCount() const; // NUMBER OF DRAW-CALLS ISSUED SINCE THE LAST begin()
+    
+    /*
+     * NUMBER OF hb_shape() CALLS, AND OF UTF-16 CODE-UNITS PASSED TO THEM, SINCE THE LAST resetShapingCounters()
+     * ATOMIC: ALSO UPDATED BY THE WORKERS OF createLineLayouts()
+     */
+    uint64_t getShapeCallCount() const;
+    uint64_t getShapedCodeUnitCount() const;
+    uint64_t getSimpleLineCount() const; // NUMBER OF LINES LAID-OUT OR MEASURED VIA THE FAST-PATH
+    void resetShapingCounters();
     
     static Style styleStringToEnum(const std::string &style);
     static std::string styleEnumToString(Style style);
@@ -100,16 +173,58 @@ protected:
     float size;
     float sizeRatio;
 
+    struct TextureBucket
+    {
+        std::vector<float> vertices; // INTERLEAVED POSITIONS, TEXTURE-COORDS AND COLORS
+        std::vector<GLushort> indices;
+        
+        size_t getQuadCount() const
+        {
+            return indices.size() / 6;
+        }
+        
+        void clear()
+        {
+            vertices.clear();
+            indices.clear();
+        }
+    };
+    
+    Mode mode;
+    int drawCallCount;
+    
+    std::atomic<uint64_t> shapeCallCount;
+    std::atomic<uint64_t> shapedCodeUnitCount;
+    std::atomic<uint64_t> simpleLineCount;
+    
     std::vector<ci::Vec2f> vertices;
     std::vector<ci::ColorA> colors;
+    std::map<ReloadableTexture*, TextureBucket> buckets;
     
     FontSet defaultFontSet; // ALLOWING getFontSet() TO RETURN CONST VALUES
-    std::map<std::string, FontSet> fontSetMap;
+    std::map<Language, FontSet> fontSetMap;
+    
+    VirtualFont(LayoutCache &layoutCache, WordCache &wordCache, ItemizationCache &itemizationCache, TextItemizer &itemizer, WorkerPool &workerPool, float baseSize);
+    
+    bool addActualFont(const Language &lang, ActualFont *font);
+    const FontSet& getFontSet(const Language &lang) const;
+    static bool canSplitIntoWords(const FontSet &fontSet); // FALSE IF THE SPACES ARE SHAPED BY A FONT KERNING THE SPACE-GLYPH
+    
+    const TextLine& itemizeLine(ShapingContext &context, const std::string &text, const Language &langHint, hb_direction_t overallDirection, const FeatureList &features); // VIA THE ItemizationCache, RETURNING context.line
+    LineLayout* assembleLineLayout(ShapingContext &context, const TextLine &line);
+    LineLayout* createEditableLineLayout(ShapingContext &context, const TextLine &line, const Language &langHint, hb_direction_t overallDirection, const LineSource *previous, int32_t editStart, int32_t editEnd, int32_t editDelta);
+    LineMetrics computeLineMetrics(ShapingContext &context, const TextLine &line); // UNSIZED
+    
+    const SimpleShaper* getSimpleShaper(ShapingContext &context, ActualFont *&font);
+    LineLayout* createSimpleLineLayout(ShapingContext &context, const Language &langHint, hb_direction_t overallDirection);
+    bool measureSimpleLine(ShapingContext &context, LineMetrics &metrics); // UNSIZED
     
-    VirtualFont(LayoutCache &layoutCache, TextItemizer &itemizer, float baseSize);
+    void shapeRange(ShapingContext &context, const UnicodeString &text, const TextRun &run, int32_t start, int32_t end, const FontSet &fontSet, const FeatureList &features, WordCache::Word &word);
+    void measureRange(ShapingContext &context, const UnicodeString &text, const TextRun &run, int32_t start, int32_t end, const FontSet &fontSet, const FeatureList &features, LineMetrics &metrics);
+    void resolveClusters(ShapingContext &context, const UnicodeString &text, const TextRun &run, int32_t start, int32_t end, const FontSet &fontSet, const FeatureList &features, std::vector<ActualFont*> &fonts, bool withShapes);
     
-    bool addActualFont(const std::string &lang, ActualFont *font);
-    const FontSet& getFontSet(const std::string &lang) const;
+    void addQuad(TextureBucket &bucket, const ci::Vec2f &ul, const ci::Vec2f &lr, const ActualFont::Glyph &glyph);
+    void flush(ReloadableTexture *texture, TextureBucket &bucket);
     
     friend class FontManager;
 };
@@ -0,0 +1,116 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+#include "WidthCache.h"
+
+using namespace std;
+
+WidthCache::WidthCache(size_t capacity)
+:
+enabled(true),
+capacity(capacity),
+size(0)
+{
+    assert(capacity > 0);
+}
+
+const LineMetrics* WidthCache::get(const string &text, const Language &langHint, hb_direction_t overallDirection, const FeatureList &features, uint32_t languageGeneration, bool splitIntoWords)
+{
+    if (enabled)
+    {
+        setLookupKey(text, langHint, overallDirection, features, languageGeneration, splitIntoWords);
+
+        /*
+         * NON-OWNING POINTER (ALIASING-CONSTRUCTOR WITH AN EMPTY OWNER): NO ALLOCATION
+         */
+        auto it = cache.left.find(shared_ptr<const Key>(shared_ptr<const Key>(), &lookupKey));
+
+        if (it != cache.left.end())
+        {
+            /*
+             * MOVING USED-ENTRY TO THE TAIL OF THE bimaps::list_of
+             */
+            cache.right.relocate(cache.right.end(), cache.project_right(it));
+            return &it->second;
+        }
+    }
+
+    return NULL;
+}
+
+void WidthCache::add(const string &text, const Language &langHint, hb_direction_t overallDirection, const FeatureList &features, uint32_t languageGeneration, bool splitIntoWords, const LineMetrics &metrics)
+{
+    size_t newSize = text.size();
+
+    if (!enabled || (newSize >= capacity))
+    {
+        return;
+    }
+
+    while (size + newSize > capacity)
+    {
+        /*
+         * LEAST-RECENTLY-USED ENTRIES ARE AT THE HEAD OF THE bimaps::list_of
+         */
+        size -= cache.right.begin()->second->text.size();
+        cache.right.erase(cache.right.begin());
+    }
+
+    setLookupKey(text, langHint, overallDirection, features, languageGeneration, splitIntoWords);
+
+    /*
+     * NEW ENTRIES ARE INSERTED AT THE TAIL OF THE bimaps::list_of
+     */
+    if (cache.insert(container_type::value_type(make_shared<const Key>(lookupKey), metrics)).second)
+    {
+        size += newSize;
+    }
+}
+
+void WidthCache::setEnabled(bool enabled)
+{
+    this->enabled = enabled;
+}
+
+bool WidthCache::isEnabled() const
+{
+    return enabled;
+}
+
+void WidthCache::clear()
+{
+    cache.clear();
+    size = 0;
+}
+
+void WidthCache::setCapacity(size_t newCapacity)
+{
+    assert(newCapacity > 0);
+
+    if (newCapacity < size)
+    {
+        clear();
+    }
+
+    capacity = newCapacity;
+}
+
+size_t WidthCache::getMemoryUsage() const
+{
+    return size;
+}
+
+void WidthCache::setLookupKey(const string &text, const Language &langHint, hb_direction_t overallDirection, const FeatureList &features, uint32_t languageGeneration, bool splitIntoWords)
+{
+    lookupKey.text.assign(text);
+    lookupKey.langHint = langHint;
+    lookupKey.overallDirection = overallDirection;
+    lookupKey.features = features;
+    lookupKey.languageGeneration = languageGeneration;
+    lookupKey.splitIntoWords = splitIntoWords;
+}
@@ -0,0 +1,94 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+/*
+ * SMALL CACHE OF (UNSIZED) LineMetrics, OWNED BY EACH VirtualFont AND USED BY VirtualFont::measureLine()
+ *
+ * - E.G. FOR FITTING, TRUNCATION OR COLUMN-SIZING, WHERE THE SAME LINES ARE MEASURED REPEATEDLY
+ * - LEAST-RECENTLY-USED ENTRIES ARE EVICTED WHEN capacity (IN BYTES OF UTF-8 TEXT) IS EXCEEDED
+ * - NOT THREAD-SAFE (LIKE LayoutCache)
+ */
+
+#pragma once
+
+#include "LineLayout.h"
+#include "FeatureList.h"
+
+#include <boost/bimap.hpp>
+#include <boost/bimap/list_of.hpp>
+#include <boost/bimap/set_of.hpp>
+
+#include <memory>
+
+class WidthCache
+{
+public:
+    struct Key
+    {
+        std::string text;
+        Language langHint;
+        hb_direction_t overallDirection;
+        FeatureList features;
+        uint32_t languageGeneration; // SEE LangHelper::getGeneration(): THE LANGUAGES OF THE RUNS ARE SELECTING THE FONT-SETS
+        bool splitIntoWords; // TRUE IF THE WordCache WAS ENABLED: THE RUNS WERE (POSSIBLY) SHAPED AS SEPARATE WORDS
+
+        Key()
+        :
+        overallDirection(HB_DIRECTION_INVALID),
+        languageGeneration(0),
+        splitIntoWords(false)
+        {}
+
+        bool operator<(const Key &rhs) const
+        {
+            return tie(languageGeneration, splitIntoWords, overallDirection, langHint, features, text) < tie(rhs.languageGeneration, rhs.splitIntoWords, rhs.overallDirection, rhs.langHint, rhs.features, rhs.text);
+        }
+    };
+
+    WidthCache(size_t capacity = 8 * 1024);
+
+    /*
+     * RETURNS NULL UPON MISS (OR WHEN DISABLED)
+     * THE RETURNED POINTER IS ONLY VALID UNTIL THE NEXT add()
+     */
+    const LineMetrics* get(const std::string &text, const Language &langHint, hb_direction_t overallDirection, const FeatureList &features, uint32_t languageGeneration, bool splitIntoWords);
+    void add(const std::string &text, const Language &langHint, hb_direction_t overallDirection, const FeatureList &features, uint32_t languageGeneration, bool splitIntoWords, const LineMetrics &metrics);
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    void clear();
+    void setCapacity(size_t newCapacity);
+    size_t getMemoryUsage() const;
+
+protected:
+    /*
+     * THE KEYS ARE STORED VIA POINTERS, ALLOWING TO LOOKUP VIA lookupKey WITHOUT ALLOCATING (SEE WordCache)
+     */
+    struct KeyPointerLess
+    {
+        bool operator()(const std::shared_ptr<const Key> &lhs, const std::shared_ptr<const Key> &rhs) const
+        {
+            return *lhs < *rhs;
+        }
+    };
+
+    typedef boost::bimaps::bimap<
+    boost::bimaps::set_of<std::shared_ptr<const Key>, KeyPointerLess>,
+    boost::bimaps::list_of<LineMetrics>
+    > container_type;
+
+    bool enabled;
+    size_t capacity;
+    size_t size;
+    container_type cache;
+
+    Key lookupKey; // REUSED ACROSS LOOKUPS
+
+    void setLookupKey(const std::string &text, const Language &langHint, hb_direction_t overallDirection, const FeatureList &features, uint32_t languageGeneration, bool splitIntoWords);
+};
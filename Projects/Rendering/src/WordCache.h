@@ -0,0 +1,142 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+/*
+ * SECOND-LEVEL CACHE, UNDERNEATH LayoutCache: SHAPED "WORDS" (I.E. SEGMENTS OF A TextRun, SPLIT AFTER SPACES)
+ *
+ * - ALLOWING VirtualFont::createLineLayout() TO ASSEMBLE A NEW LINE FROM THE WORDS OF PREVIOUSLY-SHAPED LINES
+ * - A WORD IS IDENTIFIED BY ITS TEXT, THE ActualFont INSTANCES AVAILABLE FOR SHAPING IT, ITS SCRIPT, LANGUAGE, DIRECTION AND OPENTYPE-FEATURES
+ * - SPACES ARE CONSIDERED AS "SAFE" BOUNDARIES: NO JOINING, LIGATURES OR CONTEXTUAL SUBSTITUTIONS ACROSS THEM
+ *   NOR KERNING: THE RUNS SHAPED WITH A FONT KERNING THE SPACE-GLYPH ARE NOT SPLIT (SEE OpenTypeTables::isKerningSpace),
+ *   I.E. ENABLING THE CACHE IS NOT CHANGING THE OUTPUT
+ * - THE WORDS NOT BOUNDED BY SPACES (OR BY THE EDGES OF THE LINE) ON BOTH SIDES ARE NOT CACHED, E.G. AT A RUN-BOUNDARY
+ *   WITHOUT A SPACE: THEIR SHAPING IS DEPENDING ON THE SURROUNDING TEXT (SEE isCacheableWord IN VirtualFont.cpp)
+ * - LEAST-RECENTLY-USED WORDS ARE EVICTED WHEN capacity (IN UTF-16 CODE-UNITS) IS EXCEEDED
+ * - THREAD-SAFE: SHARED BY THE WORKERS OF VirtualFont::createLineLayouts()
+ *   THE RETURNED WORDS ARE IMMUTABLE, AND REMAIN VALID AFTER EVICTION (VIA shared_ptr)
+ */
+
+#pragma once
+
+#include "LineLayout.h"
+#include "FeatureList.h"
+
+#include "unicode/unistr.h"
+
+#include "cinder/Thread.h"
+
+#include <boost/bimap.hpp>
+#include <boost/bimap/list_of.hpp>
+#include <boost/bimap/set_of.hpp>
+
+#include <atomic>
+#include <memory>
+
+class WordCache
+{
+public:
+    struct Key
+    {
+        std::vector<ActualFont*> fontSet;
+        hb_script_t script;
+        Language language;
+        hb_direction_t direction;
+        FeatureList features;
+        UnicodeString text;
+
+        Key()
+        :
+        script(HB_SCRIPT_INVALID),
+        direction(HB_DIRECTION_INVALID)
+        {}
+        
+        /*
+         * REUSING THE MEMORY ALREADY ALLOCATED BY THE KEY, I.E. SUITED FOR REPEATED LOOKUPS
+         */
+        void set(const std::vector<ActualFont*> &fontSet, hb_script_t script, const Language &language, hb_direction_t direction, const FeatureList &features, const UnicodeString &source, int32_t start, int32_t length)
+        {
+            this->fontSet.assign(fontSet.begin(), fontSet.end());
+            this->script = script;
+            this->language = language;
+            this->direction = direction;
+            this->features = features;
+            this->text.setTo(source, start, length);
+        }
+
+        bool operator<(const Key &rhs) const
+        {
+            return tie(text, script, direction, language, features, fontSet) < tie(rhs.text, rhs.script, rhs.direction, rhs.language, rhs.features, rhs.fontSet);
+        }
+    };
+
+    /*
+     * SAME FLAT REPRESENTATION AS LineLayout: Cluster::fontIndex AND Cluster::shapeIndex ARE RELATIVE TO THE Word
+     */
+    struct Word
+    {
+        std::vector<ActualFont*> fonts; // THE FONTS TRIED FOR SHAPING (NOT NECESSARILY LOADED, SEE FontIndex), I.E. TAKING PART IN THE LINE'S METRICS
+        std::vector<Cluster> clusters; // IN LOGICAL ORDER
+        std::vector<Shape> shapes;
+        
+        void clear()
+        {
+            fonts.clear();
+            clusters.clear();
+            shapes.clear();
+        }
+    };
+
+    WordCache(size_t capacity = 64 * 1024);
+
+    /*
+     * RETURNS NULL UPON MISS
+     */
+    std::shared_ptr<Word> get(const Key &key);
+    void add(const Key &key, std::shared_ptr<Word> word);
+
+    /*
+     * WHEN DISABLED: VirtualFont::createLineLayout() IS SHAPING EACH TextRun AS A WHOLE
+     */
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    void clear();
+    void setCapacity(size_t newCapacity);
+    size_t getMemoryUsage() const;
+
+    uint64_t getHitCount() const;
+    uint64_t getMissCount() const;
+    void resetCounters();
+
+protected:
+    /*
+     * THE KEYS ARE STORED VIA POINTERS: boost::bimap IS COPYING THE KEY PASSED TO find()
+     */
+    struct KeyPointerLess
+    {
+        bool operator()(const std::shared_ptr<const Key> &lhs, const std::shared_ptr<const Key> &rhs) const
+        {
+            return *lhs < *rhs;
+        }
+    };
+    
+    typedef boost::bimaps::bimap<
+    boost::bimaps::set_of<std::shared_ptr<const Key>, KeyPointerLess>,
+    boost::bimaps::list_of<std::shared_ptr<Word>>
+    > container_type;
+
+    mutable std::mutex mutex;
+    
+    std::atomic<bool> enabled;
+    size_t capacity;
+    size_t size;
+    container_type cache;
+
+    uint64_t hitCount;
+    uint64_t missCount;
+};
@@ -0,0 +1,271 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace std;
+
+WorkerPool::WorkerPool(int workerCount)
+:
+workerCount((workerCount < 0) ? getDefaultWorkerCount() : workerCount),
+participantCount(1),
+exiting(false),
+batchIndex(0),
+busyCount(0),
+task(NULL),
+failed(false)
+{}
+
+WorkerPool::~WorkerPool()
+{
+    stop();
+}
+
+void WorkerPool::setWorkerCount(int workerCount)
+{
+    lock_guard<std::mutex> batchLock(batchMutex);
+
+    if (workerCount != this->workerCount)
+    {
+        stop();
+        this->workerCount = std::max(0, workerCount);
+    }
+}
+
+int WorkerPool::getWorkerCount() const
+{
+    return workerCount;
+}
+
+void WorkerPool::run(size_t count, const function<void(size_t)> &task)
+{
+    assert(count <= 0xffffffff);
+    lock_guard<std::mutex> batchLock(batchMutex);
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    if (!ranges)
+    {
+        start();
+    }
+
+    /*
+     * THE INITIAL RANGES ARE OF EQUAL SIZE
+     */
+    for (int i = 0; i < participantCount; i++)
+    {
+        ranges[i].bounds.store(pack(count * i / participantCount, count * (i + 1) / participantCount), memory_order_relaxed);
+    }
+
+    this->task = &task;
+    failed = false;
+
+    if (workers.empty())
+    {
+        participate(0);
+    }
+    else
+    {
+        {
+            lock_guard<std::mutex> lock(mutex);
+            busyCount = workers.size();
+            batchIndex++;
+        }
+
+        batchAvailable.notify_all();
+        participate(0);
+
+        unique_lock<std::mutex> lock(mutex);
+        batchDone.wait(lock, [this]{ return busyCount == 0; });
+    }
+
+    this->task = NULL;
+
+    if (exception)
+    {
+        auto e = exception;
+        exception = NULL;
+
+        rethrow_exception(e);
+    }
+}
+
+int WorkerPool::getDefaultWorkerCount()
+{
+    return std::max(0, int(thread::hardware_concurrency()) - 1);
+}
+
+void WorkerPool::start()
+{
+    participantCount = workerCount + 1;
+    ranges = unique_ptr<Range[]>(new Range[participantCount]);
+
+    for (int i = 0; i < workerCount; i++)
+    {
+        workers.emplace_back(&WorkerPool::work, this, i, batchIndex);
+    }
+}
+
+void WorkerPool::stop()
+{
+    if (!workers.empty())
+    {
+        {
+            lock_guard<std::mutex> lock(mutex);
+            exiting = true;
+        }
+
+        batchAvailable.notify_all();
+
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+
+        workers.clear();
+        exiting = false;
+    }
+
+    ranges.reset();
+}
+
+void WorkerPool::work(int workerIndex, uint64_t lastBatchIndex)
+{
+    while (true)
+    {
+        {
+            unique_lock<std::mutex> lock(mutex);
+            batchAvailable.wait(lock, [&]{ return exiting || (batchIndex != lastBatchIndex); });
+
+            if (exiting)
+            {
+                return;
+            }
+
+            lastBatchIndex = batchIndex;
+        }
+
+        participate(workerIndex + 1);
+
+        {
+            lock_guard<std::mutex> lock(mutex);
+            busyCount--;
+        }
+
+        batchDone.notify_one();
+    }
+}
+
+void WorkerPool::participate(int participantIndex)
+{
+    auto &range = ranges[participantIndex];
+    size_t index;
+
+    while (!failed)
+    {
+        if (pop(range, index))
+        {
+            try
+            {
+                (*task)(index);
+            }
+            catch (...)
+            {
+                lock_guard<std::mutex> lock(mutex);
+
+                if (!exception)
+                {
+                    exception = current_exception();
+                }
+
+                failed = true;
+            }
+        }
+        else
+        {
+            bool stolen = false;
+
+            for (int i = 1; i < participantCount; i++)
+            {
+                if (steal(ranges[(participantIndex + i) % participantCount], range))
+                {
+                    stolen = true;
+                    break;
+                }
+            }
+
+            if (!stolen)
+            {
+                break; // THE REMAINING TASKS (IF ANY) ARE ALREADY IN PROGRESS
+            }
+        }
+    }
+}
+
+/*
+ * TAKING THE FIRST INDEX OF range (ONLY INVOKED BY ITS OWNER)
+ */
+bool WorkerPool::pop(Range &range, size_t &index)
+{
+    auto bounds = range.bounds.load(memory_order_relaxed);
+
+    while (true)
+    {
+        size_t begin = bounds >> 32;
+        size_t end = bounds & 0xffffffff;
+
+        if (begin >= end)
+        {
+            return false;
+        }
+
+        if (range.bounds.compare_exchange_weak(bounds, pack(begin + 1, end), memory_order_relaxed))
+        {
+            index = begin;
+            return true;
+        }
+    }
+}
+
+/*
+ * MOVING THE BACK-HALF OF victim (OR ITS LAST INDEX) TO range, WHICH MUST BE EMPTY
+ */
+bool WorkerPool::steal(Range &victim, Range &range)
+{
+    auto bounds = victim.bounds.load(memory_order_relaxed);
+
+    while (true)
+    {
+        size_t begin = bounds >> 32;
+        size_t end = bounds & 0xffffffff;
+
+        if (begin >= end)
+        {
+            return false;
+        }
+
+        size_t middle = begin + (end - begin) / 2;
+
+        if (victim.bounds.compare_exchange_weak(bounds, pack(begin, middle), memory_order_relaxed))
+        {
+            range.bounds.store(pack(middle, end), memory_order_relaxed);
+            return true;
+        }
+    }
+}
+
+uint64_t WorkerPool::pack(size_t begin, size_t end)
+{
+    return (uint64_t(begin) << 32) | uint64_t(end);
+}
@@ -0,0 +1,90 @@
+/*
+ * THE UNICODE TEST SUITE FOR CINDER: https://github.com/arielm/Unicode
+ * COPYRIGHT (C) 2013, ARIEL MALKA ALL RIGHTS RESERVED.
+ *
+ * THE FOLLOWING SOURCE-CODE IS DISTRIBUTED UNDER THE MODIFIED BSD LICENSE:
+ * https://github.com/arielm/Unicode/blob/master/LICENSE.md
+ */
+
+/*
+ * RUNNING A BATCH OF INDEPENDENT TASKS (E.G. ONE PER LINE, SEE VirtualFont::createLineLayouts) ON WORKER-THREADS
+ *
+ * - THE CALLING THREAD IS TAKING PART IN THE BATCH, AND run() IS RETURNING ONCE ALL THE TASKS ARE DONE
+ * - WORK-STEALING: EACH PARTICIPANT STARTS WITH A CONTIGUOUS RANGE OF INDICES, TAKEN ONE BY ONE FROM ITS FRONT
+ *   ONCE ITS RANGE IS EXHAUSTED, A PARTICIPANT IS STEALING THE BACK-HALF OF THE RANGE OF ANOTHER ONE
+ * - EACH RANGE IS PACKED INTO A SINGLE ATOMIC WORD, I.E. NO LOCKING IS TAKING PLACE WHILE THE BATCH IS RUNNING
+ * - THE WORKERS ARE STARTED UPON THE FIRST BATCH
+ * - ONE BATCH AT A TIME: A TASK MUST NOT INVOKE run() ON THE SAME POOL
+ */
+
+#pragma once
+
+#include "cinder/Thread.h"
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class WorkerPool
+{
+public:
+    /*
+     * BY DEFAULT: ONE WORKER PER ADDITIONAL HARDWARE-THREAD
+     */
+    WorkerPool(int workerCount = -1);
+    ~WorkerPool();
+
+    /*
+     * ZERO WORKERS: THE TASKS ARE RUNNING ON THE CALLING THREAD ONLY
+     */
+    void setWorkerCount(int workerCount);
+    int getWorkerCount() const;
+
+    /*
+     * INVOKES task(index) FOR EACH index IN [0, count)
+     * IF SOME TASKS ARE THROWING: THE REMAINING ONES ARE SKIPPED AND THE FIRST EXCEPTION IS RETHROWN
+     */
+    void run(size_t count, const std::function<void(size_t)> &task);
+
+    static int getDefaultWorkerCount();
+
+protected:
+    /*
+     * [BEGIN, END) PACKED INTO 64 BITS, ON ITS OWN CACHE-LINE
+     */
+    struct Range
+    {
+        std::atomic<uint64_t> bounds;
+        char padding[64 - sizeof(std::atomic<uint64_t>)];
+    };
+
+    int workerCount;
+    int participantCount; // THE WORKERS AND THE CALLING THREAD
+
+    std::mutex batchMutex; // ONE BATCH AT A TIME
+    std::mutex mutex;
+    std::condition_variable batchAvailable;
+    std::condition_variable batchDone;
+    bool exiting;
+
+    uint64_t batchIndex;
+    int busyCount; // THE WORKERS STILL TAKING PART IN THE CURRENT BATCH
+    const std::function<void(size_t)> *task;
+    std::unique_ptr<Range[]> ranges; // ONE PER PARTICIPANT: THE CALLING THREAD FIRST, THEN THE WORKERS
+    std::atomic<bool> failed;
+    std::exception_ptr exception;
+
+    std::vector<std::thread> workers;
+
+    void start();
+    void stop();
+    void work(int workerIndex, uint64_t lastBatchIndex);
+    void participate(int participantIndex);
+
+    bool pop(Range &range, size_t &index);
+    bool steal(Range &victim, Range &range);
+
+    static uint64_t pack(size_t begin, size_t end);
+};
@@ -184,7 +184,13 @@ UBool ScriptRun::next()
             // pop it from the stack
             if (pairIndex >= 0 && (pairIndex & 1) != 0 && parenSP >= 0) {
                 parenSP -= 1;
-                startSP -= 1;
+
+                // decrement startSP only if it is >= 0: otherwise, the
+                // fix-up loop above would write before parenStack
+                // (e.g. startSP = -2, parenSP = -1), as fixed in later ICU versions
+                if (startSP >= 0) {
+                    startSP -= 1;
+                }
             }
         } else {
             // if the run broke on a surrogate pair,
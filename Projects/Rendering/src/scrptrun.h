@@ -53,6 +53,11 @@ public:
 
     UBool next();
 
+    // local addition: true if some paired characters (e.g. an opening
+    // parenthesis) are still pending after the current run, i.e. if the
+    // next runs depend on the text before them (see TextItemizer)
+    UBool hasOpenPairs();
+
     /**
      * ICU "poor man's RTTI", returns a UClassID for the actual class.
      *
@@ -127,6 +132,11 @@ inline UScriptCode ScriptRun::getScriptCode()
     return scriptCode;
 }
 
+inline UBool ScriptRun::hasOpenPairs()
+{
+    return parenSP >= 0;
+}
+
 inline void ScriptRun::reset()
 {
     scriptStart = charStart;
@@ -29,4 +29,5 @@ LOCAL_SRC_FILES += $(HB_SRC)/hb-ucdn.cc
 LOCAL_SRC_FILES += $(HB_SRC)/hb-unicode.cc
 LOCAL_SRC_FILES += $(HB_SRC)/ucdn.c
 
-LOCAL_CFLAGS += -DHB_NO_MT -DHAVE_OT -DHAVE_UCDN
+# THREAD-SAFE BUILD: PTHREAD MUTEXES AND GCC ATOMIC BUILTINS (OSX AND IOS ARE USING THEIR NATIVE EQUIVALENTS VIA __APPLE__)
+LOCAL_CFLAGS += -DHAVE_PTHREAD -DHAVE_INTEL_ATOMIC_PRIMITIVES -DHAVE_OT -DHAVE_UCDN
@@ -36,7 +36,7 @@ template <unsigned int key_bits, unsigned int value_bits, unsigned int cache_bit
 struct hb_cache_t
 {
   ASSERT_STATIC (key_bits >= cache_bits);
-  ASSERT_STATIC (key_bits + value_bits - cache_bits < 8 * sizeof (unsigned int));
+  ASSERT_STATIC (key_bits + value_bits - cache_bits <= 8 * sizeof (unsigned int)); /* Local change: was <, rejecting hb_advance_cache_t */
 
   inline void clear (void)
   {
@@ -46,7 +46,7 @@ struct hb_cache_t
   inline bool get (unsigned int key, unsigned int *value)
   {
     unsigned int k = key & ((1<<cache_bits)-1);
-    unsigned int v = values[k];
+    unsigned int v = load (k);
     if ((v >> value_bits) != (key >> cache_bits))
       return false;
     *value = v & ((1<<value_bits)-1);
@@ -59,11 +59,22 @@ struct hb_cache_t
       return false; /* Overflows */
     unsigned int k = key & ((1<<cache_bits)-1);
     unsigned int v = ((key>>cache_bits)<<value_bits) | value;
-    values[k] = v;
+    store (k, v);
     return true;
   }
 
   private:
+  /* Local change: each entry is read and written atomically (with relaxed
+   * ordering), so that a cache shared by several threads can't return a
+   * value mixed from concurrent writes. */
+#ifdef __ATOMIC_RELAXED
+  inline unsigned int load (unsigned int k) const { return __atomic_load_n (&values[k], __ATOMIC_RELAXED); }
+  inline void store (unsigned int k, unsigned int v) { __atomic_store_n (&values[k], v, __ATOMIC_RELAXED); }
+#else
+  inline unsigned int load (unsigned int k) const { return ((const volatile unsigned int *) values)[k]; }
+  inline void store (unsigned int k, unsigned int v) { ((volatile unsigned int *) values)[k] = v; }
+#endif
+
   unsigned int values[1<<cache_bits];
 };
 
@@ -57,10 +57,9 @@ struct hb_face_t {
 
   struct hb_shaper_data_t shaper_data;
 
-  struct plan_node_t {
-    hb_shape_plan_t *shape_plan;
-    plan_node_t *next;
-  } *shape_plans;
+  /* Local change: was a linked list, without the user-feature plans
+   * (see hb_shape_plan_create_cached()). */
+  hb_shape_plan_cache_t *shape_plans;
 
 
   inline hb_blob_t *reference_table (hb_tag_t tag) const
@@ -427,6 +427,32 @@ hb_ft_font_create (FT_Face           ft_face,
   return font;
 }
 
+/* Local addition (not part of 0.9.24): same as hb_ft_font_create(), but on
+ * top of an existing hb_face_t, so that several sizes of the same FT_Face can
+ * share their face (hence their shape-plans and layout tables).
+ *
+ * The scale is taken from the currently active FT_Size of ft_face, which must
+ * be activated again (FT_Activate_Size) whenever the returned font is used. */
+hb_font_t *
+hb_ft_font_create_for_face (hb_face_t *face,
+			    FT_Face    ft_face)
+{
+  hb_font_t *font;
+
+  font = hb_font_create (face);
+  hb_font_set_funcs (font,
+		     _hb_ft_get_font_funcs (),
+		     ft_face, (hb_destroy_func_t) _do_nothing);
+  hb_font_set_scale (font,
+		     (int) (((uint64_t) ft_face->size->metrics.x_scale * (uint64_t) ft_face->units_per_EM + (1<<15)) >> 16),
+		     (int) (((uint64_t) ft_face->size->metrics.y_scale * (uint64_t) ft_face->units_per_EM + (1<<15)) >> 16));
+  hb_font_set_ppem (font,
+		    ft_face->size->metrics.x_ppem,
+		    ft_face->size->metrics.y_ppem);
+
+  return font;
+}
+
 
 /* Thread-safe, lock-free, FT_Library */
 
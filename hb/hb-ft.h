@@ -47,6 +47,11 @@ hb_font_t *
 hb_ft_font_create (FT_Face           ft_face,
 		   hb_destroy_func_t destroy);
 
+/* Local addition: see hb-ft.cc */
+hb_font_t *
+hb_ft_font_create_for_face (hb_face_t *face,
+			    FT_Face    ft_face);
+
 
 
 /* Makes an hb_font_t use FreeType internally to implement font functions. */
@@ -59,7 +59,7 @@ struct hmtx
     return TRACE_RETURN (true);
   }
 
-  protected:
+  public: /* Local change: was protected (see README.md) */
   LongHorMetric	longHorMetric[VAR];	/* Paired advance width and left side
 					 * bearing values for each glyph. The
 					 * value numOfHMetrics comes from
@@ -48,6 +48,12 @@ struct hb_shape_plan_t
   struct hb_shaper_data_t shaper_data;
 };
 
+/* Local addition: the per-face cache of hb_shape_plan_create_cached(). */
+struct hb_shape_plan_cache_t;
+
+HB_INTERNAL void
+_hb_shape_plan_cache_destroy (hb_shape_plan_cache_t *cache);
+
 #define HB_SHAPER_DATA_CREATE_FUNC_EXTRA_ARGS \
 	, const hb_feature_t            *user_features \
 	, unsigned int                   num_user_features
@@ -290,32 +290,170 @@ hb_shape_plan_execute (hb_shape_plan_t    *shape_plan,
 
 /*
  * caching
+ *
+ * Local change: the plans are cached per face in a hash table (instead of a
+ * linked list), and the plans with user-features are cached as well.
+ *
+ * - The key is made of the segment properties, the shaper and the user
+ *   features, canonicalized as (tag, value, global) triplets, stably sorted
+ *   by tag: the ranges of the non-global features are not part of the key,
+ *   since they only matter at execution time
+ * - Open addressing with linear probing, over a fixed number of slots: the
+ *   entries are immutable and are only inserted (via compare-and-swap), until
+ *   the face is destroyed, i.e. the lookups are lock-free
+ * - Bounded: beyond HB_SHAPE_PLAN_CACHE_MAX_ENTRIES (or with more than
+ *   HB_SHAPE_PLAN_CACHE_MAX_FEATURES user-features), the plans are not cached
  */
 
-#if 0
-static unsigned int
-hb_shape_plan_hash (const hb_shape_plan_t *shape_plan)
+#define HB_SHAPE_PLAN_CACHE_SLOTS		128 /* Power of two. */
+#define HB_SHAPE_PLAN_CACHE_MAX_ENTRIES		96 /* Keeps free slots for terminating the probes. */
+#define HB_SHAPE_PLAN_CACHE_MAX_FEATURES	32
+
+struct hb_shape_plan_feature_t
+{
+  hb_tag_t tag;
+  uint32_t value;
+  hb_bool_t global;
+};
+
+struct hb_shape_plan_entry_t
 {
-  return hb_segment_properties_hash (&shape_plan->props) +
-	 shape_plan->default_shaper_list ? 0 : (intptr_t) shape_plan->shaper_func;
+  unsigned int hash;
+  hb_segment_properties_t props;
+  hb_bool_t default_shaper_list;
+  hb_shape_func_t *shaper_func;
+  unsigned int num_features;
+  hb_shape_plan_feature_t *features; /* Allocated with the entry. */
+
+  hb_shape_plan_t *shape_plan;
+};
+
+struct hb_shape_plan_cache_t
+{
+  hb_atomic_int_t num_entries;
+  hb_shape_plan_entry_t *slots[HB_SHAPE_PLAN_CACHE_SLOTS];
+};
+
+void
+_hb_shape_plan_cache_destroy (hb_shape_plan_cache_t *cache)
+{
+  if (!cache)
+    return;
+
+  for (unsigned int i = 0; i < HB_SHAPE_PLAN_CACHE_SLOTS; i++)
+    if (cache->slots[i])
+    {
+      hb_shape_plan_destroy (cache->slots[i]->shape_plan);
+      free (cache->slots[i]);
+    }
+
+  free (cache);
 }
-#endif
 
-/* TODO no user-feature caching for now. */
 struct hb_shape_plan_proposal_t
 {
   const hb_segment_properties_t  props;
   const char * const            *shaper_list;
   hb_shape_func_t               *shaper_func;
+
+  unsigned int                   num_features;
+  hb_shape_plan_feature_t        features[HB_SHAPE_PLAN_CACHE_MAX_FEATURES];
+  unsigned int                   hash;
 };
 
+static void
+hb_shape_plan_proposal_set_features (hb_shape_plan_proposal_t *proposal,
+				     const hb_feature_t       *user_features,
+				     unsigned int              num_user_features)
+{
+  /* Insertion sort: stable, and the lists are short. */
+  proposal->num_features = num_user_features;
+  for (unsigned int i = 0; i < num_user_features; i++)
+  {
+    hb_shape_plan_feature_t feature = {
+      user_features[i].tag,
+      user_features[i].value,
+      user_features[i].start == 0 && user_features[i].end == (unsigned int) -1
+    };
+
+    unsigned int j = i;
+    for (; j > 0 && proposal->features[j - 1].tag > feature.tag; j--)
+      proposal->features[j] = proposal->features[j - 1];
+    proposal->features[j] = feature;
+  }
+}
+
+static unsigned int
+hb_shape_plan_proposal_hash (const hb_shape_plan_proposal_t *proposal)
+{
+  unsigned int hash = hb_segment_properties_hash (&proposal->props);
+  if (proposal->shaper_list)
+    hash = hash * 31 + (unsigned int) (intptr_t) proposal->shaper_func;
+  for (unsigned int i = 0; i < proposal->num_features; i++)
+  {
+    const hb_shape_plan_feature_t &feature = proposal->features[i];
+    hash = hash * 31 + feature.tag;
+    hash = hash * 31 + feature.value;
+    hash = hash * 2 + feature.global;
+  }
+  /* Final mix, since the low bits select the slot. */
+  hash ^= hash >> 16;
+  hash *= 0x85EBCA6Bu;
+  hash ^= hash >> 13;
+  return hash;
+}
+
 static hb_bool_t
-hb_shape_plan_matches (const hb_shape_plan_t          *shape_plan,
+hb_shape_plan_matches (const hb_shape_plan_entry_t    *entry,
 		       const hb_shape_plan_proposal_t *proposal)
 {
-  return hb_segment_properties_equal (&shape_plan->props, &proposal->props) &&
-	 ((shape_plan->default_shaper_list && proposal->shaper_list == NULL) ||
-	  (shape_plan->shaper_func == proposal->shaper_func));
+  return entry->hash == proposal->hash &&
+	 hb_segment_properties_equal (&entry->props, &proposal->props) &&
+	 ((entry->default_shaper_list && proposal->shaper_list == NULL) ||
+	  (entry->shaper_func == proposal->shaper_func)) &&
+	 entry->num_features == proposal->num_features &&
+	 0 == memcmp (entry->features, proposal->features, proposal->num_features * sizeof (proposal->features[0]));
+}
+
+static hb_shape_plan_cache_t *
+hb_shape_plan_cache_ensure (hb_face_t *face)
+{
+retry:
+  hb_shape_plan_cache_t *cache = (hb_shape_plan_cache_t *) hb_atomic_ptr_get (&face->shape_plans);
+  if (unlikely (!cache))
+  {
+    cache = (hb_shape_plan_cache_t *) calloc (1, sizeof (hb_shape_plan_cache_t));
+    if (unlikely (!cache))
+      return NULL;
+
+    if (!hb_atomic_ptr_cmpexch (&face->shape_plans, NULL, cache)) {
+      free (cache);
+      goto retry;
+    }
+  }
+  return cache;
+}
+
+/* Returns the matching entry, or the first free slot (NULL if none). */
+static hb_shape_plan_entry_t *
+hb_shape_plan_cache_lookup (hb_shape_plan_cache_t           *cache,
+			    const hb_shape_plan_proposal_t  *proposal,
+			    hb_shape_plan_entry_t         ***free_slot)
+{
+  *free_slot = NULL;
+  for (unsigned int i = 0; i < HB_SHAPE_PLAN_CACHE_SLOTS; i++)
+  {
+    hb_shape_plan_entry_t **slot = &cache->slots[(proposal->hash + i) & (HB_SHAPE_PLAN_CACHE_SLOTS - 1)];
+    hb_shape_plan_entry_t *entry = (hb_shape_plan_entry_t *) hb_atomic_ptr_get (slot);
+    if (!entry)
+    {
+      *free_slot = slot;
+      return NULL;
+    }
+    if (hb_shape_plan_matches (entry, proposal))
+      return entry;
+  }
+  return NULL;
 }
 
 /**
@@ -339,7 +477,7 @@ hb_shape_plan_create_cached (hb_face_t                     *face,
 			     unsigned int                   num_user_features,
 			     const char * const            *shaper_list)
 {
-  if (num_user_features)
+  if (unlikely (num_user_features > HB_SHAPE_PLAN_CACHE_MAX_FEATURES || hb_object_is_inert (face)))
     return hb_shape_plan_create (face, props, user_features, num_user_features, shaper_list);
 
   hb_shape_plan_proposal_t proposal = {
@@ -371,28 +509,51 @@ hb_shape_plan_create_cached (hb_face_t                     *face,
       return hb_shape_plan_get_empty ();
   }
 
+  hb_shape_plan_proposal_set_features (&proposal, user_features, num_user_features);
+  proposal.hash = hb_shape_plan_proposal_hash (&proposal);
 
-retry:
-  hb_face_t::plan_node_t *cached_plan_nodes = (hb_face_t::plan_node_t *) hb_atomic_ptr_get (&face->shape_plans);
-  for (hb_face_t::plan_node_t *node = cached_plan_nodes; node; node = node->next)
-    if (hb_shape_plan_matches (node->shape_plan, &proposal))
-      return hb_shape_plan_reference (node->shape_plan);
+  hb_shape_plan_cache_t *cache = hb_shape_plan_cache_ensure (face);
+  if (unlikely (!cache))
+    return hb_shape_plan_create (face, props, user_features, num_user_features, shaper_list);
+
+  hb_shape_plan_entry_t **free_slot;
+  hb_shape_plan_entry_t *found = hb_shape_plan_cache_lookup (cache, &proposal, &free_slot);
+  if (found)
+    return hb_shape_plan_reference (found->shape_plan);
 
   /* Not found. */
 
   hb_shape_plan_t *shape_plan = hb_shape_plan_create (face, props, user_features, num_user_features, shaper_list);
 
-  hb_face_t::plan_node_t *node = (hb_face_t::plan_node_t *) calloc (1, sizeof (hb_face_t::plan_node_t));
-  if (unlikely (!node))
-    return shape_plan;
+  if (!free_slot || hb_atomic_int_add (cache->num_entries, 1) >= HB_SHAPE_PLAN_CACHE_MAX_ENTRIES)
+    return shape_plan; /* Full: the entry counter is never decremented, keeping further attempts cheap. */
 
-  node->shape_plan = shape_plan;
-  node->next = cached_plan_nodes;
+  hb_shape_plan_entry_t *entry = (hb_shape_plan_entry_t *) calloc (1, sizeof (hb_shape_plan_entry_t) + proposal.num_features * sizeof (hb_shape_plan_feature_t));
+  if (unlikely (!entry))
+    return shape_plan;
 
-  if (!hb_atomic_ptr_cmpexch (&face->shape_plans, cached_plan_nodes, node)) {
-    hb_shape_plan_destroy (shape_plan);
-    free (node);
-    goto retry;
+  entry->hash = proposal.hash;
+  entry->props = proposal.props;
+  entry->default_shaper_list = shaper_list == NULL;
+  entry->shaper_func = shape_plan->shaper_func;
+  entry->num_features = proposal.num_features;
+  entry->features = (hb_shape_plan_feature_t *) (entry + 1);
+  memcpy (entry->features, proposal.features, proposal.num_features * sizeof (proposal.features[0]));
+  entry->shape_plan = shape_plan;
+
+  while (!hb_atomic_ptr_cmpexch (free_slot, NULL, entry))
+  {
+    /* Another thread took the slot: it may have inserted the same plan. */
+    found = hb_shape_plan_cache_lookup (cache, &proposal, &free_slot);
+    if (found || !free_slot)
+    {
+      free (entry);
+      if (found) {
+	hb_shape_plan_destroy (shape_plan);
+	return hb_shape_plan_reference (found->shape_plan);
+      }
+      return shape_plan;
+    }
   }
 
   /* Release our reference on face. */